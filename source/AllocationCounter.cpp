@@ -0,0 +1,120 @@
+//=======================================================================
+// Author: Donovan Parks
+//
+// Copyright 2011 Donovan Parks
+//
+// This file is part of ExpressBetaDiversity.
+//
+// ExpressBetaDiversity is free software: you can redistribute it 
+// and/or modify it under the terms of the GNU General Public License 
+// as published by the Free Software Foundation, either version 3 of 
+// the License, or (at your option) any later version.
+//
+// ExpressBetaDiversity is distributed in the hope that it will be 
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ExpressBetaDiversity. If not, see 
+// <http://www.gnu.org/licenses/>.
+//=======================================================================
+
+#include "Precompiled.hpp"
+
+#include "AllocationCounter.hpp"
+
+#include <new>
+#include <cstdlib>
+
+// number of allocations made by each thread
+static uint64 numAllocations = 0;
+#pragma omp threadprivate(numAllocations)
+
+uint64 AllocationCounter::GetCount()
+{
+	return numAllocations;
+}
+
+// Replace the global allocation functions so every allocation is counted. All replaceable forms are 
+// defined so memory is always allocated and freed by the same functions.
+void* operator new(std::size_t size)
+{
+	++numAllocations;
+
+	if(size == 0)
+		size = 1;
+
+	// as required of operator new, call the new handler until it frees enough memory or gives up
+	for(;;)
+	{
+		void* p = malloc(size);
+		if(p != NULL)
+			return p;
+
+#if __cplusplus >= 201103L
+		std::new_handler handler = std::get_new_handler();
+#else
+		std::new_handler handler = std::set_new_handler(NULL);
+		std::set_new_handler(handler);
+#endif
+		if(handler == NULL)
+			throw std::bad_alloc();
+
+		handler();
+	}
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) throw()
+{
+	try
+	{
+		return operator new(size);
+	}
+	catch(const std::bad_alloc&)
+	{
+		return NULL;
+	}
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) throw()
+{
+	return operator new(size, std::nothrow);
+}
+
+void operator delete(void* p) throw()
+{
+	free(p);
+}
+
+void operator delete[](void* p) throw()
+{
+	free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) throw()
+{
+	free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) throw()
+{
+	free(p);
+}
+
+#ifdef __cpp_sized_deallocation
+void operator delete(void* p, std::size_t) throw()
+{
+	free(p);
+}
+
+void operator delete[](void* p, std::size_t) throw()
+{
+	free(p);
+}
+#endif
@@ -0,0 +1,381 @@
+//=======================================================================
+// Author: Donovan Parks
+//
+// Copyright 2011 Donovan Parks
+//
+// This file is part of ExpressBetaDiversity.
+//
+// ExpressBetaDiversity is free software: you can redistribute it 
+// and/or modify it under the terms of the GNU General Public License 
+// as published by the Free Software Foundation, either version 3 of 
+// the License, or (at your option) any later version.
+//
+// ExpressBetaDiversity is distributed in the hope that it will be 
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ExpressBetaDiversity. If not, see 
+// <http://www.gnu.org/licenses/>.
+//=======================================================================
+
+#include "Precompiled.hpp"
+
+#include "BgzfFile.hpp"
+
+#include <zlib.h>
+
+// Layout of a BGZF block (all integers are little-endian):
+//
+//   gzip header: 31, 139, 8 (deflate), 4 (FEXTRA), MTIME (4 bytes), XFL, OS, XLEN (2 bytes)
+//   extra subfields (XLEN bytes), including 'B', 'C', SLEN = 2, BSIZE (2 bytes) = block size - 1
+//   raw deflate data
+//   CRC32 (4 bytes), ISIZE (4 bytes) = size of uncompressed data
+//
+// A file ends with an empty block.
+
+const uint BgzfFile::MAX_BLOCK_SIZE = 65536;
+const uint BgzfFile::BLOCK_DATA_SIZE = 0xff00;
+const uint BgzfFile::COMPRESS_BATCH_SIZE = 256;
+
+static const uint GZIP_HEADER_SIZE = 12;
+static const uint BGZF_HEADER_SIZE = 18;
+static const uint GZIP_FOOTER_SIZE = 8;
+
+static const unsigned char BGZF_EOF_BLOCK[28] = { 31, 139, 8, 4, 0, 0, 0, 0, 0, 255, 6, 0, 'B', 'C', 2, 0, 27, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+BgzfFile::BgzfFile()
+	: m_cacheFirstBlock(0), m_cacheNumBlocks(0)
+{
+	m_blockStarts.push_back(0);
+}
+
+BgzfFile::~BgzfFile()
+{
+	Close();
+}
+
+bool BgzfFile::Open(const std::string& filename)
+{
+	Close();
+
+	m_file.open(filename.c_str(), std::ios::in | std::ios::binary);
+	if(!m_file.is_open())
+		return false;
+
+	// determine offset of each block from its header and footer
+	uint64 offset = 0;
+	unsigned char header[GZIP_HEADER_SIZE + 0xffff];
+	while(true)
+	{
+		m_file.seekg((std::streamoff)offset);
+		m_file.read((char*)header, GZIP_HEADER_SIZE);
+		if(m_file.gcount() == 0)
+			break;
+
+		uint headerSize = GZIP_HEADER_SIZE;
+		if(m_file.gcount() == GZIP_HEADER_SIZE)
+		{
+			headerSize += ReadLittleEndian(&header[10], 2);
+			m_file.read((char*)&header[GZIP_HEADER_SIZE], headerSize - GZIP_HEADER_SIZE);
+		}
+
+		uint blockSize;
+		if(!m_file.good() || !ParseHeader(header, headerSize, headerSize, blockSize))
+		{
+			Close();
+			return false;
+		}
+
+		unsigned char footer[GZIP_FOOTER_SIZE];
+		m_file.seekg((std::streamoff)(offset + blockSize - GZIP_FOOTER_SIZE));
+		m_file.read((char*)footer, GZIP_FOOTER_SIZE);
+		if(!m_file.good())
+		{
+			Close();
+			return false;
+		}
+
+		uint dataSize = ReadLittleEndian(&footer[4], 4);
+		if(dataSize > MAX_BLOCK_SIZE)
+		{
+			Close();
+			return false;
+		}
+
+		if(dataSize > 0)
+		{
+			m_blockOffsets.push_back(offset);
+			m_blockSizes.push_back(blockSize);
+			m_blockStarts.push_back(m_blockStarts.back() + dataSize);
+		}
+
+		offset += blockSize;
+	}
+
+	m_file.clear();
+
+	return true;
+}
+
+void BgzfFile::Close()
+{
+	if(m_file.is_open())
+		m_file.close();
+	m_file.clear();
+
+	m_blockOffsets.clear();
+	m_blockSizes.clear();
+	m_blockStarts.assign(1, 0);
+
+	m_cache.clear();
+	m_cacheFirstBlock = 0;
+	m_cacheNumBlocks = 0;
+}
+
+bool BgzfFile::IsBgzfFile(const std::string& filename)
+{
+	std::ifstream fin(filename.c_str(), std::ios::in | std::ios::binary);
+	if(!fin.is_open())
+		return false;
+
+	unsigned char header[BGZF_HEADER_SIZE];
+	fin.read((char*)header, BGZF_HEADER_SIZE);
+	if(fin.gcount() != BGZF_HEADER_SIZE)
+		return false;
+
+	// the BC subfield is normally the only extra subfield
+	uint headerSize, blockSize;
+	return ParseHeader(header, BGZF_HEADER_SIZE, headerSize, blockSize);
+}
+
+bool BgzfFile::IsGzipFile(const std::string& filename)
+{
+	std::ifstream fin(filename.c_str(), std::ios::in | std::ios::binary);
+	if(!fin.is_open())
+		return false;
+
+	unsigned char magic[2];
+	fin.read((char*)magic, 2);
+
+	return fin.gcount() == 2 && magic[0] == 31 && magic[1] == 139;
+}
+
+bool BgzfFile::ParseHeader(const unsigned char* header, size_t size, uint& headerSize, uint& blockSize)
+{
+	if(size < GZIP_HEADER_SIZE || header[0] != 31 || header[1] != 139 || header[2] != 8 || !(header[3] & 4))
+		return false;
+
+	headerSize = GZIP_HEADER_SIZE + ReadLittleEndian(&header[10], 2);
+	if(headerSize > size)
+		return false;
+
+	// find BC subfield giving size of block
+	uint pos = GZIP_HEADER_SIZE;
+	while(pos + 4 <= headerSize)
+	{
+		uint subfieldSize = ReadLittleEndian(&header[pos+2], 2);
+		if(header[pos] == 'B' && header[pos+1] == 'C' && subfieldSize == 2 && pos + 6 <= headerSize)
+		{
+			blockSize = ReadLittleEndian(&header[pos+4], 2) + 1;
+			return blockSize >= headerSize + GZIP_FOOTER_SIZE;
+		}
+
+		pos += 4 + subfieldSize;
+	}
+
+	return false;
+}
+
+bool BgzfFile::ReadBlocks(uint firstBlock, uint numBlocks, std::vector<char>& data)
+{
+	if(numBlocks == 0)
+		return true;
+
+	// read compressed data of all blocks at once
+	uint lastBlock = firstBlock + numBlocks - 1;
+	uint64 compressedStart = m_blockOffsets[firstBlock];
+	uint64 compressedEnd = m_blockOffsets[lastBlock] + m_blockSizes[lastBlock];
+	m_compressed.resize((size_t)(compressedEnd - compressedStart));
+
+	m_file.seekg((std::streamoff)compressedStart);
+	m_file.read(&m_compressed[0], m_compressed.size());
+	if(!m_file.good())
+	{
+		m_file.clear();
+		return false;
+	}
+
+	size_t dataStart = data.size();
+	data.resize(dataStart + (size_t)(m_blockStarts[firstBlock+numBlocks] - m_blockStarts[firstBlock]));
+
+	// blocks are independent so can be decompressed in parallel
+	bool bGood = true;
+	#pragma omp parallel for schedule(dynamic) reduction(&&:bGood) if(numBlocks > 1)
+	for(int i = 0; i < (int)numBlocks; ++i)
+	{
+		uint block = firstBlock + i;
+		const char* compressed = &m_compressed[(size_t)(m_blockOffsets[block] - compressedStart)];
+		char* uncompressed = &data[dataStart + (size_t)(m_blockStarts[block] - m_blockStarts[firstBlock])];
+		uint dataSize = (uint)(m_blockStarts[block+1] - m_blockStarts[block]);
+		bGood = InflateBlock(compressed, m_blockSizes[block], uncompressed, dataSize) && bGood;
+	}
+
+	return bGood;
+}
+
+size_t BgzfFile::Read(uint64 offset, char* buffer, size_t size)
+{
+	if(offset >= GetSize() || size == 0)
+		return 0;
+
+	size = (size_t)std::min<uint64>(size, GetSize() - offset);
+
+	// find blocks containing requested data
+	uint firstBlock = std::upper_bound(m_blockStarts.begin(), m_blockStarts.end(), offset) - m_blockStarts.begin() - 1;
+	uint lastBlock = std::upper_bound(m_blockStarts.begin(), m_blockStarts.end(), offset + size - 1) - m_blockStarts.begin() - 1;
+
+	if(firstBlock < m_cacheFirstBlock || lastBlock >= m_cacheFirstBlock + m_cacheNumBlocks)
+	{
+		m_cache.clear();
+		m_cacheNumBlocks = 0;
+		if(!ReadBlocks(firstBlock, lastBlock - firstBlock + 1, m_cache))
+			return 0;
+
+		m_cacheFirstBlock = firstBlock;
+		m_cacheNumBlocks = lastBlock - firstBlock + 1;
+	}
+
+	memcpy(buffer, &m_cache[(size_t)(offset - m_blockStarts[m_cacheFirstBlock])], size);
+
+	return size;
+}
+
+bool BgzfFile::InflateBlock(const char* block, uint blockSize, char* data, uint dataSize)
+{
+	uint headerSize, parsedBlockSize;
+	if(!ParseHeader((const unsigned char*)block, blockSize, headerSize, parsedBlockSize) || parsedBlockSize != blockSize)
+		return false;
+
+	z_stream stream;
+	memset(&stream, 0, sizeof(stream));
+	if(inflateInit2(&stream, -MAX_WBITS) != Z_OK)	// raw deflate data
+		return false;
+
+	stream.next_in = (Bytef*)(block + headerSize);
+	stream.avail_in = blockSize - headerSize - GZIP_FOOTER_SIZE;
+	stream.next_out = (Bytef*)data;
+	stream.avail_out = dataSize;
+
+	int status = inflate(&stream, Z_FINISH);
+	bool bGood = (status == Z_STREAM_END && stream.total_out == dataSize);
+	inflateEnd(&stream);
+
+	const unsigned char* footer = (const unsigned char*)(block + blockSize - GZIP_FOOTER_SIZE);
+	return bGood && crc32(crc32(0L, Z_NULL, 0), (const Bytef*)data, dataSize) == ReadLittleEndian(footer, 4);
+}
+
+uint BgzfFile::DeflateBlock(const char* data, uint dataSize, char* block)
+{
+	z_stream stream;
+	memset(&stream, 0, sizeof(stream));
+	if(deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		return 0;
+
+	stream.next_in = (Bytef*)data;
+	stream.avail_in = dataSize;
+	stream.next_out = (Bytef*)(block + BGZF_HEADER_SIZE);
+	stream.avail_out = MAX_BLOCK_SIZE - BGZF_HEADER_SIZE - GZIP_FOOTER_SIZE;
+
+	int status = deflate(&stream, Z_FINISH);
+	uint compressedSize = stream.total_out;
+	deflateEnd(&stream);
+
+	if(status != Z_STREAM_END)
+		return 0;	// data did not fit in a block
+
+	uint blockSize = BGZF_HEADER_SIZE + compressedSize + GZIP_FOOTER_SIZE;
+
+	unsigned char* header = (unsigned char*)block;
+	memcpy(header, BGZF_EOF_BLOCK, BGZF_HEADER_SIZE);
+	WriteLittleEndian(&header[16], blockSize - 1, 2);
+
+	unsigned char* footer = (unsigned char*)(block + blockSize - GZIP_FOOTER_SIZE);
+	WriteLittleEndian(footer, crc32(crc32(0L, Z_NULL, 0), (const Bytef*)data, dataSize), 4);
+	WriteLittleEndian(&footer[4], dataSize, 4);
+
+	return blockSize;
+}
+
+bool BgzfFile::Compress(const std::string& inputFile, const std::string& outputFile)
+{
+	std::ifstream fin(inputFile.c_str(), std::ios::in | std::ios::binary);
+	if(!fin.is_open())
+	{
+		std::cerr << "Unable to open file: " << inputFile << std::endl;
+		return false;
+	}
+
+	std::ofstream fout(outputFile.c_str(), std::ios::out | std::ios::binary);
+	if(!fout.is_open())
+	{
+		std::cerr << "Unable to create file: " << outputFile << std::endl;
+		return false;
+	}
+
+	// read a batch of blocks at a time and compress them in parallel
+	std::vector<char> data((size_t)COMPRESS_BATCH_SIZE * BLOCK_DATA_SIZE);
+	std::vector<char> blocks((size_t)COMPRESS_BATCH_SIZE * MAX_BLOCK_SIZE);
+	std::vector<uint> blockSizes(COMPRESS_BATCH_SIZE);
+	while(fin.good())
+	{
+		fin.read(&data[0], data.size());
+		size_t dataSize = (size_t)fin.gcount();
+		int numBlocks = (int)((dataSize + BLOCK_DATA_SIZE - 1) / BLOCK_DATA_SIZE);
+
+		bool bGood = true;
+		#pragma omp parallel for schedule(dynamic) reduction(&&:bGood) if(numBlocks > 1)
+		for(int i = 0; i < numBlocks; ++i)
+		{
+			size_t blockStart = (size_t)i * BLOCK_DATA_SIZE;
+			uint blockDataSize = (uint)std::min<size_t>(BLOCK_DATA_SIZE, dataSize - blockStart);
+			blockSizes[i] = DeflateBlock(&data[blockStart], blockDataSize, &blocks[(size_t)i * MAX_BLOCK_SIZE]);
+			bGood = (blockSizes[i] > 0) && bGood;
+		}
+
+		if(!bGood)
+		{
+			std::cerr << "Unable to compress file: " << inputFile << std::endl;
+			return false;
+		}
+
+		for(int i = 0; i < numBlocks; ++i)
+			fout.write(&blocks[(size_t)i * MAX_BLOCK_SIZE], blockSizes[i]);
+	}
+
+	fout.write((const char*)BGZF_EOF_BLOCK, sizeof(BGZF_EOF_BLOCK));
+
+	if(!fout.good())
+	{
+		std::cerr << "Unable to write file: " << outputFile << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+uint BgzfFile::ReadLittleEndian(const unsigned char* bytes, uint numBytes)
+{
+	uint value = 0;
+	for(uint i = 0; i < numBytes; ++i)
+		value |= (uint)bytes[i] << (8*i);
+
+	return value;
+}
+
+void BgzfFile::WriteLittleEndian(unsigned char* bytes, uint value, uint numBytes)
+{
+	for(uint i = 0; i < numBytes; ++i)
+		bytes[i] = (unsigned char)(value >> (8*i));
+}
@@ -0,0 +1,156 @@
+//=======================================================================
+// Author: Donovan Parks
+//
+// Copyright 2011 Donovan Parks
+//
+// This file is part of ExpressBetaDiversity.
+//
+// ExpressBetaDiversity is free software: you can redistribute it 
+// and/or modify it under the terms of the GNU General Public License 
+// as published by the Free Software Foundation, either version 3 of 
+// the License, or (at your option) any later version.
+//
+// ExpressBetaDiversity is distributed in the hope that it will be 
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ExpressBetaDiversity. If not, see 
+// <http://www.gnu.org/licenses/>.
+//=======================================================================
+
+#ifndef _BGZF_FILE_
+#define _BGZF_FILE_
+
+#include "Precompiled.hpp"
+
+/**
+ * @brief Random access to a file compressed in independent blocks (BGZF).
+ *
+ * A BGZF file is a series of gzip members, each holding at most 64 KB of 
+ * uncompressed data, so it can also be decompressed with gzip. The offset of 
+ * each block in the compressed and uncompressed file is determined when the 
+ * file is opened, allowing any range of the uncompressed file to be read by 
+ * decompressing only the blocks that contain it.
+ */
+class BgzfFile
+{
+public:
+	/** Constructor. */
+	BgzfFile();
+
+	/** Destructor. */
+	~BgzfFile();
+
+	/**
+	* @brief Open file and determine the offset of each block.
+	*
+	* @param filename Path to BGZF file.
+	* @return True if file opened successfully, else false.
+	*/
+	bool Open(const std::string& filename);
+
+	/** Close file. */
+	void Close();
+
+	/** Check if a file is currently open. */
+	bool IsOpen() const { return m_file.is_open(); }
+
+	/** Get size of uncompressed file in bytes. */
+	uint64 GetSize() const { return m_blockStarts.back(); }
+
+	/** Get number of non-empty blocks. */
+	uint GetNumBlocks() const { return m_blockOffsets.size(); }
+
+	/**
+	* @brief Decompress consecutive blocks using multiple threads.
+	*
+	* @param firstBlock Index of first block to decompress.
+	* @param numBlocks Number of blocks to decompress.
+	* @param data Vector the uncompressed data is appended to.
+	* @return True if blocks decompressed successfully, else false.
+	*/
+	bool ReadBlocks(uint firstBlock, uint numBlocks, std::vector<char>& data);
+
+	/**
+	* @brief Read data from the uncompressed file.
+	*
+	* @param offset Offset in the uncompressed file.
+	* @param buffer Buffer to copy data into.
+	* @param size Number of bytes to read.
+	* @return Number of bytes read.
+	*/
+	size_t Read(uint64 offset, char* buffer, size_t size);
+
+	/** Check if file starts with a BGZF block. */
+	static bool IsBgzfFile(const std::string& filename);
+
+	/** Check if file starts with a gzip header (which may or may not be a BGZF block). */
+	static bool IsGzipFile(const std::string& filename);
+
+	/**
+	* @brief Compress a file into BGZF format using multiple threads.
+	*
+	* @param inputFile Path to file to compress.
+	* @param outputFile Path to BGZF file.
+	* @return True if file compressed successfully, else false.
+	*/
+	static bool Compress(const std::string& inputFile, const std::string& outputFile);
+
+	/** Maximum size of a block in bytes (compressed or uncompressed). */
+	static const uint MAX_BLOCK_SIZE;
+
+private:
+	/** Disallow copying as the file stream is owned by this object. */
+	BgzfFile(const BgzfFile& rhs);
+	BgzfFile& operator=(const BgzfFile& rhs);
+
+	/** Get size of gzip header and of the entire block from the header of a BGZF block. */
+	static bool ParseHeader(const unsigned char* header, size_t size, uint& headerSize, uint& blockSize);
+
+	/** Decompress a single block. */
+	static bool InflateBlock(const char* block, uint blockSize, char* data, uint dataSize);
+
+	/** Compress data into a single block and return size of block (0 on failure). */
+	static uint DeflateBlock(const char* data, uint dataSize, char* block);
+
+	/** Read an unsigned little-endian integer of the specified number of bytes. */
+	static uint ReadLittleEndian(const unsigned char* bytes, uint numBytes);
+
+	/** Write an unsigned little-endian integer of the specified number of bytes. */
+	static void WriteLittleEndian(unsigned char* bytes, uint value, uint numBytes);
+
+private:
+	/** File stream. */
+	std::ifstream m_file;
+
+	/** Offset of each block in the compressed file. */
+	std::vector<uint64> m_blockOffsets;
+
+	/** Size of each block in the compressed file. */
+	std::vector<uint> m_blockSizes;
+
+	/** Offset of each block in the uncompressed file, followed by the size of the uncompressed file. */
+	std::vector<uint64> m_blockStarts;
+
+	/** Compressed data read from file. */
+	std::vector<char> m_compressed;
+
+	/** Uncompressed data of the most recently read blocks. */
+	std::vector<char> m_cache;
+
+	/** First block in cache. */
+	uint m_cacheFirstBlock;
+
+	/** Number of blocks in cache. */
+	uint m_cacheNumBlocks;
+
+	/** Uncompressed data written to each block by Compress(). */
+	static const uint BLOCK_DATA_SIZE;
+
+	/** Number of blocks compressed at once by Compress(). */
+	static const uint COMPRESS_BATCH_SIZE;
+};
+
+#endif
@@ -0,0 +1,426 @@
+//=======================================================================
+// Author: Donovan Parks
+//
+// Copyright 2011 Donovan Parks
+//
+// This file is part of ExpressBetaDiversity.
+//
+// ExpressBetaDiversity is free software: you can redistribute it 
+// and/or modify it under the terms of the GNU General Public License 
+// as published by the Free Software Foundation, either version 3 of 
+// the License, or (at your option) any later version.
+//
+// ExpressBetaDiversity is distributed in the hope that it will be 
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ExpressBetaDiversity. If not, see 
+// <http://www.gnu.org/licenses/>.
+//=======================================================================
+
+#include "Precompiled.hpp"
+
+#include "BiomIO.hpp"
+#include "MemoryMappedFile.hpp"
+#include "BgzfFile.hpp"
+
+bool BiomIO::IsBiomFile(const std::string& filename)
+{
+	// compressed BIOM files are not supported
+	if(BgzfFile::IsGzipFile(filename))
+		return false;
+
+	std::ifstream fin(filename.c_str(), std::ios::in | std::ios::binary);
+	if(!fin.is_open())
+		return false;
+
+	// BIOM (JSON) files consist of a single object
+	char c;
+	while(fin.get(c))
+	{
+		if(!isspace((unsigned char)c))
+			return c == '{';
+	}
+
+	return false;
+}
+
+bool BiomIO::Read(const std::string& filename)
+{
+	m_observations.clear();
+	m_samples.clear();
+	m_entrySamples.clear();
+	m_entryObservations.clear();
+	m_entryValues.clear();
+
+	MemoryMappedFile file;
+	if(!file.Open(filename))
+	{
+		std::cerr << "Unable to open BIOM file: " << filename << std::endl;
+		return false;
+	}
+
+	const char* pos = file.GetData();
+	const char* end = pos + file.GetSize();
+
+	// keys of the table object may be in any order so first find the start of the 
+	// values of interest and the type of matrix
+	const char* rowsPos = NULL;
+	const char* columnsPos = NULL;
+	const char* dataPos = NULL;
+	std::string matrixType;
+
+	bool bValid = Expect(pos, end, '{');
+	SkipWhiteSpace(pos, end);
+	bool bEmpty = (pos < end && *pos == '}');
+	while(bValid && !bEmpty)
+	{
+		std::string key;
+		if(!ParseString(pos, end, key) || !Expect(pos, end, ':'))
+		{
+			bValid = false;
+			break;
+		}
+
+		SkipWhiteSpace(pos, end);
+		if(key == "rows")
+			rowsPos = pos;
+		else if(key == "columns")
+			columnsPos = pos;
+		else if(key == "data")
+			dataPos = pos;
+
+		if(key == "matrix_type")
+			bValid = ParseString(pos, end, matrixType);
+		else
+			bValid = SkipValue(pos, end);
+
+		SkipWhiteSpace(pos, end);
+		if(pos < end && *pos == ',')
+			++pos;
+		else
+		{
+			bValid = bValid && Expect(pos, end, '}');
+			break;
+		}
+	}
+
+	if(!bValid || rowsPos == NULL || columnsPos == NULL || dataPos == NULL)
+	{
+		std::cerr << "Invalid BIOM file: " << filename << std::endl;
+		return false;
+	}
+
+	if(matrixType != "sparse" && matrixType != "dense")
+	{
+		std::cerr << "Unsupported BIOM matrix type '" << matrixType << "' in: " << filename << std::endl;
+		return false;
+	}
+
+	// parse table
+	bValid = ParseIds(rowsPos, end, m_observations) && ParseIds(columnsPos, end, m_samples);
+	if(bValid)
+	{
+		if(matrixType == "sparse")
+			bValid = ParseSparseData(dataPos, end);
+		else
+			bValid = ParseDenseData(dataPos, end);
+	}
+
+	if(!bValid)
+	{
+		std::cerr << "Invalid BIOM file: " << filename << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+void BiomIO::SkipWhiteSpace(const char*& pos, const char* end)
+{
+	while(pos < end && isspace((unsigned char)*pos))
+		++pos;
+}
+
+bool BiomIO::Expect(const char*& pos, const char* end, char c)
+{
+	SkipWhiteSpace(pos, end);
+	if(pos >= end || *pos != c)
+		return false;
+
+	++pos;
+	return true;
+}
+
+bool BiomIO::ParseString(const char*& pos, const char* end, std::string& str)
+{
+	str.clear();
+	if(!Expect(pos, end, '"'))
+		return false;
+
+	while(pos < end && *pos != '"')
+	{
+		if(*pos != '\\')
+		{
+			str += *pos++;
+			continue;
+		}
+
+		// escape sequence
+		if(++pos >= end)
+			return false;
+
+		switch(*pos)
+		{
+		case 'b': str += '\b'; break;
+		case 'f': str += '\f'; break;
+		case 'n': str += '\n'; break;
+		case 'r': str += '\r'; break;
+		case 't': str += '\t'; break;
+		case 'u':
+			{
+				if(end - pos < 5)
+					return false;
+
+				uint code = strtoul(std::string(pos+1, pos+5).c_str(), NULL, 16);
+				if(code < 0x80)
+					str += (char)code;
+				else if(code < 0x800)
+				{
+					str += (char)(0xC0 | (code >> 6));
+					str += (char)(0x80 | (code & 0x3F));
+				}
+				else
+				{
+					str += (char)(0xE0 | (code >> 12));
+					str += (char)(0x80 | ((code >> 6) & 0x3F));
+					str += (char)(0x80 | (code & 0x3F));
+				}
+
+				pos += 4;
+			}
+			break;
+		default: str += *pos; break;
+		}
+
+		++pos;
+	}
+
+	if(pos >= end)
+		return false;
+
+	++pos;	// closing quote
+	return true;
+}
+
+bool BiomIO::ParseNumber(const char*& pos, const char* end, double& value)
+{
+	SkipWhiteSpace(pos, end);
+
+	char token[64];
+	uint len = 0;
+	while(pos < end && len < sizeof(token)-1 && (isdigit((unsigned char)*pos) || *pos == '-' || *pos == '+' || *pos == '.' || *pos == 'e' || *pos == 'E'))
+		token[len++] = *pos++;
+	token[len] = 0;
+
+	if(len == 0)
+		return false;
+
+	char* tokenEnd;
+	value = strtod(token, &tokenEnd);
+	return *tokenEnd == 0;
+}
+
+bool BiomIO::SkipValue(const char*& pos, const char* end)
+{
+	SkipWhiteSpace(pos, end);
+	if(pos >= end)
+		return false;
+
+	if(*pos == '"')
+	{
+		std::string str;
+		return ParseString(pos, end, str);
+	}
+	else if(*pos == '{' || *pos == '[')
+	{
+		char close = (*pos == '{') ? '}' : ']';
+		++pos;
+
+		SkipWhiteSpace(pos, end);
+		if(pos < end && *pos == close)
+		{
+			++pos;
+			return true;
+		}
+
+		while(true)
+		{
+			if(close == '}')
+			{
+				std::string key;
+				if(!ParseString(pos, end, key) || !Expect(pos, end, ':'))
+					return false;
+			}
+
+			if(!SkipValue(pos, end))
+				return false;
+
+			SkipWhiteSpace(pos, end);
+			if(pos < end && *pos == ',')
+				++pos;
+			else
+				return Expect(pos, end, close);
+		}
+	}
+
+	// number or literal (true, false, null)
+	const char* start = pos;
+	while(pos < end && *pos != ',' && *pos != ']' && *pos != '}' && !isspace((unsigned char)*pos))
+		++pos;
+
+	return pos != start;
+}
+
+bool BiomIO::ParseIds(const char*& pos, const char* end, std::vector<std::string>& ids)
+{
+	if(!Expect(pos, end, '['))
+		return false;
+
+	SkipWhiteSpace(pos, end);
+	if(pos < end && *pos == ']')
+		return true;
+
+	while(true)
+	{
+		if(!Expect(pos, end, '{'))
+			return false;
+
+		bool bFoundId = false;
+		SkipWhiteSpace(pos, end);
+		if(pos < end && *pos != '}')
+		{
+			while(true)
+			{
+				std::string key;
+				if(!ParseString(pos, end, key) || !Expect(pos, end, ':'))
+					return false;
+
+				if(key == "id")
+				{
+					std::string id;
+					if(!ParseString(pos, end, id))
+						return false;
+
+					ids.push_back(id);
+					bFoundId = true;
+				}
+				else if(!SkipValue(pos, end))
+					return false;
+
+				SkipWhiteSpace(pos, end);
+				if(pos < end && *pos == ',')
+					++pos;
+				else
+					break;
+			}
+		}
+
+		if(!Expect(pos, end, '}') || !bFoundId)
+			return false;
+
+		SkipWhiteSpace(pos, end);
+		if(pos < end && *pos == ',')
+			++pos;
+		else
+			return Expect(pos, end, ']');
+	}
+}
+
+bool BiomIO::ParseSparseData(const char*& pos, const char* end)
+{
+	if(!Expect(pos, end, '['))
+		return false;
+
+	SkipWhiteSpace(pos, end);
+	if(pos < end && *pos == ']')
+		return true;
+
+	while(true)
+	{
+		double row, col, value;
+		if(!Expect(pos, end, '[') || !ParseNumber(pos, end, row) || !Expect(pos, end, ',') 
+					|| !ParseNumber(pos, end, col) || !Expect(pos, end, ',')
+					|| !ParseNumber(pos, end, value) || !Expect(pos, end, ']'))
+			return false;
+
+		if(!AddEntry(row, col, value))
+			return false;
+
+		SkipWhiteSpace(pos, end);
+		if(pos < end && *pos == ',')
+			++pos;
+		else
+			return Expect(pos, end, ']');
+	}
+}
+
+bool BiomIO::ParseDenseData(const char*& pos, const char* end)
+{
+	if(!Expect(pos, end, '['))
+		return false;
+
+	SkipWhiteSpace(pos, end);
+	if(pos < end && *pos == ']')
+		return true;
+
+	for(uint row = 0; ; ++row)
+	{
+		if(!Expect(pos, end, '['))
+			return false;
+
+		SkipWhiteSpace(pos, end);
+		if(pos < end && *pos != ']')
+		{
+			for(uint col = 0; ; ++col)
+			{
+				double value;
+				if(!ParseNumber(pos, end, value) || !AddEntry(row, col, value))
+					return false;
+
+				SkipWhiteSpace(pos, end);
+				if(pos < end && *pos == ',')
+					++pos;
+				else
+					break;
+			}
+		}
+
+		if(!Expect(pos, end, ']'))
+			return false;
+
+		SkipWhiteSpace(pos, end);
+		if(pos < end && *pos == ',')
+			++pos;
+		else
+			return Expect(pos, end, ']');
+	}
+}
+
+bool BiomIO::AddEntry(double row, double col, double value)
+{
+	if(row < 0 || row >= m_observations.size() || row != floor(row) 
+				|| col < 0 || col >= m_samples.size() || col != floor(col))
+		return false;
+
+	if(value != 0)
+	{
+		m_entrySamples.push_back((uint)col);
+		m_entryObservations.push_back((uint)row);
+		m_entryValues.push_back(value);
+	}
+
+	return true;
+}
@@ -0,0 +1,111 @@
+//=======================================================================
+// Author: Donovan Parks
+//
+// Copyright 2011 Donovan Parks
+//
+// This file is part of ExpressBetaDiversity.
+//
+// ExpressBetaDiversity is free software: you can redistribute it 
+// and/or modify it under the terms of the GNU General Public License 
+// as published by the Free Software Foundation, either version 3 of 
+// the License, or (at your option) any later version.
+//
+// ExpressBetaDiversity is distributed in the hope that it will be 
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ExpressBetaDiversity. If not, see 
+// <http://www.gnu.org/licenses/>.
+//=======================================================================
+
+#ifndef _BIOM_IO_
+#define _BIOM_IO_
+
+#include "Precompiled.hpp"
+
+/**
+ * @brief Read the non-zero entries of a table in BIOM (JSON) format.
+ *
+ * Rows of a BIOM table are observations (i.e., sequences or OTUs) and columns 
+ * are samples. Both sparse and dense matrix types are supported.
+ */
+class BiomIO
+{
+public:
+	/** Constructor. */
+	BiomIO() {}
+
+	/**
+	* @brief Read table in BIOM (JSON) format.
+	*
+	* @param filename Path to BIOM file.
+	* @return True if table read successfully, else false.
+	*/
+	bool Read(const std::string& filename);
+
+	/** Check if file appears to be a BIOM (JSON) file. */
+	static bool IsBiomFile(const std::string& filename);
+
+	/** Get name of each observation. */
+	const std::vector<std::string>& GetObservations() const { return m_observations; }
+
+	/** Get name of each sample. */
+	const std::vector<std::string>& GetSamples() const { return m_samples; }
+
+	/** Get sample index of each non-zero entry. */
+	const std::vector<uint>& GetEntrySamples() const { return m_entrySamples; }
+
+	/** Get observation index of each non-zero entry. */
+	const std::vector<uint>& GetEntryObservations() const { return m_entryObservations; }
+
+	/** Get value of each non-zero entry. */
+	const std::vector<double>& GetEntryValues() const { return m_entryValues; }
+
+private:
+	/** Skip white space characters. */
+	static void SkipWhiteSpace(const char*& pos, const char* end);
+
+	/** Consume the specified character (after any white space). */
+	static bool Expect(const char*& pos, const char* end, char c);
+
+	/** Parse a JSON string. */
+	static bool ParseString(const char*& pos, const char* end, std::string& str);
+
+	/** Parse a JSON number. */
+	static bool ParseNumber(const char*& pos, const char* end, double& value);
+
+	/** Skip any JSON value. */
+	static bool SkipValue(const char*& pos, const char* end);
+
+	/** Parse array of objects and get the 'id' of each object. */
+	static bool ParseIds(const char*& pos, const char* end, std::vector<std::string>& ids);
+
+	/** Parse data of a sparse matrix (array of [row, column, value] arrays). */
+	bool ParseSparseData(const char*& pos, const char* end);
+
+	/** Parse data of a dense matrix (array of rows). */
+	bool ParseDenseData(const char*& pos, const char* end);
+
+	/** Add non-zero entry to table. */
+	bool AddEntry(double row, double col, double value);
+
+private:
+	/** Name of each observation. */
+	std::vector<std::string> m_observations;
+
+	/** Name of each sample. */
+	std::vector<std::string> m_samples;
+
+	/** Sample index of each non-zero entry. */
+	std::vector<uint> m_entrySamples;
+
+	/** Observation index of each non-zero entry. */
+	std::vector<uint> m_entryObservations;
+
+	/** Value of each non-zero entry. */
+	std::vector<double> m_entryValues;
+};
+
+#endif
@@ -0,0 +1,204 @@
+//=======================================================================
+// Author: Donovan Parks
+//
+// Copyright 2011 Donovan Parks
+//
+// This file is part of ExpressBetaDiversity.
+//
+// ExpressBetaDiversity is free software: you can redistribute it 
+// and/or modify it under the terms of the GNU General Public License 
+// as published by the Free Software Foundation, either version 3 of 
+// the License, or (at your option) any later version.
+//
+// ExpressBetaDiversity is distributed in the hope that it will be 
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ExpressBetaDiversity. If not, see 
+// <http://www.gnu.org/licenses/>.
+//=======================================================================
+
+#include "Precompiled.hpp"
+
+#include "DataVectorCache.hpp"
+
+DataVectorCache::DataVectorCache()
+	: m_budget(0), m_size(0), m_hits(0), m_misses(0)
+{
+
+}
+
+void DataVectorCache::SetBudget(uint64 budget)
+{
+	m_budget = budget;
+
+	while(m_size > m_budget)
+		Evict();
+}
+
+void DataVectorCache::Clear()
+{
+	m_entries.clear();
+	m_dataVecs.clear();
+	m_floatDataVecs.clear();
+	m_sparseDataVecs.clear();
+	m_bitDataVecs.clear();
+	m_priorities.clear();
+	m_size = 0;
+}
+
+bool DataVectorCache::Find(uint index, REPRESENTATION representation)
+{
+	if(index >= m_entries.size() || !m_entries[index].bCached || m_entries[index].representation != representation)
+	{
+		++m_misses;
+		return false;
+	}
+
+	++m_hits;
+
+	Entry& entry = m_entries[index];
+	m_priorities.erase(std::make_pair(entry.priority, index));
+	entry.frequency++;
+	UpdatePriority(index);
+
+	return true;
+}
+
+const std::vector<double>* DataVectorCache::Get(uint index)
+{
+	return Find(index, DENSE) ? &m_dataVecs[index] : NULL;
+}
+
+const std::vector<float>* DataVectorCache::GetFloat(uint index)
+{
+	return Find(index, FLOAT) ? &m_floatDataVecs[index] : NULL;
+}
+
+const SparseDataVector* DataVectorCache::GetSparse(uint index)
+{
+	return Find(index, SPARSE) ? &m_sparseDataVecs[index] : NULL;
+}
+
+const BitDataVector* DataVectorCache::GetBits(uint index)
+{
+	return Find(index, BITS) ? &m_bitDataVecs[index] : NULL;
+}
+
+void DataVectorCache::Insert(uint index, const std::vector<double>& dataVec, double cost)
+{
+	uint64 dataBytes = dataVec.size()*sizeof(double);
+	if(!Reserve(index, dataBytes))
+		return;
+
+	m_dataVecs[index] = dataVec;
+	Add(index, DENSE, dataBytes, cost);
+}
+
+void DataVectorCache::Insert(uint index, const std::vector<float>& dataVec, double cost)
+{
+	uint64 dataBytes = dataVec.size()*sizeof(float);
+	if(!Reserve(index, dataBytes))
+		return;
+
+	m_floatDataVecs[index] = dataVec;
+	Add(index, FLOAT, dataBytes, cost);
+}
+
+void DataVectorCache::Insert(uint index, const SparseDataVector& dataVec, double cost)
+{
+	uint64 dataBytes = (dataVec.index.size() + dataVec.leaves.size())*sizeof(uint) + dataVec.value.size()*sizeof(double);
+	if(!Reserve(index, dataBytes))
+		return;
+
+	m_sparseDataVecs[index] = dataVec;
+	Add(index, SPARSE, dataBytes, cost);
+}
+
+void DataVectorCache::Insert(uint index, const BitDataVector& dataVec, double cost)
+{
+	uint64 dataBytes = dataVec.bits.size()*sizeof(uint64);
+	if(!Reserve(index, dataBytes))
+		return;
+
+	m_bitDataVecs[index] = dataVec;
+	Add(index, BITS, dataBytes, cost);
+}
+
+bool DataVectorCache::Reserve(uint index, uint64 dataBytes)
+{
+	if(dataBytes + sizeof(Entry) > m_budget)
+		return false;
+
+	if(index >= m_entries.size())
+	{
+		m_entries.resize(index+1);
+		m_dataVecs.resize(index+1);
+		m_floatDataVecs.resize(index+1);
+		m_sparseDataVecs.resize(index+1);
+		m_bitDataVecs.resize(index+1);
+	}
+
+	if(m_entries[index].bCached)
+	{
+		m_priorities.erase(std::make_pair(m_entries[index].priority, index));
+		Release(index);
+	}
+
+	return true;
+}
+
+void DataVectorCache::Add(uint index, REPRESENTATION representation, uint64 dataBytes, double cost)
+{
+	Entry& entry = m_entries[index];
+	entry.bCached = true;
+	entry.representation = representation;
+	entry.size = dataBytes + sizeof(Entry);
+	entry.cost = cost;
+	entry.frequency++;	// frequency is retained for samples which were previously evicted
+	UpdatePriority(index);
+	m_size += entry.size;
+
+	while(m_size > m_budget)
+		Evict();
+}
+
+void DataVectorCache::Release(uint index)
+{
+	Entry& entry = m_entries[index];
+	m_size -= entry.size;
+	entry.size = 0;
+	entry.bCached = false;
+
+	if(entry.representation == DENSE)
+		std::vector<double>().swap(m_dataVecs[index]);
+	else if(entry.representation == FLOAT)
+		std::vector<float>().swap(m_floatDataVecs[index]);
+	else if(entry.representation == SPARSE)
+	{
+		std::vector<uint>().swap(m_sparseDataVecs[index].index);
+		std::vector<double>().swap(m_sparseDataVecs[index].value);
+		std::vector<uint>().swap(m_sparseDataVecs[index].leaves);
+	}
+	else
+		std::vector<uint64>().swap(m_bitDataVecs[index].bits);
+}
+
+void DataVectorCache::UpdatePriority(uint index)
+{
+	Entry& entry = m_entries[index];
+	entry.priority = entry.frequency * entry.cost / entry.size;
+	m_priorities.insert(std::make_pair(entry.priority, index));
+}
+
+void DataVectorCache::Evict()
+{
+	// ties are broken in favour of evicting later samples as they are compared to fewer blocks of the dissimilarity matrix
+	std::set< std::pair<double, uint>, LowerPriority >::iterator lowest = m_priorities.begin();
+
+	uint index = lowest->second;
+	m_priorities.erase(lowest);
+	Release(index);
+}
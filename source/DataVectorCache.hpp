@@ -0,0 +1,168 @@
+//=======================================================================
+// Author: Donovan Parks
+//
+// Copyright 2011 Donovan Parks
+//
+// This file is part of ExpressBetaDiversity.
+//
+// ExpressBetaDiversity is free software: you can redistribute it 
+// and/or modify it under the terms of the GNU General Public License 
+// as published by the Free Software Foundation, either version 3 of 
+// the License, or (at your option) any later version.
+//
+// ExpressBetaDiversity is distributed in the hope that it will be 
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ExpressBetaDiversity. If not, see 
+// <http://www.gnu.org/licenses/>.
+//=======================================================================
+
+#ifndef _DATA_VECTOR_CACHE_
+#define _DATA_VECTOR_CACHE_
+
+#include "Precompiled.hpp"
+
+#include "DataVectorizer.hpp"
+
+/**
+ * @brief Cache of sample data vectors limited to a fixed number of bytes.
+ *
+ * The data vector with the lowest priority is evicted, where priority is given by
+ * frequency * cost / size and cost is the time taken to read and vectorize the sample.
+ * Data vectors which are expensive to read, small, or frequently used are retained.
+ * This is the GreedyDual-Size-Frequency policy without aging: a dissimilarity matrix 
+ * is calculated by repeatedly scanning over blocks of samples, so samples used frequently 
+ * in the past remain useful and recency is a poor guide to which samples will be reused.
+ * Data vectors are cached in the representation used to compare samples (dense, single
+ * precision, sparse, or presence/absence) and their size is that of this representation.
+ */
+class DataVectorCache
+{
+public:
+	/** Constructor. */
+	DataVectorCache();
+
+	/** Set maximum number of bytes used by cached data vectors (0 to disable cache). */
+	void SetBudget(uint64 budget);
+
+	/** Remove all data vectors from cache. */
+	void Clear();
+
+	/**
+	* @brief Get data vector of a sample.
+	*
+	* @param index Index of sample.
+	* @return Cached data vector, or NULL if sample is not in cache with this representation. Valid until the next call to Insert() or Clear().
+	*/
+	const std::vector<double>* Get(uint index);
+
+	/** Get single precision data vector of a sample, or NULL if sample is not in cache with this representation. */
+	const std::vector<float>* GetFloat(uint index);
+
+	/** Get sparse data vector of a sample, or NULL if sample is not in cache with this representation. */
+	const SparseDataVector* GetSparse(uint index);
+
+	/** Get presence/absence data vector of a sample, or NULL if sample is not in cache with this representation. */
+	const BitDataVector* GetBits(uint index);
+
+	/**
+	* @brief Add data vector of a sample to cache, evicting data vectors as required to remain within budget.
+	*
+	* Any data vector of the sample with another representation is replaced.
+	*
+	* @param index Index of sample.
+	* @param dataVec Data vector of sample.
+	* @param cost Cost of calculating the data vector (e.g., time to read and vectorize sample).
+	*/
+	void Insert(uint index, const std::vector<double>& dataVec, double cost);
+	void Insert(uint index, const std::vector<float>& dataVec, double cost);
+	void Insert(uint index, const SparseDataVector& dataVec, double cost);
+	void Insert(uint index, const BitDataVector& dataVec, double cost);
+
+	/** Get number of bytes used by cached data vectors. */
+	uint64 GetSize() const { return m_size; }
+
+	/** Get number of requests for a data vector found in the cache. */
+	uint64 GetHits() const { return m_hits; }
+
+	/** Get number of requests for a data vector not found in the cache. */
+	uint64 GetMisses() const { return m_misses; }
+
+private:
+	/** Representation of a cached data vector. */
+	enum REPRESENTATION { DENSE, FLOAT, SPARSE, BITS };
+
+	/** Cached data vector. */
+	struct Entry
+	{
+		Entry(): bCached(false), representation(DENSE), cost(0), frequency(0), priority(0), size(0) {}
+
+		bool bCached;
+		REPRESENTATION representation;
+		double cost;
+		uint frequency;
+		double priority;
+		uint64 size;
+	};
+
+	/** Find data vector of a sample with the given representation and record its use. */
+	bool Find(uint index, REPRESENTATION representation);
+
+	/** 
+	* @brief Release any cached data vector of a sample to make room for a new data vector.
+	*
+	* @return False if a data vector of this size can not be cached.
+	*/
+	bool Reserve(uint index, uint64 dataBytes);
+
+	/** Record that a data vector has been stored for a sample and evict data vectors as required. */
+	void Add(uint index, REPRESENTATION representation, uint64 dataBytes, double cost);
+
+	/** Release data vector of a sample. */
+	void Release(uint index);
+
+	/** Set priority of data vector based on its cost, size, and frequency of use. */
+	void UpdatePriority(uint index);
+
+	/** Remove data vector with lowest priority from cache. */
+	void Evict();
+
+	/** Order data vectors by priority, with ties ordered by decreasing sample index. */
+	struct LowerPriority
+	{
+		bool operator()(const std::pair<double, uint>& a, const std::pair<double, uint>& b) const
+		{
+			return a.first < b.first || (a.first == b.first && a.second > b.second);
+		}
+	};
+
+private:
+	/** Cache entry of each sample, indexed by sample. */
+	std::vector<Entry> m_entries;
+
+	/** Data vector of each sample in each representation, indexed by sample. */
+	std::vector< std::vector<double> > m_dataVecs;
+	std::vector< std::vector<float> > m_floatDataVecs;
+	std::vector<SparseDataVector> m_sparseDataVecs;
+	std::vector<BitDataVector> m_bitDataVecs;
+
+	/** Priority and sample index of each cached data vector. */
+	std::set< std::pair<double, uint>, LowerPriority > m_priorities;
+
+	/** Maximum number of bytes used by cached data vectors. */
+	uint64 m_budget;
+
+	/** Number of bytes used by cached data vectors. */
+	uint64 m_size;
+
+	/** Number of requests found in the cache. */
+	uint64 m_hits;
+
+	/** Number of requests not found in the cache. */
+	uint64 m_misses;
+};
+
+#endif
@@ -26,22 +26,19 @@
 
 bool DataVectorizer::Init(Tree<Node>* tree, bool bPhylogenetic, bool bWeighted, bool bNormalize, const std::vector<std::string>& seqs)
 {
-	m_tree = tree;
 	m_bPhylogenetic = bPhylogenetic;
 	m_bWeighted = bWeighted;
 	m_bNormalize = bNormalize;
 
 	if(m_bPhylogenetic)
 	{
-		m_breadthFirstOrder = m_tree->BreadthFirstOrder(m_tree->GetRootNode());
-
-		m_postOrder = m_tree->PostOrder(m_tree->GetRootNode());
-		m_size = m_postOrder.size()-1;	// ignore the branch of the root node
+		std::vector<Node*> postOrder = tree->PostOrder(tree->GetRootNode());
+		m_size = postOrder.size()-1;	// ignore the branch of the root node
 
 		// create map of leaf names to leaf nodes
 		std::map<std::string, Node*> leafMap;
 		std::vector<Node*>::const_iterator postOrderIt;
-		for(postOrderIt = m_postOrder.begin(); postOrderIt != m_postOrder.end(); ++postOrderIt)
+		for(postOrderIt = postOrder.begin(); postOrderIt != postOrder.end(); ++postOrderIt)
 		{
 			Node* curNode = *postOrderIt;
 			if(!curNode->IsLeaf())
@@ -72,9 +69,14 @@ bool DataVectorizer::Init(Tree<Node>* tree, bool bPhylogenetic, bool bWeighted,
 
 		// check that all leaf nodes have been assigned a sequence index and set the post-order
 		// traversal index for each node
-		for(uint i = 0; i < m_postOrder.size(); ++i)
+		m_seqPostOrderIndex.assign(seqs.size(), Node::NO_INDEX);
+		m_seqLeafIndex.assign(seqs.size(), Node::NO_INDEX);
+		m_leafPostOrderIndex.clear();
+		m_nodeSeqIndex.assign(postOrder.size(), Node::NO_INDEX);
+		m_numLeaves = 0;
+		for(uint i = 0; i < postOrder.size(); ++i)
 		{
-			Node* curNode = m_postOrder[i];
+			Node* curNode = postOrder[i];
 			curNode->SetPostOrderIndex(i);
 
 			if(curNode->IsLeaf())
@@ -84,17 +86,166 @@ bool DataVectorizer::Init(Tree<Node>* tree, bool bPhylogenetic, bool bWeighted,
 					std::cerr << "No sequence count data specified for the leaf node '" << curNode->GetName() << "'." << std::endl;
 					return false;
 				}
+
+				m_seqPostOrderIndex[curNode->GetSeqIndex()] = i;
+				m_seqLeafIndex[curNode->GetSeqIndex()] = m_numLeaves++;
+				m_leafPostOrderIndex.push_back(i);
+				m_nodeSeqIndex[i] = curNode->GetSeqIndex();
 			}
 		}
+
+		// build flat image of tree in post-order so later traversals do not chase node pointers
+		m_parentIndex.assign(postOrder.size(), Node::NO_INDEX);
+		m_firstChild.resize(postOrder.size());
+		m_numChildren.resize(postOrder.size());
+		m_childIndex.clear();
+		m_childIndex.reserve(postOrder.size());
+		m_firstDescendant.resize(postOrder.size());
+		m_branchLength.resize(postOrder.size());
+		for(uint i = 0; i < postOrder.size(); ++i)
+		{
+			Node* curNode = postOrder[i];
+			if(!curNode->IsRoot())
+				m_parentIndex[i] = curNode->GetParent()->GetPostOrderIndex();
+
+			m_firstChild[i] = m_childIndex.size();
+			m_numChildren[i] = curNode->GetNumberOfChildren();
+			for(uint c = 0; c < curNode->GetNumberOfChildren(); ++c)
+				m_childIndex.push_back(curNode->GetChild(c)->GetPostOrderIndex());
+
+			// the subtree of a node is the contiguous range of nodes ending at the node
+			m_firstDescendant[i] = curNode->IsLeaf() ? i : m_firstDescendant[m_childIndex[m_firstChild[i]]];
+
+			m_branchLength[i] = curNode->GetDistanceToParent();
+		}
+
+		// parents follow their children in post-order so depths are set from the root down
+		m_depth.resize(postOrder.size());
+		for(int i = (int)postOrder.size()-1; i >= 0; --i)
+			m_depth[i] = (m_parentIndex[i] == Node::NO_INDEX) ? 0 : m_depth[m_parentIndex[i]] + 1;
+
+		// root distances are accumulated from the root down
+		m_rootDistance.resize(postOrder.size());
+		for(int i = (int)postOrder.size()-1; i >= 0; --i)
+			m_rootDistance[i] = (m_parentIndex[i] == Node::NO_INDEX) ? 0 : m_rootDistance[m_parentIndex[i]] + m_branchLength[i];
+
+		BuildLCAIndex();
+
 	}
 	else
 	{
 		m_size = seqs.size();
 	}
 
+	InitScratch(m_vectorizeScratch);
+
 	return true;
 }
 
+void DataVectorizer::InitScratch(VectorizeScratch& scratch) const
+{
+	scratch.data.assign(m_size, 0);
+	scratch.bVisited.assign(m_bPhylogenetic ? m_size : 0, false);
+	scratch.nonZero.reserve(m_size);
+}
+
+void DataVectorizer::InitScratch(ScratchArena& scratch) const
+{
+	if(!m_bPhylogenetic)
+		return;
+
+	uint numNodes = m_parentIndex.size();
+	scratch.massI.assign(numNodes, 0);
+	scratch.massJ.assign(numNodes, 0);
+	scratch.massUnion.assign(numNodes, 0);
+	scratch.nearestI.assign(numNodes, DBL_MAX);
+	scratch.nearestJ.assign(numNodes, DBL_MAX);
+	scratch.nearestNodes.reserve(numNodes);
+
+	// leaf buffers hold at most one entry per leaf node
+	scratch.leafSet.reserve(m_numLeaves);
+	scratch.leafValuesI.reserve(m_numLeaves);
+	scratch.leafValuesJ.reserve(m_numLeaves);
+}
+
+void DataVectorizer::BuildLCAIndex()
+{
+	// Euler tour records a node each time it is entered or returned to from one of its children
+	uint numNodes = m_parentIndex.size();
+	uint rootIndex = numNodes-1;
+	m_eulerTour.clear();
+	m_eulerTour.reserve(2*numNodes-1);
+	m_eulerFirst.resize(numNodes);
+
+	std::vector<uint> nextChild(numNodes, 0);
+	std::vector<uint> stack;
+	stack.push_back(rootIndex);
+	m_eulerFirst[rootIndex] = 0;
+	m_eulerTour.push_back(rootIndex);
+	while(!stack.empty())
+	{
+		uint node = stack.back();
+		if(nextChild[node] < m_numChildren[node])
+		{
+			uint child = m_childIndex[m_firstChild[node] + nextChild[node]];
+			++nextChild[node];
+
+			m_eulerFirst[child] = m_eulerTour.size();
+			m_eulerTour.push_back(child);
+			stack.push_back(child);
+		}
+		else
+		{
+			stack.pop_back();
+			if(!stack.empty())
+				m_eulerTour.push_back(stack.back());
+		}
+	}
+
+	// level k of the sparse table gives the shallowest node in each run of 2^k entries of the tour
+	uint tourLen = m_eulerTour.size();
+	m_floorLog2.resize(tourLen+1);
+	m_floorLog2[0] = m_floorLog2[1] = 0;
+	for(uint len = 2; len <= tourLen; ++len)
+		m_floorLog2[len] = m_floorLog2[len/2] + 1;
+
+	uint numLevels = m_floorLog2[tourLen] + 1;
+	m_lcaTable.resize(numLevels*tourLen);
+	std::copy(m_eulerTour.begin(), m_eulerTour.end(), m_lcaTable.begin());
+	for(uint k = 1; k < numLevels; ++k)
+	{
+		const uint* prevLevel = &m_lcaTable[(k-1)*tourLen];
+		uint* level = &m_lcaTable[k*tourLen];
+		uint halfRun = 1 << (k-1);
+		for(uint i = 0; i + 2*halfRun <= tourLen; ++i)
+		{
+			uint node1 = prevLevel[i];
+			uint node2 = prevLevel[i + halfRun];
+			level[i] = (m_depth[node1] <= m_depth[node2]) ? node1 : node2;
+		}
+	}
+}
+
+uint DataVectorizer::GetLCA(uint node1, uint node2) const
+{
+	uint start = m_eulerFirst[node1];
+	uint end = m_eulerFirst[node2];
+	if(start > end)
+		std::swap(start, end);
+
+	uint k = m_floorLog2[end - start + 1];
+	const uint* level = &m_lcaTable[k*m_eulerTour.size()];
+	uint ancestor1 = level[start];
+	uint ancestor2 = level[end - (1 << k) + 1];
+
+	return (m_depth[ancestor1] <= m_depth[ancestor2]) ? ancestor1 : ancestor2;
+}
+
+double DataVectorizer::GetDistanceToRoot(uint node) const
+{
+	return m_rootDistance[node];
+}
+
 void DataVectorizer::CalculateDataVector(const std::vector<double>& count, bool bLeavesOnly, double totalNumSeq, std::vector<double>& data)
 {
 	data.clear();
@@ -102,23 +253,22 @@ void DataVectorizer::CalculateDataVector(const std::vector<double>& count, bool
 
 	if(m_bPhylogenetic)
 	{
-		std::vector<Node*>::iterator it;
-		for(it = m_postOrder.begin(); it != m_postOrder.end(); ++it)
+		uint rootIndex = m_parentIndex.size()-1;
+		for(uint i = 0; i < m_parentIndex.size(); ++i)
 		{
-			Node* curNode = *it;
-
-			if(curNode->IsLeaf())
+			if(m_numChildren[i] == 0)
 			{
 				if(m_bNormalize)
-					data.push_back(count[curNode->GetSeqIndex()] / totalNumSeq);
+					data.push_back(count[m_nodeSeqIndex[i]] / totalNumSeq);
 				else
-					data.push_back(count[curNode->GetSeqIndex()]);
+					data.push_back(count[m_nodeSeqIndex[i]]);
 			}
-			else if(!bLeavesOnly && !curNode->IsRoot())
+			else if(!bLeavesOnly && i != rootIndex)
 			{
+				const uint* child = &m_childIndex[m_firstChild[i]];
 				double p = 0;
-				for(uint i = 0; i < curNode->GetNumberOfChildren(); ++i)
-					p += data[curNode->GetChild(i)->GetPostOrderIndex()];
+				for(uint c = 0; c < m_numChildren[i]; ++c)
+					p += data[child[c]];
 				data.push_back(p);
 			}
 		}
@@ -147,355 +297,666 @@ void DataVectorizer::CalculateDataVector(const std::vector<double>& count, bool
 	}
 }
 
-void DataVectorizer::RestrictToMRCA(const std::vector<double>& branchVecI, const std::vector<double>& branchVecJ, 
-																			std::vector<double>& MRCAi, std::vector<double>& MRCAj, std::vector<double>& branchWeight)
+void DataVectorizer::CalculateDataVector(const std::vector<uint>& seqIndices, const std::vector<double>& count, bool bLeavesOnly, double totalNumSeq, std::vector<double>& data)
+{
+	CalculateDataVector(seqIndices, count, bLeavesOnly, totalNumSeq, data, m_vectorizeScratch);
+}
+
+void DataVectorizer::CalculateDataVector(const std::vector<uint>& seqIndices, const std::vector<double>& count, bool bLeavesOnly, double totalNumSeq, 
+																					std::vector<double>& data, VectorizeScratch& scratch) const
+{
+	if(m_bPhylogenetic && bLeavesOnly)
+		data.assign(m_numLeaves, 0);
+	else
+		data.assign(m_size, 0);
+
+	CalculateNonZero(seqIndices, count, bLeavesOnly, totalNumSeq, data, scratch.nonZero, scratch.bVisited);
+}
+
+void DataVectorizer::CalculateDataVector(const std::vector<uint>& seqIndices, const std::vector<double>& count, double totalNumSeq, SparseDataVector& data)
+{
+	CalculateDataVector(seqIndices, count, totalNumSeq, data, m_vectorizeScratch);
+}
+
+void DataVectorizer::CalculateDataVector(const std::vector<uint>& seqIndices, const std::vector<double>& count, double totalNumSeq, 
+																					SparseDataVector& data, VectorizeScratch& scratch) const
+{
+	// non-zero entries are calculated in a scratch data vector which is then returned to all zeros
+	CalculateNonZero(seqIndices, count, false, totalNumSeq, scratch.data, data.index, scratch.bVisited);
+	std::sort(data.index.begin(), data.index.end());
+
+	data.value.resize(data.index.size());
+	data.leaves.clear();
+	for(uint k = 0; k < data.index.size(); ++k)
+	{
+		uint i = data.index[k];
+		data.value[k] = scratch.data[i];
+		scratch.data[i] = 0;
+
+		if(m_bPhylogenetic && m_numChildren[i] == 0)
+			data.leaves.push_back(k);
+	}
+}
+
+void DataVectorizer::CalculateNonZero(const std::vector<uint>& seqIndices, const std::vector<double>& count, bool bLeavesOnly, double totalNumSeq, 
+																				std::vector<double>& data, std::vector<uint>& nonZero, std::vector<bool>& bVisited) const
 {
-	MRCAi.clear();
-	MRCAj.clear();
-	branchWeight.clear();
+	nonZero.clear();
+	nonZero.reserve(seqIndices.size());
 
+	const std::vector<uint>* dataIndex = NULL;
 	if(m_bPhylogenetic)
+		dataIndex = bLeavesOnly ? &m_seqLeafIndex : &m_seqPostOrderIndex;
+
+	for(uint i = 0; i < seqIndices.size(); ++i)
 	{
-		// determine leaf nodes in MRCA subtree and clear node counters
-		std::vector<Node*> leavesInMRCA;
-		for(uint i = 0; i < branchVecI.size(); ++i)
+		uint index = seqIndices[i];
+		if(dataIndex)
 		{
-			if(m_postOrder[i]->IsLeaf() && (branchVecI[i] > 0 || branchVecJ[i] > 0))
-				leavesInMRCA.push_back(m_postOrder[i]);
-
-			m_postOrder[i]->SetCounter(0);
+			// sequences without a leaf node (i.e., duplicate sequence names) are ignored
+			index = (*dataIndex)[index];
+			if(index == Node::NO_INDEX)
+				continue;
 		}
 
-		// trace each leaf node in subtree to the root and count number of times
-		// each internal node is encountered
-		m_tree->GetRootNode()->SetCounter(0);
-		std::vector<Node*>::iterator it;
-		for(it = leavesInMRCA.begin(); it != leavesInMRCA.end(); ++it)
-		{
-			Node* curNode = *it;
+		if(m_bNormalize)
+			data[index] = count[i] / totalNumSeq;
+		else
+			data[index] = count[i];
 
-			while(curNode != NULL)
-			{
-				curNode->IncCounter();
-				curNode = curNode->GetParent();
-			}
-		}
+		nonZero.push_back(index);
+	}
 
-		// start of MRCA subtree is the deepest node with the same count value as the root
-		Node* root = m_postOrder[m_postOrder.size()-1];
-		uint highestCount = root->GetCounter();
-		Node* startMRCA = root;
-		bool bNewMRCA = true;
-		while(bNewMRCA)
+	if(m_bPhylogenetic && !bLeavesOnly)
+	{
+		// find internal nodes on the path from each leaf node to the root
+		uint rootIndex = m_parentIndex.size()-1;
+		uint numLeaves = nonZero.size();
+		for(uint i = 0; i < numLeaves; ++i)
 		{
-			bNewMRCA = false;
-			std::vector<Node*> children = startMRCA->GetChildren();
-			for(uint i = 0; i < startMRCA->GetNumberOfChildren(); ++i)
+			uint parentIndex = m_parentIndex[nonZero[i]];
+			while(parentIndex != rootIndex && !bVisited[parentIndex])
 			{
-				if(startMRCA->GetChild(i)->GetCounter() == highestCount)
-				{
-					startMRCA = startMRCA->GetChild(i);
-					bNewMRCA = true;
-					break;
-				}
+				bVisited[parentIndex] = true;
+				nonZero.push_back(parentIndex);
+				parentIndex = m_parentIndex[parentIndex];
 			}
 		}
-		
-		// create MRCA data vectors
-		std::vector<Node*> postOrderMRCA = m_tree->PostOrder(startMRCA);
-		for(it = postOrderMRCA.begin(); it != postOrderMRCA.end(); ++it)
+
+		// children precede their parent in post-order so internal nodes can be calculated in order,
+		// summing children in the same order as for dense count data
+		std::sort(nonZero.begin() + numLeaves, nonZero.end());
+		for(uint i = numLeaves; i < nonZero.size(); ++i)
 		{
-			Node* curNode = *it;
+			bVisited[nonZero[i]] = false;
 
-			if(curNode != startMRCA)
-			{
-				MRCAi.push_back(branchVecI[curNode->GetPostOrderIndex()]);
-				MRCAj.push_back(branchVecJ[curNode->GetPostOrderIndex()]);
-				branchWeight.push_back(curNode->GetDistanceToParent());
-			}
+			const uint* child = &m_childIndex[m_firstChild[nonZero[i]]];
+			double p = 0;
+			for(uint c = 0; c < m_numChildren[nonZero[i]]; ++c)
+				p += data[child[c]];
+			data[nonZero[i]] = p;
+		}
+	}
+
+	if(!m_bWeighted)
+	{
+		// calculate binary equivalent of data vector
+		for(uint i = 0; i < nonZero.size(); ++i)
+		{
+			if(data[nonZero[i]] > 0)
+				data[nonZero[i]] = 1.0;
 		}
 	}
 }
 
-void DataVectorizer::LeafSetMinDistance(const std::vector<double>& branchVecI, const std::vector<double>& branchVecJ, 
-																					std::vector<double>& minLeafI, std::vector<double>& minLeafJ)
+void DataVectorizer::CalculateDataVector(const std::vector<uint>& seqIndices, const std::vector<double>& count, double totalNumSeq, BitDataVector& data)
 {
-	LeafSetMinMeanDistance(branchVecI, branchVecJ, minLeafI, minLeafJ, true);
+	CalculateDataVector(seqIndices, count, totalNumSeq, data, m_vectorizeScratch);
 }
 
-void DataVectorizer::LeafSetMeanDistance(const std::vector<double>& branchVecI, const std::vector<double>& branchVecJ, 
-																					std::vector<double>& meanLeafI, std::vector<double>& meanLeafJ)
+void DataVectorizer::CalculateDataVector(const std::vector<uint>& seqIndices, const std::vector<double>& count, double totalNumSeq, 
+																					BitDataVector& data, VectorizeScratch& scratch) const
 {
-	LeafSetMinMeanDistance(branchVecI, branchVecJ, meanLeafI, meanLeafJ, false);
+	std::vector<uint>& nonZero = scratch.nonZero;
+	CalculateNonZero(seqIndices, count, false, totalNumSeq, scratch.data, nonZero, scratch.bVisited);
+
+	data.bits.assign((m_size + 63) / 64, 0);
+	for(uint k = 0; k < nonZero.size(); ++k)
+	{
+		uint i = nonZero[k];
+		if(scratch.data[i] > 0)
+			data.bits[i / 64] |= (uint64)1 << (i % 64);
+		scratch.data[i] = 0;
+	}
 }
 
-void DataVectorizer::LeafSetMinMeanDistance(const std::vector<double>& branchVecI, const std::vector<double>& branchVecJ, 
-																					std::vector<double>& leafI, std::vector<double>& leafJ, bool bMinOrMean)
+void DataVectorizer::ToBits(const std::vector<double>& data, BitDataVector& bitData) const
 {
-	leafI.clear();
-	leafJ.clear();
+	bitData.bits.assign((data.size() + 63) / 64, 0);
+	for(uint i = 0; i < data.size(); ++i)
+	{
+		if(data[i] > 0)
+			bitData.bits[i / 64] |= (uint64)1 << (i % 64);
+	}
+}
 
-	if(m_bPhylogenetic)
+void DataVectorizer::ToDense(const BitDataVector& bitData, std::vector<double>& data) const
+{
+	data.assign(m_size, 0);
+	for(uint i = 0; i < m_size; ++i)
 	{
-		// determine leaf nodes in communities i and j
-		std::vector<Node*> leafSetI;
-		std::vector<Node*> leafSetJ;
-		for(uint i = 0; i < branchVecI.size(); ++i)
-		{
-			if(m_postOrder[i]->IsLeaf())
-			{
-				if(branchVecI[i] > 0)
-					leafSetI.push_back(m_postOrder[i]);
+		if(bitData.bits[i / 64] & ((uint64)1 << (i % 64)))
+			data[i] = 1.0;
+	}
+}
 
-				if(branchVecJ[i] > 0)
-					leafSetJ.push_back(m_postOrder[i]);
-			}
-		}
+void DataVectorizer::ToSparse(const std::vector<double>& data, SparseDataVector& sparseData) const
+{
+	sparseData.index.clear();
+	sparseData.value.clear();
+	sparseData.leaves.clear();
+	for(uint i = 0; i < data.size(); ++i)
+	{
+		if(data[i] == 0)
+			continue;
 
-		// find distance from leaf nodes in community i to leaf nodes in community j
-		for(uint i = 0; i < leafSetI.size(); ++i)
-		{
-			double minDist = std::numeric_limits<double>::max();
-			double meanDist = 0;
-			for(uint j = 0; j < leafSetJ.size(); ++j)
-			{
-				double dist = m_tree->GetPhylogeneticDistance(leafSetI[i], leafSetJ[j]);
-				if(dist < minDist)
-					minDist = dist;
+		if(m_bPhylogenetic && m_numChildren[i] == 0)
+			sparseData.leaves.push_back(sparseData.index.size());
 
-				meanDist += branchVecJ[leafSetJ[j]->GetPostOrderIndex()]*dist;
-			}
+		sparseData.index.push_back(i);
+		sparseData.value.push_back(data[i]);
+	}
+}
 
-			double prop = branchVecI[leafSetI[i]->GetPostOrderIndex()];
+void DataVectorizer::ToDense(const SparseDataVector& sparseData, std::vector<double>& data) const
+{
+	data.assign(m_size, 0);
+	for(uint k = 0; k < sparseData.index.size(); ++k)
+		data[sparseData.index[k]] = sparseData.value[k];
+}
 
-			if(bMinOrMean)
-				leafI.push_back(prop*minDist);
-			else
-			{
-				if(m_bWeighted)
-					leafI.push_back(prop*meanDist);
-				else
-					leafI.push_back(prop*(meanDist/leafSetJ.size()));
-			}
-		}
+template<class T>
+void DataVectorizer::GetMRCARange(const std::vector<T>& branchVecI, const std::vector<T>& branchVecJ, uint& firstNode, uint& mrcaNode) const
+{
+	firstNode = 0;
+	mrcaNode = 0;
 
-		// find distance from leaf nodes in community j to leaf nodes in community i
-		for(uint j = 0; j < leafSetJ.size(); ++j)
-		{
-			double minDist = std::numeric_limits<double>::max();
-			double meanDist = 0;
-			for(uint i = 0; i < leafSetI.size(); ++i)
-			{
-				double dist = m_tree->GetPhylogeneticDistance(leafSetJ[j], leafSetI[i]);
-				if(dist < minDist)
-					minDist = dist;
+	// find first and last leaf node in either community, with leaf nodes stored in post-order
+	uint numLeaves = m_leafPostOrderIndex.size();
+	while(numLeaves > 0 && m_leafPostOrderIndex[numLeaves-1] >= branchVecI.size())
+		--numLeaves;
 
-				meanDist += branchVecI[leafSetI[i]->GetPostOrderIndex()]*dist;
-			}
+	uint first = 0;
+	while(first < numLeaves && !(branchVecI[m_leafPostOrderIndex[first]] > 0 || branchVecJ[m_leafPostOrderIndex[first]] > 0))
+		++first;
 
-			double prop = branchVecJ[leafSetJ[j]->GetPostOrderIndex()];
+	if(first == numLeaves)
+		return;
 
-			if(bMinOrMean)
-				leafJ.push_back(prop*minDist);
-			else
-			{
-				if(m_bWeighted)
-					leafJ.push_back(prop*meanDist);
-				else
-					leafJ.push_back(prop*(meanDist/leafSetI.size()));
-			}
-		}
+	uint last = numLeaves-1;
+	while(!(branchVecI[m_leafPostOrderIndex[last]] > 0 || branchVecJ[m_leafPostOrderIndex[last]] > 0))
+		--last;
+
+	mrcaNode = GetLCA(m_leafPostOrderIndex[first], m_leafPostOrderIndex[last]);
+	firstNode = m_firstDescendant[mrcaNode];
+}
+
+void DataVectorizer::GetMRCARange(const SparseDataVector& branchVecI, const SparseDataVector& branchVecJ, uint& firstNode, uint& mrcaNode) const
+{
+	firstNode = 0;
+	mrcaNode = 0;
+
+	// leaf nodes of each community are stored in post-order
+	uint first = Node::NO_INDEX;
+	uint last = 0;
+	if(!branchVecI.leaves.empty())
+	{
+		first = branchVecI.index[branchVecI.leaves.front()];
+		last = branchVecI.index[branchVecI.leaves.back()];
+	}
+
+	if(!branchVecJ.leaves.empty())
+	{
+		first = std::min<uint>(first, branchVecJ.index[branchVecJ.leaves.front()]);
+		last = std::max<uint>(last, branchVecJ.index[branchVecJ.leaves.back()]);
 	}
+
+	if(first == Node::NO_INDEX)
+		return;
+
+	mrcaNode = GetLCA(first, last);
+	firstNode = m_firstDescendant[mrcaNode];
 }
 
-void DataVectorizer::LeafSetDistance(const std::vector<double>& branchVecI, const std::vector<double>& branchVecJ, 
-																					std::vector<double>& leafPropI, std::vector<double>& leafPropJ, 
-																					std::vector< std::vector<double> >& leafDistances)
+template<class T>
+void DataVectorizer::GetLeafSet(const std::vector<T>& branchVec, std::vector<uint>& leafSet, std::vector<double>& leafProp) const
 {
-	leafPropI.clear();
-	leafPropJ.clear();
-	leafDistances.clear();
+	leafSet.clear();
+	leafProp.clear();
 
 	if(m_bPhylogenetic)
 	{
-		// determine leaf nodes in communities i and j
-		std::vector<Node*> leafSetI;
-		std::vector<Node*> leafSetJ;
-		for(uint i = 0; i < branchVecI.size(); ++i)
+		for(uint k = 0; k < m_leafPostOrderIndex.size() && m_leafPostOrderIndex[k] < branchVec.size(); ++k)
 		{
-			if(m_postOrder[i]->IsLeaf())
+			uint i = m_leafPostOrderIndex[k];
+			if(branchVec[i] > 0)
 			{
-				if(branchVecI[i] > 0)
-				{
-					leafSetI.push_back(m_postOrder[i]);
-					leafPropI.push_back(branchVecI[m_postOrder[i]->GetPostOrderIndex()]);
-				}
-
-				if(branchVecJ[i] > 0)
-				{
-					leafSetJ.push_back(m_postOrder[i]);
-					leafPropJ.push_back(branchVecJ[m_postOrder[i]->GetPostOrderIndex()]);
-				}
+				leafSet.push_back(i);
+				leafProp.push_back(branchVec[i]);
 			}
 		}
+	}
+}
 
-		// find distance from leaf nodes in community i to leaf nodes in community j
-		for(uint i = 0; i < leafSetI.size(); ++i)
-		{
-			std::vector<double> distances;
-			for(uint j = 0; j < leafSetJ.size(); ++j)
-			{
-				double dist = m_tree->GetPhylogeneticDistance(leafSetI[i], leafSetJ[j]);
-				distances.push_back(dist);
-			}
+void DataVectorizer::GetLeafSet(const SparseDataVector& branchVec, std::vector<uint>& leafSet, std::vector<double>& leafProp) const
+{
+	leafSet.clear();
+	leafProp.clear();
 
-			leafDistances.push_back(distances);
+	for(uint k = 0; k < branchVec.leaves.size(); ++k)
+	{
+		uint pos = branchVec.leaves[k];
+		if(branchVec.value[pos] > 0)
+		{
+			leafSet.push_back(branchVec.index[pos]);
+			leafProp.push_back(branchVec.value[pos]);
 		}
 	}
 }
 
-void DataVectorizer::PairedLeafSetDistance(const std::vector<double>& branchVecI, const std::vector<double>& branchVecJ, 
-																					std::vector<double>& leafPropI, std::vector<double>& leafPropJ, 
-																					std::vector< std::vector<double> >& leafDistances)
+template<class T>
+void DataVectorizer::GetPairedLeafSet(const std::vector<T>& branchVecI, const std::vector<T>& branchVecJ, 
+																				std::vector<uint>& leafSet, std::vector<double>& leafPropI, std::vector<double>& leafPropJ) const
 {
+	leafSet.clear();
 	leafPropI.clear();
 	leafPropJ.clear();
-	leafDistances.clear();
 
 	if(m_bPhylogenetic)
 	{
-		// determine leaf nodes in communities i and j
-		std::vector<Node*> leafSet;
-		for(uint i = 0; i < branchVecI.size(); ++i)
+		for(uint k = 0; k < m_leafPostOrderIndex.size() && m_leafPostOrderIndex[k] < branchVecI.size(); ++k)
 		{
-			if(m_postOrder[i]->IsLeaf())
+			uint i = m_leafPostOrderIndex[k];
+			if(branchVecI[i] > 0 || branchVecJ[i] > 0)
 			{
-				if(branchVecI[i] > 0 || branchVecJ[i] > 0)
-				{
-					leafSet.push_back(m_postOrder[i]);
-					leafPropI.push_back(branchVecI[m_postOrder[i]->GetPostOrderIndex()]);
-					leafPropJ.push_back(branchVecJ[m_postOrder[i]->GetPostOrderIndex()]);
-				}
+				leafSet.push_back(i);
+				leafPropI.push_back(branchVecI[i]);
+				leafPropJ.push_back(branchVecJ[i]);
 			}
 		}
+	}
+}
 
-		// find distance between leaf nodes
-		for(uint i = 0; i < leafSet.size(); ++i)
+void DataVectorizer::GetPairedLeafSet(const SparseDataVector& branchVecI, const SparseDataVector& branchVecJ, 
+																				std::vector<uint>& leafSet, std::vector<double>& leafPropI, std::vector<double>& leafPropJ) const
+{
+	leafSet.clear();
+	leafPropI.clear();
+	leafPropJ.clear();
+
+	// merge leaf nodes of both communities in post-order
+	uint k = 0;
+	uint l = 0;
+	while(k < branchVecI.leaves.size() || l < branchVecJ.leaves.size())
+	{
+		uint posI = (k < branchVecI.leaves.size()) ? branchVecI.leaves[k] : Node::NO_INDEX;
+		uint posJ = (l < branchVecJ.leaves.size()) ? branchVecJ.leaves[l] : Node::NO_INDEX;
+		uint leafI = (posI != Node::NO_INDEX) ? branchVecI.index[posI] : Node::NO_INDEX;
+		uint leafJ = (posJ != Node::NO_INDEX) ? branchVecJ.index[posJ] : Node::NO_INDEX;
+
+		uint leaf = std::min<uint>(leafI, leafJ);
+		double propI = 0;
+		double propJ = 0;
+		if(leafI == leaf)
 		{
-			std::vector<double> distances;
-			for(uint j = 0; j < leafSet.size(); ++j)
-			{
-				double dist = m_tree->GetPhylogeneticDistance(leafSet[i], leafSet[j]);
-				distances.push_back(dist);
-			}
+			propI = branchVecI.value[posI];
+			++k;
+		}
 
-			leafDistances.push_back(distances);
+		if(leafJ == leaf)
+		{
+			propJ = branchVecJ.value[posJ];
+			++l;
+		}
+
+		if(propI > 0 || propJ > 0)
+		{
+			leafSet.push_back(leaf);
+			leafPropI.push_back(propI);
+			leafPropJ.push_back(propJ);
 		}
 	}
 }
 
-void DataVectorizer::FullLeafSetDistance(const std::vector<double>& colSum, std::vector<double>& leafColSum, std::vector< std::vector<double> >& leafDistances)
+template<class T>
+void DataVectorizer::LeafSetMinDistance(const std::vector<T>& branchVecI, const std::vector<T>& branchVecJ, 
+																					std::vector<double>& minLeafI, std::vector<double>& minLeafJ, ScratchArena& scratch) const
 {
-	leafDistances.clear();
-
-	if(m_bPhylogenetic)
+	minLeafI.clear();
+	minLeafJ.clear();
+	if(!m_bPhylogenetic)
+		return;
+
+	// children precede their parent in post-order so the nearest leaf node within each subtree is complete once it is reached
+	uint rootIndex = m_parentIndex.size()-1;
+	for(uint i = 0; i < rootIndex; ++i)
 	{
-		// determine leaf nodes
-		std::vector<Node*> leafSet;
-		for(uint i = 0; i < m_postOrder.size(); ++i)
+		if(m_numChildren[i] == 0 && i < branchVecI.size())
 		{
-			if(m_postOrder[i]->IsLeaf())
-			{
-				leafSet.push_back(m_postOrder[i]);
-				leafColSum.push_back(colSum[m_postOrder[i]->GetPostOrderIndex()]);
-			}
+			scratch.nearestI[i] = (branchVecI[i] > 0) ? 0 : DBL_MAX;
+			scratch.nearestJ[i] = (branchVecJ[i] > 0) ? 0 : DBL_MAX;
 		}
 
-		// find distance between leaf nodes
-		for(uint i = 0; i < leafSet.size(); ++i)
-		{
-			std::vector<double> distances;
-			for(uint j = 0; j < i; ++j)
-			{
-				double dist = m_tree->GetPhylogeneticDistance(leafSet[i], leafSet[j]);
-				distances.push_back(dist);
-			}
+		uint parent = m_parentIndex[i];
+		if(scratch.nearestI[i] != DBL_MAX)
+			scratch.nearestI[parent] = std::min(scratch.nearestI[parent], scratch.nearestI[i] + m_branchLength[i]);
+
+		if(scratch.nearestJ[i] != DBL_MAX)
+			scratch.nearestJ[parent] = std::min(scratch.nearestJ[parent], scratch.nearestJ[i] + m_branchLength[i]);
+	}
+
+	// parents precede their children in reverse post-order so leaf nodes outside each subtree are considered from the root down
+	for(int i = (int)rootIndex-1; i >= 0; --i)
+	{
+		uint parent = m_parentIndex[i];
+		if(scratch.nearestI[parent] != DBL_MAX)
+			scratch.nearestI[i] = std::min(scratch.nearestI[i], scratch.nearestI[parent] + m_branchLength[i]);
 
-			leafDistances.push_back(distances);
+		if(scratch.nearestJ[parent] != DBL_MAX)
+			scratch.nearestJ[i] = std::min(scratch.nearestJ[i], scratch.nearestJ[parent] + m_branchLength[i]);
+	}
+
+	for(uint k = 0; k < m_leafPostOrderIndex.size() && m_leafPostOrderIndex[k] < branchVecI.size(); ++k)
+	{
+		uint i = m_leafPostOrderIndex[k];
+		if(branchVecI[i] > 0)
+			minLeafI.push_back(branchVecI[i]*scratch.nearestJ[i]);
+
+		if(branchVecJ[i] > 0)
+			minLeafJ.push_back(branchVecJ[i]*scratch.nearestI[i]);
+	}
+
+	std::fill(scratch.nearestI.begin(), scratch.nearestI.end(), DBL_MAX);
+	std::fill(scratch.nearestJ.begin(), scratch.nearestJ.end(), DBL_MAX);
+}
+
+void DataVectorizer::LeafSetMinDistance(const SparseDataVector& branchVecI, const SparseDataVector& branchVecJ, 
+																					std::vector<double>& minLeafI, std::vector<double>& minLeafJ, ScratchArena& scratch) const
+{
+	minLeafI.clear();
+	minLeafJ.clear();
+	if(!m_bPhylogenetic)
+		return;
+
+	// the path between any two leaf nodes passes only through their ancestors, which are non-zero in one of the vectors
+	uint rootIndex = m_parentIndex.size()-1;
+	scratch.nearestNodes.clear();
+	SparseDataVectorPair pair(branchVecI, branchVecJ);
+	uint i;
+	double valueI, valueJ;
+	while(pair.Next(i, valueI, valueJ))
+	{
+		if(i == rootIndex)
+			continue;
+
+		scratch.nearestNodes.push_back(i);
+		if(m_numChildren[i] == 0)
+		{
+			scratch.nearestI[i] = (valueI > 0) ? 0 : DBL_MAX;
+			scratch.nearestJ[i] = (valueJ > 0) ? 0 : DBL_MAX;
 		}
+
+		uint parent = m_parentIndex[i];
+		if(scratch.nearestI[i] != DBL_MAX)
+			scratch.nearestI[parent] = std::min(scratch.nearestI[parent], scratch.nearestI[i] + m_branchLength[i]);
+
+		if(scratch.nearestJ[i] != DBL_MAX)
+			scratch.nearestJ[parent] = std::min(scratch.nearestJ[parent], scratch.nearestJ[i] + m_branchLength[i]);
 	}
+
+	for(int k = (int)scratch.nearestNodes.size()-1; k >= 0; --k)
+	{
+		uint i = scratch.nearestNodes[k];
+		uint parent = m_parentIndex[i];
+		if(scratch.nearestI[parent] != DBL_MAX)
+			scratch.nearestI[i] = std::min(scratch.nearestI[i], scratch.nearestI[parent] + m_branchLength[i]);
+
+		if(scratch.nearestJ[parent] != DBL_MAX)
+			scratch.nearestJ[i] = std::min(scratch.nearestJ[i], scratch.nearestJ[parent] + m_branchLength[i]);
+	}
+
+	for(uint k = 0; k < branchVecI.leaves.size(); ++k)
+	{
+		uint pos = branchVecI.leaves[k];
+		if(branchVecI.value[pos] > 0)
+			minLeafI.push_back(branchVecI.value[pos]*scratch.nearestJ[branchVecI.index[pos]]);
+	}
+
+	for(uint k = 0; k < branchVecJ.leaves.size(); ++k)
+	{
+		uint pos = branchVecJ.leaves[k];
+		if(branchVecJ.value[pos] > 0)
+			minLeafJ.push_back(branchVecJ.value[pos]*scratch.nearestI[branchVecJ.index[pos]]);
+	}
+
+	for(uint k = 0; k < scratch.nearestNodes.size(); ++k)
+	{
+		scratch.nearestI[scratch.nearestNodes[k]] = DBL_MAX;
+		scratch.nearestJ[scratch.nearestNodes[k]] = DBL_MAX;
+	}
+
+	scratch.nearestI[rootIndex] = DBL_MAX;
+	scratch.nearestJ[rootIndex] = DBL_MAX;
 }
 
-void DataVectorizer::LeafSetRootDistance(const std::vector<double>& branchVecI, const std::vector<double>& branchVecJ, 
-																				 std::vector<double>& rootDistI, std::vector<double>& rootDistJ)
+template<class T>
+void DataVectorizer::LeafSetDistanceSum(const std::vector<T>& branchVecI, const std::vector<T>& branchVecJ, bool bPresence, LeafSetDistanceSums& sums, ScratchArena& scratch) const
 {
-	rootDistI.clear();
-	rootDistJ.clear();
+	memset(&sums, 0, sizeof(sums));
+	if(!m_bPhylogenetic)
+		return;
 
-	if(m_bPhylogenetic)
+	for(uint k = 0; k < m_leafPostOrderIndex.size() && m_leafPostOrderIndex[k] < branchVecI.size(); ++k)
 	{
-		// determine leaf nodes in communities i or j
-		std::vector<Node*> leafSet;
-		for(uint i = 0; i < branchVecI.size(); ++i)
+		uint i = m_leafPostOrderIndex[k];
+		sums.totalI += LeafMass(branchVecI[i], bPresence);
+		sums.totalJ += LeafMass(branchVecJ[i], bPresence);
+
+		if(branchVecI[i] > 0 || branchVecJ[i] > 0)
+			sums.numLeaves++;
+	}
+
+	// children precede their parent in post-order so the mass below each node is complete once it is reached
+	uint rootIndex = m_parentIndex.size()-1;
+	for(uint i = 0; i < rootIndex; ++i)
+	{
+		double massI = scratch.massI[i];
+		double massJ = scratch.massJ[i];
+		double massUnion = scratch.massUnion[i];
+		scratch.massI[i] = 0;
+		scratch.massJ[i] = 0;
+
+		if(m_numChildren[i] == 0 && i < branchVecI.size())
 		{
-			if(m_postOrder[i]->IsLeaf())
-			{
-				if(branchVecI[i] > 0 || branchVecJ[i] > 0)
-					leafSet.push_back(m_postOrder[i]);
-			}
+			massI = LeafMass(branchVecI[i], bPresence);
+			massJ = LeafMass(branchVecJ[i], bPresence);
+			massUnion = (branchVecI[i] > 0 || branchVecJ[i] > 0) ? 1 : 0;
 		}
 
-		// calculate distance from leaf nodes in community i or j weighted by seq. proportions
-		for(uint i = 0; i < leafSet.size(); ++i)
+		if(massI == 0 && massJ == 0 && massUnion == 0)
+			continue;
+
+		AddBranchDistance(m_branchLength[i], massI, massJ, sums);
+
+		if(m_parentIndex[i] != rootIndex)
 		{
-			double dist = m_tree->GetDistanceToRoot(leafSet[i]);
+			scratch.massI[m_parentIndex[i]] += massI;
+			scratch.massJ[m_parentIndex[i]] += massJ;
+		}
 
-			rootDistI.push_back(branchVecI[leafSet[i]->GetPostOrderIndex()] * dist);
-			rootDistJ.push_back(branchVecJ[leafSet[i]->GetPostOrderIndex()] * dist);
+		if(bPresence)
+		{
+			// number of leaf nodes present in either community is only needed when averaging over pairs of leaf nodes
+			scratch.massUnion[i] = 0;
+			sums.sumUnion += m_branchLength[i]*2*massUnion*(sums.numLeaves - massUnion);
+			if(m_parentIndex[i] != rootIndex)
+				scratch.massUnion[m_parentIndex[i]] += massUnion;
 		}
 	}
 }
 
-void DataVectorizer::ApplyWeightsMRCA(const std::vector<double>& branchVecI, const std::vector<double>& branchVecJ, std::vector<double>& branchWeightsMRCA)
+void DataVectorizer::LeafSetDistanceSum(const SparseDataVector& branchVecI, const SparseDataVector& branchVecJ, bool bPresence, LeafSetDistanceSums& sums, ScratchArena& scratch) const
 {
-	// calculate MRCA weighting of each node	
-	for(uint i = 0; i < m_breadthFirstOrder.size(); ++i)
+	memset(&sums, 0, sizeof(sums));
+	if(!m_bPhylogenetic)
+		return;
+
+	// merge leaf nodes of both communities in post-order
+	uint k = 0;
+	uint l = 0;
+	while(k < branchVecI.leaves.size() || l < branchVecJ.leaves.size())
+	{
+		uint leafI = (k < branchVecI.leaves.size()) ? branchVecI.index[branchVecI.leaves[k]] : Node::NO_INDEX;
+		uint leafJ = (l < branchVecJ.leaves.size()) ? branchVecJ.index[branchVecJ.leaves[l]] : Node::NO_INDEX;
+
+		uint leaf = std::min<uint>(leafI, leafJ);
+		double valueI = 0;
+		double valueJ = 0;
+		if(leafI == leaf)
+			valueI = branchVecI.value[branchVecI.leaves[k++]];
+
+		if(leafJ == leaf)
+			valueJ = branchVecJ.value[branchVecJ.leaves[l++]];
+
+		sums.totalI += LeafMass(valueI, bPresence);
+		sums.totalJ += LeafMass(valueJ, bPresence);
+
+		if(valueI > 0 || valueJ > 0)
+			sums.numLeaves++;
+	}
+
+	// ancestors of a non-zero leaf node are non-zero, so every node with mass in either community is visited
+	uint rootIndex = m_parentIndex.size()-1;
+	SparseDataVectorPair pair(branchVecI, branchVecJ);
+	uint i;
+	double valueI, valueJ;
+	while(pair.Next(i, valueI, valueJ))
 	{
-		Node* curNode = m_breadthFirstOrder[i];
+		double massI = scratch.massI[i];
+		double massJ = scratch.massJ[i];
+		double massUnion = scratch.massUnion[i];
+		scratch.massI[i] = 0;
+		scratch.massJ[i] = 0;
 
-		if(!curNode->IsLeaf())
+		if(m_numChildren[i] == 0)
 		{
-			double sumAvgProps = 0;
-			double maxProp = 0;
-			std::vector<Node*> children = curNode->GetChildren();
-			for(uint c = 0; c < children.size(); ++c)
-			{
-				double propI = branchVecI[children[c]->GetPostOrderIndex()];
-				double propJ = branchVecJ[children[c]->GetPostOrderIndex()];
+			massI = LeafMass(valueI, bPresence);
+			massJ = LeafMass(valueJ, bPresence);
+			massUnion = (valueI > 0 || valueJ > 0) ? 1 : 0;
+		}
 
-				double avgProp = 0.5*(propI+propJ);
-				sumAvgProps += avgProp;
+		AddBranchDistance(m_branchLength[i], massI, massJ, sums);
 
-				if(avgProp > maxProp)
-					maxProp = avgProp;
+		if(m_parentIndex[i] != rootIndex)
+		{
+			scratch.massI[m_parentIndex[i]] += massI;
+			scratch.massJ[m_parentIndex[i]] += massJ;
+		}
 
-			}
+		if(bPresence)
+		{
+			scratch.massUnion[i] = 0;
+			sums.sumUnion += m_branchLength[i]*2*massUnion*(sums.numLeaves - massUnion);
+			if(m_parentIndex[i] != rootIndex)
+				scratch.massUnion[m_parentIndex[i]] += massUnion;
+		}
+	}
+}
 
-			double weight = sumAvgProps - maxProp;
+template<class T>
+void DataVectorizer::LeafSetRootDistance(const std::vector<T>& branchVecI, const std::vector<T>& branchVecJ, 
+																				 std::vector<double>& rootDistI, std::vector<double>& rootDistJ, ScratchArena& scratch) const
+{
+	// calculate distance from leaf nodes in community i or j weighted by seq. proportions
+	std::vector<uint>& leafSet = scratch.leafSet;
+	GetPairedLeafSet(branchVecI, branchVecJ, leafSet, rootDistI, rootDistJ);
+	for(uint k = 0; k < leafSet.size(); ++k)
+	{
+		double dist = GetDistanceToRoot(leafSet[k]);
+		rootDistI[k] *= dist;
+		rootDistJ[k] *= dist;
+	}
+}
 
-			if(curNode->IsRoot())
-				curNode->SetValue(weight);
-			else
-				curNode->SetValue(weight + curNode->GetParent()->GetValue());
+void DataVectorizer::LeafSetRootDistance(const SparseDataVector& branchVecI, const SparseDataVector& branchVecJ, 
+																				 std::vector<double>& rootDistI, std::vector<double>& rootDistJ, ScratchArena& scratch) const
+{
+	std::vector<uint>& leafSet = scratch.leafSet;
+	GetPairedLeafSet(branchVecI, branchVecJ, leafSet, rootDistI, rootDistJ);
+	for(uint k = 0; k < leafSet.size(); ++k)
+	{
+		double dist = GetDistanceToRoot(leafSet[k]);
+		rootDistI[k] *= dist;
+		rootDistJ[k] *= dist;
+	}
+}
+
+template<class T>
+bool DataVectorizer::ApplyWeightsMRCA(const std::vector<T>& branchVecI, const std::vector<T>& branchVecJ, std::vector<double>& nodeWeight, std::vector<T>& branchWeightsMRCA) const
+{
+	// calculate MRCA weighting of each node, visiting parents before their children 
+	// by traversing the post-order in reverse
+	uint rootIndex = m_parentIndex.size()-1;
+	nodeWeight.resize(m_parentIndex.size());
+	for(int i = (int)rootIndex; i >= 0; --i)
+	{
+		if(m_numChildren[i] == 0)
+			continue;
+
+		double sumAvgProps = 0;
+		double maxProp = 0;
+		const uint* child = &m_childIndex[m_firstChild[i]];
+		for(uint c = 0; c < m_numChildren[i]; ++c)
+		{
+			double propI = branchVecI[child[c]];
+			double propJ = branchVecJ[child[c]];
+
+			double avgProp = 0.5*(propI+propJ);
+			sumAvgProps += avgProp;
+
+			if(avgProp > maxProp)
+				maxProp = avgProp;
 		}
+
+		double weight = sumAvgProps - maxProp;
+
+		if(i == (int)rootIndex)
+			nodeWeight[i] = weight;
+		else
+			nodeWeight[i] = weight + nodeWeight[m_parentIndex[i]];
 	}
 
-	// get weightings for each branch in post-order traversal order
-	branchWeightsMRCA.clear();
+	// get weightings for each branch in post-order traversal order, summing them to 
+	// detect when all weighted branches are zero
+	branchWeightsMRCA.resize(m_size);
+	double branchSum = 0;
 	for(uint i = 0; i < m_size; ++i)
 	{
-		double branchLength = m_postOrder[i]->GetDistanceToParent();
-		double mrcaWeight = m_postOrder[i]->GetParent()->GetValue();
-		branchWeightsMRCA.push_back(mrcaWeight*branchLength);
+		branchWeightsMRCA[i] = (T)(nodeWeight[m_parentIndex[i]]*m_branchLength[i]);
+		branchSum += branchWeightsMRCA[i];
 	}
-}
\ No newline at end of file
+
+	return branchSum != 0;
+}
+
+// data vectors are stored in either double or single precision
+template void DataVectorizer::GetMRCARange(const std::vector<double>&, const std::vector<double>&, uint&, uint&) const;
+template void DataVectorizer::GetMRCARange(const std::vector<float>&, const std::vector<float>&, uint&, uint&) const;
+template void DataVectorizer::LeafSetMinDistance(const std::vector<double>&, const std::vector<double>&, std::vector<double>&, std::vector<double>&, ScratchArena&) const;
+template void DataVectorizer::LeafSetMinDistance(const std::vector<float>&, const std::vector<float>&, std::vector<double>&, std::vector<double>&, ScratchArena&) const;
+template void DataVectorizer::LeafSetDistanceSum(const std::vector<double>&, const std::vector<double>&, bool, LeafSetDistanceSums&, ScratchArena&) const;
+template void DataVectorizer::LeafSetDistanceSum(const std::vector<float>&, const std::vector<float>&, bool, LeafSetDistanceSums&, ScratchArena&) const;
+template void DataVectorizer::LeafSetRootDistance(const std::vector<double>&, const std::vector<double>&, std::vector<double>&, std::vector<double>&, ScratchArena&) const;
+template void DataVectorizer::LeafSetRootDistance(const std::vector<float>&, const std::vector<float>&, std::vector<double>&, std::vector<double>&, ScratchArena&) const;
+template bool DataVectorizer::ApplyWeightsMRCA(const std::vector<double>&, const std::vector<double>&, std::vector<double>&, std::vector<double>&) const;
+template bool DataVectorizer::ApplyWeightsMRCA(const std::vector<float>&, const std::vector<float>&, std::vector<double>&, std::vector<float>&) const;
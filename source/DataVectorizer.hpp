@@ -28,6 +28,178 @@
 #include "Tree.hpp"
 #include "Node.hpp"
 
+/**
+ * @brief Data vector storing only its non-zero entries.
+ */
+struct SparseDataVector
+{
+	/** Index of each non-zero entry in increasing order. */
+	std::vector<uint> index;
+
+	/** Value of each non-zero entry. */
+	std::vector<double> value;
+
+	/** Position in index of each entry associated with a leaf node. */
+	std::vector<uint> leaves;
+};
+
+/**
+ * @brief Presence/absence data vector with one bit per entry.
+ */
+struct BitDataVector
+{
+	/** Entry n is non-zero if bit n%64 of word n/64 is set. */
+	std::vector<uint64> bits;
+};
+
+/**
+ * @brief Sums over ordered pairs of leaf nodes of the product of their masses and distance.
+ */
+struct LeafSetDistanceSums
+{
+	/** Total mass of leaf nodes in community i. */
+	double totalI;
+
+	/** Total mass of leaf nodes in community j. */
+	double totalJ;
+
+	/** Number of leaf nodes present in either community. */
+	double numLeaves;
+
+	/** Sum over pairs with one leaf node from community i and one from community j. */
+	double sumIJ;
+
+	/** Sum over pairs with both leaf nodes from community i. */
+	double sumII;
+
+	/** Sum over pairs with both leaf nodes from community j. */
+	double sumJJ;
+
+	/** Sum of distances over pairs of leaf nodes present in either community (only found when leaf mass indicates presence). */
+	double sumUnion;
+};
+
+/**
+ * @brief Buffers reused for temporary values calculated when comparing each pair of samples.
+ *
+ * Each thread comparing pairs of samples has its own arena, held by its CompareContext and sized with 
+ * DataVectorizer::InitScratch(), so the shared data vectorizer is never written while comparing pairs. 
+ * Buffers are cleared but keep their capacity, so once they have grown to the largest size needed by a 
+ * pair no further memory is allocated.
+ */
+struct ScratchArena
+{
+	/** Post-order index of leaf nodes. */
+	std::vector<uint> leafSet;
+
+	/** Value for each leaf node in community i. */
+	std::vector<double> leafValuesI;
+
+	/** Value for each leaf node in community j. */
+	std::vector<double> leafValuesJ;
+
+	/** Mass of leaf nodes in community i pushed up to each node by its children (all zeros between pairs). */
+	std::vector<double> massI;
+
+	/** Mass of leaf nodes in community j pushed up to each node by its children (all zeros between pairs). */
+	std::vector<double> massJ;
+
+	/** Number of leaf nodes present in either community pushed up to each node by its children (all zeros between pairs). */
+	std::vector<double> massUnion;
+
+	/** Distance from each node to the nearest leaf node in community i (all DBL_MAX between pairs). */
+	std::vector<double> nearestI;
+
+	/** Distance from each node to the nearest leaf node in community j (all DBL_MAX between pairs). */
+	std::vector<double> nearestJ;
+
+	/** Nodes with an entry set in nearestI or nearestJ while comparing sparse branch vectors. */
+	std::vector<uint> nearestNodes;
+};
+
+/**
+ * @brief Buffers used to calculate the data vector of a sample.
+ *
+ * Samples can be vectorized concurrently by giving each thread its own buffers, sized with DataVectorizer::InitScratch().
+ */
+struct VectorizeScratch
+{
+	/** Data vector being calculated (all zeros between samples). */
+	std::vector<double> data;
+
+	/** Flag indicating if a node has been visited (all false between samples). */
+	std::vector<bool> bVisited;
+
+	/** Index of each non-zero entry of the data vector being calculated. */
+	std::vector<uint> nonZero;
+};
+
+/**
+ * @brief Visit entries which are non-zero in either of two sparse data vectors in increasing order.
+ */
+class SparseDataVectorPair
+{
+public:
+	/** Constructor. */
+	SparseDataVectorPair(const SparseDataVector& vecI, const SparseDataVector& vecJ)
+		: m_vecI(vecI), m_vecJ(vecJ), m_posI(0), m_posJ(0), m_endI(vecI.index.size()), m_endJ(vecJ.index.size()) {}
+
+	/** Constructor visiting only entries with an index in [begin, end). */
+	SparseDataVectorPair(const SparseDataVector& vecI, const SparseDataVector& vecJ, uint begin, uint end)
+		: m_vecI(vecI), m_vecJ(vecJ)
+	{
+		m_posI = std::lower_bound(vecI.index.begin(), vecI.index.end(), begin) - vecI.index.begin();
+		m_posJ = std::lower_bound(vecJ.index.begin(), vecJ.index.end(), begin) - vecJ.index.begin();
+		m_endI = std::lower_bound(vecI.index.begin() + m_posI, vecI.index.end(), end) - vecI.index.begin();
+		m_endJ = std::lower_bound(vecJ.index.begin() + m_posJ, vecJ.index.end(), end) - vecJ.index.begin();
+	}
+
+	/**
+	* @brief Get next entry.
+	*
+	* @param index Index of entry.
+	* @param valueI Value of entry in data vector i.
+	* @param valueJ Value of entry in data vector j.
+	* @return False if all entries have been visited, else true.
+	*/
+	bool Next(uint& index, double& valueI, double& valueJ)
+	{
+		bool bEndI = (m_posI == m_endI);
+		bool bEndJ = (m_posJ == m_endJ);
+		if(bEndI && bEndJ)
+			return false;
+
+		if(bEndJ || (!bEndI && m_vecI.index[m_posI] < m_vecJ.index[m_posJ]))
+		{
+			index = m_vecI.index[m_posI];
+			valueI = m_vecI.value[m_posI++];
+			valueJ = 0;
+		}
+		else if(bEndI || m_vecJ.index[m_posJ] < m_vecI.index[m_posI])
+		{
+			index = m_vecJ.index[m_posJ];
+			valueI = 0;
+			valueJ = m_vecJ.value[m_posJ++];
+		}
+		else
+		{
+			index = m_vecI.index[m_posI];
+			valueI = m_vecI.value[m_posI++];
+			valueJ = m_vecJ.value[m_posJ++];
+		}
+
+		return true;
+	}
+
+private:
+	const SparseDataVector& m_vecI;
+	const SparseDataVector& m_vecJ;
+	uint m_posI;
+	uint m_posJ;
+	uint m_endI;
+	uint m_endJ;
+};
+
 /**
  * @brief Calculate various vectorial representation of sequence data.
  */
@@ -35,7 +207,7 @@ class DataVectorizer
 {
 public:		
 	/** Constructor. */
-	DataVectorizer(): m_size(0), m_bWeighted(false), m_bPhylogenetic(false) {}
+	DataVectorizer(): m_size(0), m_bWeighted(false), m_bPhylogenetic(false), m_numLeaves(0) {}
 
 	/** Initialize. */
 	bool Init(Tree<Node>* tree, bool bPhylogenetic, bool bWeighted, bool bNormalize, const std::vector<std::string>& seqs);
@@ -50,71 +222,110 @@ public:
 	*/
 	void CalculateDataVector(const std::vector<double>& count, bool bLeavesOnly, double totalNumSeq, std::vector<double>& data);
 
-	/** 
-	* @brief Restrict branch vector to the MRCA tree.
+	/**
+	* @brief Calculate data vector for tree from non-zero count data.
 	*
-	* @param branchVecI Branch vector for sample i.
-	* @param branchVecJ Branch vector for sample j.
-	* @param MRCAi MRCA vector for sample i.
-	* @param MRCAj MRCA vector for sample j.
-	* @param branchWeight Branch weights over MRCA subtree.
+	* Only nodes on the path from a leaf node with a non-zero count to the root are visited. Variants 
+	* given the buffers of the calling thread can be called concurrently; other variants use buffers of this object.
+	*
+	* @param seqIndices Index of each sequence with a non-zero count.
+	* @param count Count data for each sequence in seqIndices.
+	* @param bLeavesOnly Flag indicating if data vector should only be calculated over leaf nodes.
+	* @param totalNumSeq Sum of count data.
+	* @param data Data to be calculated.
 	*/
-	void RestrictToMRCA(const std::vector<double>& branchVecI, const std::vector<double>& branchVecJ, std::vector<double>& MRCAi, std::vector<double>& MRCAj, std::vector<double>& branchWeight);
+	void CalculateDataVector(const std::vector<uint>& seqIndices, const std::vector<double>& count, bool bLeavesOnly, double totalNumSeq, std::vector<double>& data);
+	void CalculateDataVector(const std::vector<uint>& seqIndices, const std::vector<double>& count, bool bLeavesOnly, double totalNumSeq, std::vector<double>& data, VectorizeScratch& scratch) const;
 
-	/** 
-	* @brief Find proportion weighted minimum distance between leaf nodes of two communities.
+	/**
+	* @brief Calculate sparse data vector for tree from non-zero count data.
 	*
-	* @param branchVecI Branch vector for sample i.
-	* @param branchVecJ Branch vector for sample j.
-	* @param minLeafI Proportion weighted minimum distance from leaf nodes in community i to leaf nodes in community j. 
-	* @param minLeafJ Proportion weighted minimum distance from leaf nodes in community j to leaf nodes in community i. 
+	* Only nodes on the path from a leaf node with a non-zero count to the root are visited.
+	*
+	* @param seqIndices Index of each sequence with a non-zero count.
+	* @param count Count data for each sequence in seqIndices.
+	* @param totalNumSeq Sum of count data.
+	* @param data Data to be calculated.
 	*/
-	void LeafSetMinDistance(const std::vector<double>& branchVecI, const std::vector<double>& branchVecJ, std::vector<double>& minLeafI, std::vector<double>& minLeafJ);
+	void CalculateDataVector(const std::vector<uint>& seqIndices, const std::vector<double>& count, double totalNumSeq, SparseDataVector& data);
+	void CalculateDataVector(const std::vector<uint>& seqIndices, const std::vector<double>& count, double totalNumSeq, SparseDataVector& data, VectorizeScratch& scratch) const;
 
-	/** 
-	* @brief Find proportion weighted mean distance between leaf nodes of two communities.
+	/**
+	* @brief Calculate presence/absence data vector for tree from non-zero count data.
 	*
-	* @param branchVecI Branch vector for sample i.
-	* @param branchVecJ Branch vector for sample j.
-	* @param meanLeafI Proportion weighted mean distance from leaf nodes in community i to leaf nodes in community j. 
-	* @param meanLeafJ Proportion weighted mean distance from leaf nodes in community j to leaf nodes in community i. 
+	* @param seqIndices Index of each sequence with a non-zero count.
+	* @param count Count data for each sequence in seqIndices.
+	* @param totalNumSeq Sum of count data.
+	* @param data Data to be calculated.
 	*/
-	void LeafSetMeanDistance(const std::vector<double>& branchVecI, const std::vector<double>& branchVecJ, std::vector<double>& meanLeafI, std::vector<double>& meanLeafJ);
+	void CalculateDataVector(const std::vector<uint>& seqIndices, const std::vector<double>& count, double totalNumSeq, BitDataVector& data);
+	void CalculateDataVector(const std::vector<uint>& seqIndices, const std::vector<double>& count, double totalNumSeq, BitDataVector& data, VectorizeScratch& scratch) const;
+
+	/** Size buffers of a thread for calculating data vectors over the current tree. */
+	void InitScratch(VectorizeScratch& scratch) const;
+
+	/** Convert data vector to a presence/absence data vector. */
+	void ToBits(const std::vector<double>& data, BitDataVector& bitData) const;
+
+	/** Convert presence/absence data vector to an unweighted data vector. */
+	void ToDense(const BitDataVector& bitData, std::vector<double>& data) const;
+
+	/** Convert data vector to a sparse data vector. */
+	void ToSparse(const std::vector<double>& data, SparseDataVector& sparseData) const;
+
+	/** Convert sparse data vector to a data vector. */
+	void ToDense(const SparseDataVector& sparseData, std::vector<double>& data) const;
 
 	/** 
-	* @brief Find leaf sets for each community and distances between leaves.
+	* @brief Find the post-order range of nodes below the MRCA of leaf nodes in either community.
+	*
+	* A subtree occupies a contiguous range in post-order, so the MRCA is the lowest common ancestor
+	* of the first and last leaf node in either community.
 	*
 	* @param branchVecI Branch vector for sample i.
 	* @param branchVecJ Branch vector for sample j.
-	* @param leafPropI Proportions for leaves in sample i.
-	* @param leafPropJ Proportions for leaves in sample j.
-	* @param leafDistances Distances from a leaf in sample i to a leaf in sample j.
+	* @param firstNode Post-order index of first node in the MRCA subtree.
+	* @param mrcaNode Post-order index of root of the MRCA subtree, which follows all other nodes in the subtree.
 	*/
-	void LeafSetDistance(const std::vector<double>& branchVecI, const std::vector<double>& branchVecJ, 
-																					std::vector<double>& leafPropI, std::vector<double>& leafPropJ, 
-																					std::vector< std::vector<double> >& leafDistances);
+	template<class T>
+	void GetMRCARange(const std::vector<T>& branchVecI, const std::vector<T>& branchVecJ, uint& firstNode, uint& mrcaNode) const;
+
+	/** Find the post-order range of nodes below the MRCA of leaf nodes in either community given as sparse branch vectors. */
+	void GetMRCARange(const SparseDataVector& branchVecI, const SparseDataVector& branchVecJ, uint& firstNode, uint& mrcaNode) const;
 
 	/** 
-	* @brief Find leaf sets spanning two communities and distances between their leaves.
+	* @brief Find proportion weighted minimum distance between leaf nodes of two communities.
 	*
 	* @param branchVecI Branch vector for sample i.
 	* @param branchVecJ Branch vector for sample j.
-	* @param leafPropI Proportions for sample i for leaves in sample i or j.
-	* @param leafPropJ Proportions for sample j for leaves in sample i or j.
-	* @param leafDistances Distances from a leaf i to j.
+	* @param minLeafI Proportion weighted minimum distance from leaf nodes in community i to leaf nodes in community j. 
+	* @param minLeafJ Proportion weighted minimum distance from leaf nodes in community j to leaf nodes in community i. 
+	* @param scratch Buffers of the thread comparing the pair.
 	*/
-	void PairedLeafSetDistance(const std::vector<double>& branchVecI, const std::vector<double>& branchVecJ, 
-																					std::vector<double>& leafPropI, std::vector<double>& leafPropJ, 
-																					std::vector< std::vector<double> >& leafDistances);
+	template<class T>
+	void LeafSetMinDistance(const std::vector<T>& branchVecI, const std::vector<T>& branchVecJ, std::vector<double>& minLeafI, std::vector<double>& minLeafJ, ScratchArena& scratch) const;
+
+	/** Find proportion weighted minimum distance between leaf nodes of two communities given as sparse branch vectors, visiting only nodes on the path from their leaf nodes to the root. */
+	void LeafSetMinDistance(const SparseDataVector& branchVecI, const SparseDataVector& branchVecJ, std::vector<double>& minLeafI, std::vector<double>& minLeafJ, ScratchArena& scratch) const;
 
 	/** 
-	* @brief Get distances between leaves.
+	* @brief Find mass weighted sums of distances between leaf nodes of two communities.
+	*
+	* The distance between two leaf nodes is the length of the branches separating them, so each branch
+	* contributes its length times the mass of leaf nodes below the branch and the mass above the branch.
+	* This avoids finding the distance between each pair of leaf nodes.
 	*
-	* @param colSum Sum of proportions across all samples for each column in the data vector.
-	* @param leafColSum Sum of proportions across all samples for leaf nodes.
-	* @param leafDistances Distances from a leaf i to j.
+	* @param branchVecI Branch vector for sample i.
+	* @param branchVecJ Branch vector for sample j.
+	* @param bPresence Flag indicating if the mass of a leaf node is 1 when its proportion is exactly 1 and 0 otherwise, instead of its proportion.
+	* @param sums Sums over ordered pairs of leaf nodes.
+	* @param scratch Buffers of the thread comparing the pair.
 	*/
-	void FullLeafSetDistance(const std::vector<double>& colSum, std::vector<double>& leafColSum, std::vector< std::vector<double> >& leafDistances);
+	template<class T>
+	void LeafSetDistanceSum(const std::vector<T>& branchVecI, const std::vector<T>& branchVecJ, bool bPresence, LeafSetDistanceSums& sums, ScratchArena& scratch) const;
+
+	/** Find mass weighted sums of distances between leaf nodes of two communities given as sparse branch vectors. */
+	void LeafSetDistanceSum(const SparseDataVector& branchVecI, const SparseDataVector& branchVecJ, bool bPresence, LeafSetDistanceSums& sums, ScratchArena& scratch) const;
 
 	/** 
 	* @brief Find proportion weighted minimum distance between leaf nodes of two communities.
@@ -123,42 +334,95 @@ public:
 	* @param branchVecJ Branch vector for sample j.
 	* @param rootDistI Community i proportion weighted distances from leaf nodes in community i or j to the root. 
 	* @param rootDistJ Community j proportion weighted distances from leaf nodes in community i or j to the root. 
+	* @param scratch Buffers of the thread comparing the pair.
 	*/
-	void LeafSetRootDistance(const std::vector<double>& branchVecI, const std::vector<double>& branchVecJ, std::vector<double>& rootDistI, std::vector<double>& rootDistJ);
+	template<class T>
+	void LeafSetRootDistance(const std::vector<T>& branchVecI, const std::vector<T>& branchVecJ, std::vector<double>& rootDistI, std::vector<double>& rootDistJ, ScratchArena& scratch) const;
+
+	/** Find proportion weighted distances from leaf nodes of two communities given as sparse branch vectors to the root. */
+	void LeafSetRootDistance(const SparseDataVector& branchVecI, const SparseDataVector& branchVecJ, std::vector<double>& rootDistI, std::vector<double>& rootDistJ, ScratchArena& scratch) const;
 
 	/** 
 	* @brief Apply MRCA weightings to each branch.
 	*
+	* Only the caller's vectors are written, so pairs can be weighted concurrently with separate vectors.
+	*
 	* @param branchVecI Branch vector for sample i.
 	* @param branchVecJ Branch vector for sample j.
+	* @param nodeWeight Scratch vector set to the MRCA weighting of each node.
 	* @param branchWeightsMRCA MRCA weighted branch lengths in post-order traversal order.
+	* @return False if all MRCA weighted branches are zero, else true.
 	*/
-	void ApplyWeightsMRCA(const std::vector<double>& branchVecI, const std::vector<double>& branchVecJ, std::vector<double>& branchWeightsMRCA);
+	template<class T>
+	bool ApplyWeightsMRCA(const std::vector<T>& branchVecI, const std::vector<T>& branchVecJ, std::vector<double>& nodeWeight, std::vector<T>& branchWeightsMRCA) const;
 		
+	/** Size buffers of a thread for comparing pairs of samples over the current tree. */
+	void InitScratch(ScratchArena& scratch) const;
+
 	/** Get size of data vector. */
 	uint GetSize() const { return m_size; }
 
+	/** Get length of the branch above each node in post-order traversal order. */
+	const std::vector<double>& GetBranchLengths() const { return m_branchLength; }
+
 private:
 	/** 
-	* @brief Find proportion weighted distances between leaf nodes of two communities.
+	* @brief Calculate entries of data vector which are non-zero.
 	*
-	* @param branchVecI Branch vector for sample i.
-	* @param branchVecJ Branch vector for sample j.
-	* @param meanLeafI Proportion weighted distance from leaf nodes in community i to leaf nodes in community j. 
-	* @param meanLeafJ Proportion weighted distance from leaf nodes in community j to leaf nodes in community i. 
-	* @param bMinOrMean Calculate either minimum (true) or mean (false) distances between leaf nodes.
+	* @param seqIndices Index of each sequence with a non-zero count.
+	* @param count Count data for each sequence in seqIndices.
+	* @param bLeavesOnly Flag indicating if data vector should only be calculated over leaf nodes.
+	* @param totalNumSeq Sum of count data.
+	* @param data Data to be calculated, which must be all zeros.
+	* @param nonZero Index of each non-zero entry, with leaf nodes preceding internal nodes.
+	* @param bVisited Flag for each node, which must be all false.
 	*/
-	void LeafSetMinMeanDistance(const std::vector<double>& branchVecI, const std::vector<double>& branchVecJ, std::vector<double>& meanLeafI, std::vector<double>& meanLeafJ, bool bMinOrMean);
+	void CalculateNonZero(const std::vector<uint>& seqIndices, const std::vector<double>& count, bool bLeavesOnly, double totalNumSeq, 
+													std::vector<double>& data, std::vector<uint>& nonZero, std::vector<bool>& bVisited) const;
 
-private:
-	/** Tree for phylogenetic beta-diversity calculations. */
-	Tree<Node>* m_tree;
+	/** Get post-order index and proportion of leaf nodes in a community. */
+	template<class T>
+	void GetLeafSet(const std::vector<T>& branchVec, std::vector<uint>& leafSet, std::vector<double>& leafProp) const;
+
+	/** Get post-order index and proportion of leaf nodes in a community given as a sparse branch vector. */
+	void GetLeafSet(const SparseDataVector& branchVec, std::vector<uint>& leafSet, std::vector<double>& leafProp) const;
+
+	/** Get post-order index and proportions of leaf nodes in either of two communities. */
+	template<class T>
+	void GetPairedLeafSet(const std::vector<T>& branchVecI, const std::vector<T>& branchVecJ, 
+													std::vector<uint>& leafSet, std::vector<double>& leafPropI, std::vector<double>& leafPropJ) const;
+
+	/** Get post-order index and proportions of leaf nodes in either of two communities given as sparse branch vectors. */
+	void GetPairedLeafSet(const SparseDataVector& branchVecI, const SparseDataVector& branchVecJ, 
+													std::vector<uint>& leafSet, std::vector<double>& leafPropI, std::vector<double>& leafPropJ) const;
 
-	/** Vector of nodes in tree in post-order traversal order. */
-	std::vector<Node*> m_postOrder;
+	/** Build Euler tour of tree and sparse table over it for finding lowest common ancestors. */
+	void BuildLCAIndex();
 
-	/** Vector of nodes in tree in breadth-first traversal order. */
-	std::vector<Node*> m_breadthFirstOrder;
+	/** Get mass of a leaf node with the given proportion. */
+	static double LeafMass(double prop, bool bPresence) 
+	{ 
+		if(bPresence)
+			return (prop == 1) ? 1 : 0;
+
+		return (prop > 0) ? prop : 0; 
+	}
+
+	/** Add contribution of a branch separating the given mass of leaf nodes below it from the remaining mass above it. */
+	static void AddBranchDistance(double length, double massI, double massJ, LeafSetDistanceSums& sums)
+	{
+		sums.sumIJ += length*(massI*(sums.totalJ - massJ) + (sums.totalI - massI)*massJ);
+		sums.sumII += length*2*massI*(sums.totalI - massI);
+		sums.sumJJ += length*2*massJ*(sums.totalJ - massJ);
+	}
+
+	/** Get post-order index of the lowest common ancestor of two nodes given by their post-order index. */
+	uint GetLCA(uint node1, uint node2) const;
+
+	/** Get phylogenetic distance from node given by its post-order index to the root. */
+	double GetDistanceToRoot(uint node) const;
+
+private:
 
 	/** Flag indicating if weighted vectors are to be generated. */
 	bool m_bWeighted;
@@ -171,6 +435,60 @@ private:
 
 	/** Size of data vector. */
 	uint m_size;
+
+	/** Post-order index of the leaf node associated with each sequence. */
+	std::vector<uint> m_seqPostOrderIndex;
+
+	/** Index of the leaf node associated with each sequence amongst all leaf nodes in post-order. */
+	std::vector<uint> m_seqLeafIndex;
+
+	/** Post-order index of each leaf node in post-order. */
+	std::vector<uint> m_leafPostOrderIndex;
+
+	/** Sequence index of each node in post-order (NO_INDEX for internal nodes). */
+	std::vector<uint> m_nodeSeqIndex;
+
+	/** Post-order index of the parent of each node. */
+	std::vector<uint> m_parentIndex;
+
+	/** Start of the children of each node in m_childIndex. */
+	std::vector<uint> m_firstChild;
+
+	/** Number of children of each node. */
+	std::vector<uint> m_numChildren;
+
+	/** Post-order index of the children of each node, grouped by node. */
+	std::vector<uint> m_childIndex;
+
+	/** Post-order index of the first node in the subtree of each node. */
+	std::vector<uint> m_firstDescendant;
+
+	/** Length of the branch above each node. */
+	std::vector<double> m_branchLength;
+
+	/** Number of branches between each node and the root. */
+	std::vector<uint> m_depth;
+
+	/** Phylogenetic distance from each node to the root. */
+	std::vector<double> m_rootDistance;
+
+	/** Post-order index of nodes visited by an Euler tour of the tree. */
+	std::vector<uint> m_eulerTour;
+
+	/** Position of the first visit to each node in the Euler tour. */
+	std::vector<uint> m_eulerFirst;
+
+	/** Shallowest node in each run of 2^k entries of the Euler tour, with one level of the table for each k. */
+	std::vector<uint> m_lcaTable;
+
+	/** Floor of the base 2 logarithm of each run length. */
+	std::vector<uint> m_floorLog2;
+
+	/** Buffers used to calculate data vectors by variants not given the buffers of the calling thread. */
+	VectorizeScratch m_vectorizeScratch;
+
+	/** Number of leaf nodes in tree. */
+	uint m_numLeaves;
 };
 
 #endif
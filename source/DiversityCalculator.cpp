@@ -25,6 +25,7 @@
 #include "DiversityCalculator.hpp"
 
 #include "NewickIO.hpp"
+#include "AllocationCounter.hpp"
 
 std::set<std::string> DiversityCalculator::m_weightedCalculators;
 std::set<std::string> DiversityCalculator::m_unweightedCalculators;
@@ -34,8 +35,12 @@ DataVectorizer DiversityCalculator::m_dataVec;
 uint DiversityCalculator::m_numSamples;
 bool DiversityCalculator::m_bWeighted;
 double DiversityCalculator::m_totalBranchLen;
-std::vector< std::vector<double> > DiversityCalculator::m_dataVecRows;
-std::vector< std::vector<double> > DiversityCalculator::m_dataVecCols;
+DataVectorBlock DiversityCalculator::m_dataVecRows;
+DataVectorBlock DiversityCalculator::m_dataVecCols;
+const double DiversityCalculator::MAX_SPARSE_DENSITY = 0.125;
+const uint DiversityCalculator::DENSITY_SAMPLES = 32;
+const double DiversityCalculator::MIN_READ_COST = 1e-6;
+
 std::vector<double> DiversityCalculator::m_minExtent;
 std::vector<double> DiversityCalculator::m_maxExtent;
 std::vector<double> DiversityCalculator::m_colSum;
@@ -43,12 +48,17 @@ std::vector<double> DiversityCalculator::m_rowLeafSum;
 std::vector<double> DiversityCalculator::m_rowLeafSumSqrd;
 std::vector<double> DiversityCalculator::m_weightedRowSum;
 std::vector<double> DiversityCalculator::m_branchWeight;
+std::vector<float> DiversityCalculator::m_floatBranchWeight;
+std::vector<double> DiversityCalculator::m_bitWeightTable;
+bool DiversityCalculator::m_bBitPacking = true;
 
 DiversityCalculator::DiversityCalculator(const std::string& seqCountFile, const std::string& treeFile, 
 																				 const std::string& calcStr, uint maxDataVecs, bool bWeighted, 
-																				 bool bMRCA, bool bStrictMRCA, bool bCount, bool bVerbose)
-	: m_maxDataVecs(maxDataVecs), m_bMRCA(bMRCA), m_bStrictMRCA(bStrictMRCA), 
-		m_bCount(bCount), m_bVerbose(bVerbose), m_bPhylogenetic(false), m_bGood(true), m_tree(NULL)
+																				 bool bMRCA, bool bStrictMRCA, bool bCount, bool bVerbose, bool bMemoryMap, bool bIndexFile, uint cacheSize, uint streamMemory,
+																				 bool bSinglePrecision)
+	: m_floatCalculator(NULL), m_sparseCalculator(NULL), m_bitCalculator(NULL), m_maxDataVecs(maxDataVecs), m_jackknifeRep(0), m_bMRCA(bMRCA), m_bStrictMRCA(bStrictMRCA), 
+		m_bCount(bCount), m_bSinglePrecision(bSinglePrecision), m_bVerbose(bVerbose), m_bPhylogenetic(false), m_bGood(true), m_tree(NULL), m_density(1), m_numPairs(0), m_pairAllocations(0), 
+		m_requiredStatistics(0), m_validStatistics(0)
 {
 	std::clock_t divCalcStart = std::clock();
 
@@ -57,7 +67,9 @@ DiversityCalculator::DiversityCalculator(const std::string& seqCountFile, const
 
 	m_bWeighted = bWeighted;
 
-	if(!ReadSeqCountFile(seqCountFile))
+	m_dataVecCache.SetBudget((uint64)cacheSize*1024*1024);
+
+	if(!ReadSeqCountFile(seqCountFile, bMemoryMap, bIndexFile, streamMemory))
 		m_bGood = false;
 
 	if(m_bGood && !ReadTreeFile(treeFile))
@@ -87,10 +99,10 @@ DiversityCalculator::~DiversityCalculator()
 		delete m_tree;
 }
 
-bool DiversityCalculator::ReadSeqCountFile(const std::string& seqCountFile)
+bool DiversityCalculator::ReadSeqCountFile(const std::string& seqCountFile, bool bMemoryMap, bool bIndexFile, uint streamMemory)
 {
 	std::clock_t startSeqCount = std::clock();
-	if(!m_seqCountIO.Read(seqCountFile))
+	if(!m_seqCountIO.Read(seqCountFile, bMemoryMap, bIndexFile, streamMemory))
 		return false;
 
 	m_numSamples = m_seqCountIO.GetNumSamples();
@@ -101,6 +113,24 @@ bool DiversityCalculator::ReadSeqCountFile(const std::string& seqCountFile)
 	{
 		std::cout << "  Sequences in sequnce count file: " << m_seqCountIO.GetNumSeqs() << std::endl; 
 		std::cout << "  Samples in sequnce count file: " << m_seqCountIO.GetNumSamples() << std::endl;
+		if(m_seqCountIO.GetLongestRow() > 0)
+			std::cout << "  Longest sample in sequence count file: " << m_seqCountIO.GetLongestRow() << " bytes" << std::endl;
+		if(m_seqCountIO.IsMemoryMapped())
+			std::cout << "  Sequence count file is memory mapped." << std::endl;
+		if(m_seqCountIO.IsCompressed())
+			std::cout << "  Sequence count file is block compressed." << std::endl;
+		if(m_seqCountIO.IsIndexFileUsed())
+			std::cout << "  Start of each sample read from index file." << std::endl;
+		if(m_seqCountIO.IsSpilled())
+			std::cout << "  Sequence count file read from a stream and spilled to disk." << std::endl;
+		else if(m_seqCountIO.IsStream())
+			std::cout << "  Sequence count file read from a stream and held in memory." << std::endl;
+		else if(m_seqCountIO.GetFormat() == SeqCountIO::BINARY_FORMAT)
+			std::cout << "  Sequence count file is in binary format." << std::endl;
+		else if(m_seqCountIO.GetFormat() == SeqCountIO::SPARSE_TRIPLET_FORMAT)
+			std::cout << "  Sequence count file is in sparse triplet format." << std::endl;
+		else if(m_seqCountIO.GetFormat() == SeqCountIO::BIOM_FORMAT)
+			std::cout << "  Sequence count file is in BIOM format." << std::endl;
 		std::cout << "  Time to complete first pass through sequence count file: " << ( endSeqCount - startSeqCount ) / (double)CLOCKS_PER_SEC << " s" << std::endl; 
 		std::cout << std::endl;
 	}
@@ -147,10 +177,8 @@ bool DiversityCalculator::ReadTreeFile(const std::string& treeFile)
 	return true;
 }
 
-bool DiversityCalculator::SetCalculator(const std::string& calcStr)
+bool DiversityCalculator::SetCalculator(const std::string& calcStr, bool bCalculateStatistics)
 {
-	using namespace std::tr1::placeholders;
-
 	bool bNeedColumnExtents = false;
 	bool bNeedColumnSums = false;
 	bool bNeedRowLeafSums = false;
@@ -160,159 +188,216 @@ bool DiversityCalculator::SetCalculator(const std::string& calcStr)
 
 	std::string standardCalcStr;
 
+	m_floatCalculator = NULL;
+	m_sparseCalculator = NULL;
+	m_bitCalculator = NULL;
 	if(calcStr == "Bray-Curtis" || calcStr == "BC" || calcStr == "BrayCurtis")
 	{
 		standardCalcStr = "Bray-Curtis";
-		m_calculator = std::tr1::bind(&DiversityCalculator::BrayCurtis, _1, _2, _3, _4);
+		m_calculator = &DiversityCalculator::BrayCurtis;
+		m_floatCalculator = &DiversityCalculator::BrayCurtis;
+		m_sparseCalculator = &DiversityCalculator::BrayCurtis;
+		m_bitCalculator = &DiversityCalculator::BrayCurtis;
 	}
 	else if(calcStr == "Canberra")
 	{
 		standardCalcStr = "Canberra";
-		m_calculator = std::tr1::bind(&DiversityCalculator::Canberra, _1, _2, _3, _4);
+		m_calculator = &DiversityCalculator::Canberra;
+		m_floatCalculator = &DiversityCalculator::Canberra;
+		m_sparseCalculator = &DiversityCalculator::Canberra;
+		m_bitCalculator = &DiversityCalculator::Canberra;
 	}
 	else if(calcStr == "Chi-squared")
 	{
 		standardCalcStr = "Chi-squared";
 		bNeedColumnSums = true;
 		bNeedRowLeafSums = true;
-		m_calculator = std::tr1::bind(&DiversityCalculator::ChiSquared, _1, _2, _3, _4);
+		m_calculator = &DiversityCalculator::ChiSquared;
+		m_floatCalculator = &DiversityCalculator::ChiSquared;
 	}
 	else if(calcStr == "Coefficient of similarity" || calcStr == "CS" || calcStr == "CoefficientOfSimilarity")
 	{
 		standardCalcStr = "Coefficient of similarity";
-		m_calculator = std::tr1::bind(&DiversityCalculator::CoefficientOfSimilarity, _1, _2, _3, _4);
+		m_calculator = &DiversityCalculator::CoefficientOfSimilarity;
+		m_floatCalculator = &DiversityCalculator::CoefficientOfSimilarity;
+		m_sparseCalculator = &DiversityCalculator::CoefficientOfSimilarity;
+		m_bitCalculator = &DiversityCalculator::CoefficientOfSimilarity;
 	}
 	else if(calcStr == "Complete tree" || calcStr == "CT" || calcStr == "CompleteTree" || calcStr == "Complete Tree")
 	{
 		standardCalcStr = "Complete tree";
 		bNeedColumnExtents = true;
-		m_calculator = std::tr1::bind(&DiversityCalculator::CompleteTree, _1, _2, _3, _4);
+		m_calculator = &DiversityCalculator::CompleteTree;
+		m_floatCalculator = &DiversityCalculator::CompleteTree;
 	}
 	else if(calcStr == "Euclidean")
 	{
 		standardCalcStr = "Euclidean";
-		m_calculator = std::tr1::bind(&DiversityCalculator::Euclidean, _1, _2, _3, _4);
+		m_calculator = &DiversityCalculator::Euclidean;
+		m_floatCalculator = &DiversityCalculator::Euclidean;
+		m_sparseCalculator = &DiversityCalculator::Euclidean;
+		m_bitCalculator = &DiversityCalculator::Euclidean;
 	}
 	else if(calcStr == "Fst")
 	{
 		standardCalcStr = "Fst";
-		m_calculator = std::tr1::bind(&DiversityCalculator::Fst, _1, _2, _3, _4);
+		m_calculator = &DiversityCalculator::Fst;
+		m_floatCalculator = &DiversityCalculator::Fst;
+		m_sparseCalculator = &DiversityCalculator::Fst;
 	}
 	else if(calcStr == "Gower")
 	{
 		standardCalcStr = "Gower";
 		bNeedColumnExtents = true;
-		m_calculator = std::tr1::bind(&DiversityCalculator::Gower, _1, _2, _3, _4);
+		m_calculator = &DiversityCalculator::Gower;
+		m_floatCalculator = &DiversityCalculator::Gower;
 	}
 	else if(calcStr == "Hellinger")
 	{
 		standardCalcStr = "Hellinger";
 		bNeedRowLeafSums = true;
-		m_calculator = std::tr1::bind(&DiversityCalculator::Hellinger, _1, _2, _3, _4);
+		m_calculator = &DiversityCalculator::Hellinger;
+		m_floatCalculator = &DiversityCalculator::Hellinger;
 	}
 	else if(calcStr == "Kulczynski")
 	{
 		standardCalcStr = "Kulczynski";
 		bNeedWeightedRowSums = true;
-		m_calculator = std::tr1::bind(&DiversityCalculator::Kulczynski, _1, _2, _3, _4);
+		m_calculator = &DiversityCalculator::Kulczynski;
+		m_floatCalculator = &DiversityCalculator::Kulczynski;
+		m_sparseCalculator = &DiversityCalculator::Kulczynski;
+		m_bitCalculator = &DiversityCalculator::Kulczynski;
 	}
 	else if(calcStr == "Lennon compositional difference" || calcStr == "Lennon" || calcStr == "LCD")
 	{
 		standardCalcStr = "Lennon compositional difference";
-		m_calculator = std::tr1::bind(&DiversityCalculator::LennonCD, _1, _2, _3, _4);
+		m_calculator = &DiversityCalculator::LennonCD;
+		m_floatCalculator = &DiversityCalculator::LennonCD;
+		m_sparseCalculator = &DiversityCalculator::LennonCD;
+		m_bitCalculator = &DiversityCalculator::LennonCD;
 	}
 	else if(calcStr == "Lennon local richness gradient" || calcStr == "LLRG")
 	{
 		standardCalcStr = "Lennon local richness gradient";
-		m_calculator = std::tr1::bind(&DiversityCalculator::LennonLRG, _1, _2, _3, _4);
+		m_calculator = &DiversityCalculator::LennonLRG;
+		m_floatCalculator = &DiversityCalculator::LennonLRG;
+		m_sparseCalculator = &DiversityCalculator::LennonLRG;
 	}
 	else if(calcStr == "Manhattan")
 	{
 		standardCalcStr = "Manhattan";
-		m_calculator = std::tr1::bind(&DiversityCalculator::Manhattan, _1, _2, _3, _4);
+		m_calculator = &DiversityCalculator::Manhattan;
+		m_floatCalculator = &DiversityCalculator::Manhattan;
+		m_sparseCalculator = &DiversityCalculator::Manhattan;
+		m_bitCalculator = &DiversityCalculator::Manhattan;
 	}
 	else if(calcStr == "Mean nearest neighbour distance"|| calcStr == "MNND")
 	{
 		standardCalcStr = "MNND";
-		m_calculator = std::tr1::bind(&DiversityCalculator::MNND, _1, _2, _3, _4);
+		m_calculator = &DiversityCalculator::MNND;
+		m_floatCalculator = &DiversityCalculator::MNND;
+		m_sparseCalculator = &DiversityCalculator::MNND;
 	}
 	else if(calcStr == "Mean phylogenetic distance"|| calcStr == "MPD")
 	{
 		standardCalcStr = "MPD";
-		m_calculator = std::tr1::bind(&DiversityCalculator::MPD, _1, _2, _3, _4);
+		m_calculator = &DiversityCalculator::MPD;
+		m_floatCalculator = &DiversityCalculator::MPD;
+		m_sparseCalculator = &DiversityCalculator::MPD;
 	}
 	else if(calcStr == "Morisita-Horn"|| calcStr == "MH" || calcStr == "MorisitaHorn")
 	{
 		standardCalcStr = "Morisita-Horn";
 		bNeedWeightedRowSums = true;
-		m_calculator = std::tr1::bind(&DiversityCalculator::MorisitaHorn, _1, _2, _3, _4);
+		m_calculator = &DiversityCalculator::MorisitaHorn;
+		m_floatCalculator = &DiversityCalculator::MorisitaHorn;
+		m_sparseCalculator = &DiversityCalculator::MorisitaHorn;
 	}
 	else if(calcStr == "Normalized weighted UniFrac" || calcStr == "NWU" || calcStr == "NormalizedWeightedUniFrac" || calcStr == "Normalized Weighted UniFrac")
 	{
 		standardCalcStr = "Normalized Weighted UniFrac";
-		m_calculator = std::tr1::bind(&DiversityCalculator::NormalizedWeightedUniFrac, _1, _2, _3, _4);
+		m_calculator = &DiversityCalculator::NormalizedWeightedUniFrac;
+		m_floatCalculator = &DiversityCalculator::NormalizedWeightedUniFrac;
+		m_sparseCalculator = &DiversityCalculator::NormalizedWeightedUniFrac;
 	}
 	else if(calcStr == "Pearson")
 	{
 		standardCalcStr = "Pearson";
 		bNeedWeightedRowSums = true;
-		m_calculator = std::tr1::bind(&DiversityCalculator::Pearson, _1, _2, _3, _4);
+		m_calculator = &DiversityCalculator::Pearson;
+		m_floatCalculator = &DiversityCalculator::Pearson;
 	}
 	else if(calcStr == "Rao's Hp" || calcStr == "RHp" || calcStr == "RaoHp" || calcStr == "RD")
 	{
 		standardCalcStr = "Rao's Hp";
-		m_calculator = std::tr1::bind(&DiversityCalculator::RaoHp, _1, _2, _3, _4);
+		m_calculator = &DiversityCalculator::RaoHp;
+		m_floatCalculator = &DiversityCalculator::RaoHp;
+		m_sparseCalculator = &DiversityCalculator::RaoHp;
 	}
 	else if(calcStr == "Soergel" || calcStr == "Ruzicka")
 	{
 		standardCalcStr = "Soergel";
-		m_calculator = std::tr1::bind(&DiversityCalculator::Soergel, _1, _2, _3, _4);
+		m_calculator = &DiversityCalculator::Soergel;
+		m_floatCalculator = &DiversityCalculator::Soergel;
+		m_sparseCalculator = &DiversityCalculator::Soergel;
+		m_bitCalculator = &DiversityCalculator::Soergel;
 	}
 	else if(calcStr == "Species profile" || calcStr == "SP" || calcStr == "SpeciesProfile")
 	{
 		standardCalcStr = "Species profile";
 		bNeedRowLeafSums = true;
-		m_calculator = std::tr1::bind(&DiversityCalculator::SpeciesProfile, _1, _2, _3, _4);
+		m_calculator = &DiversityCalculator::SpeciesProfile;
+		m_floatCalculator = &DiversityCalculator::SpeciesProfile;
 	}
 	else if(calcStr == "Tamas coefficient" || calcStr == "TC" || calcStr == "TamasCoefficient")
 	{
 		standardCalcStr = "Tamas coefficient";
 		bNeedColumnExtents = true;
-		m_calculator = std::tr1::bind(&DiversityCalculator::TamasCoefficient, _1, _2, _3, _4);
+		m_calculator = &DiversityCalculator::TamasCoefficient;
+		m_floatCalculator = &DiversityCalculator::TamasCoefficient;
 	}
 	else if(calcStr == "Weighted correlation" || calcStr == "WC" || calcStr == "WeightedCorrelation")
 	{
 		standardCalcStr = "Weighted correlation";
 		bNeedTotalBranchLen = true;
 		bNeedWeightedRowSums = true;
-		m_calculator = std::tr1::bind(&DiversityCalculator::WeightedCorrelation, _1, _2, _3, _4);
+		m_calculator = &DiversityCalculator::WeightedCorrelation;
+		m_floatCalculator = &DiversityCalculator::WeightedCorrelation;
 	}
 	else if(calcStr == "Whittaker")
 	{
 		standardCalcStr = "Whittaker";
 		bNeedRowLeafSums = true;
-		m_calculator = std::tr1::bind(&DiversityCalculator::Whittaker, _1, _2, _3, _4);
+		m_calculator = &DiversityCalculator::Whittaker;
+		m_floatCalculator = &DiversityCalculator::Whittaker;
 	}
 	else if(calcStr == "Yue-Clayton" || calcStr == "YC" || calcStr == "YueClayton")
 	{
 		standardCalcStr = "Yue-Clayton";
-		m_calculator = std::tr1::bind(&DiversityCalculator::YueClayton, _1, _2, _3, _4);
+		m_calculator = &DiversityCalculator::YueClayton;
+		m_floatCalculator = &DiversityCalculator::YueClayton;
+		m_sparseCalculator = &DiversityCalculator::YueClayton;
 	}
 	else if(calcStr == "Unit")
 	{
 		standardCalcStr = "SPECIAL";
-		m_calculator = std::tr1::bind(&DiversityCalculator::Unit, _1, _2, _3, _4);
+		m_calculator = &DiversityCalculator::Unit;
+		m_floatCalculator = &DiversityCalculator::Unit;
+		m_sparseCalculator = &DiversityCalculator::Unit;
 	}
 	else if(calcStr == "Sum")
 	{
 		standardCalcStr = "SPECIAL";
-		m_calculator = std::tr1::bind(&DiversityCalculator::Sum, _1, _2, _3, _4);
+		m_calculator = &DiversityCalculator::Sum;
+		m_floatCalculator = &DiversityCalculator::Sum;
+		m_sparseCalculator = &DiversityCalculator::Sum;
 	}
 	else if(calcStr == "Extents")
 	{
 		standardCalcStr = "SPECIAL";
 		bNeedColumnExtents = true;
-		m_calculator = std::tr1::bind(&DiversityCalculator::Extents, _1, _2, _3, _4);
+		m_calculator = &DiversityCalculator::Extents;
+		m_floatCalculator = &DiversityCalculator::Extents;
 	}
 	else
 	{
@@ -336,23 +421,27 @@ bool DiversityCalculator::SetCalculator(const std::string& calcStr)
 	}
 	
 
-	// required to calculate intermediate terms
-	GetBranchWeights();
-
+	m_requiredStatistics = 0;
 	if(bNeedColumnExtents)
-		CalculateColumnExtents();
+		m_requiredStatistics |= COLUMN_EXTENTS;
 
 	if(bNeedColumnSums)
-		CalculateColumnSums();
+		m_requiredStatistics |= COLUMN_SUMS;
 
 	if(bNeedRowLeafSums)
-		CalculateRowLeafSums(false);
+		m_requiredStatistics |= ROW_LEAF_SUMS;
 
 	if(bNeedRowLeafSumsSqrd)
-		CalculateRowLeafSums(true);
+		m_requiredStatistics |= ROW_LEAF_SUMS_SQRD;
 
 	if(bNeedWeightedRowSums)
-		CalculateWeightedRowSums();
+		m_requiredStatistics |= WEIGHTED_ROW_SUMS;
+
+	// required to calculate intermediate terms
+	GetBranchWeights();
+
+	if(bCalculateStatistics)
+		CalculateStatistics(m_requiredStatistics);
 
 	if(bNeedTotalBranchLen)
 	{
@@ -364,160 +453,278 @@ bool DiversityCalculator::SetCalculator(const std::string& calcStr)
 	return true;
 }
 
-void DiversityCalculator::CalculateDataVectors(uint startIndex, uint numSamples, std::vector< std::vector<double> >& dataVec, uint seqsToDraw)
+void DiversityCalculator::CalculateDataVectors(uint startIndex, uint numSamples, DataVectorBlock& block, uint seqsToDraw, uint numThreads)
 {
-	std::clock_t startDataVecs = std::clock();
+	bool bSparse = IsSparse();
+	bool bBitPacked = IsBitPacked();
+
+	uint endIndex = std::min<uint>(m_seqCountIO.GetNumSamples(), startIndex+numSamples);
+	uint blockSize = (endIndex > startIndex) ? endIndex - startIndex : 0;
 	
-	// calculate data vector for each sample
-	dataVec.clear();
-	dataVec.reserve(numSamples);
-	for(uint i = startIndex; i < std::min<uint>(m_seqCountIO.GetNumSamples(), startIndex+numSamples); ++i)
-	{		
-		std::vector<double> count;
-		double totalNumSeq;
-		m_seqCountIO.GetData(i, count, totalNumSeq, seqsToDraw);
+	block.Clear();
+	if(bBitPacked)
+		block.bitDataVec.resize(blockSize);
+	else if(bSparse)
+		block.sparseDataVec.resize(blockSize);
+	else if(m_bSinglePrecision)
+		block.floatDataVec.resize(blockSize);
+	else
+		block.dataVec.resize(blockSize);
 
-		std::vector<double> prop;
-		m_dataVec.CalculateDataVector(count, false, totalNumSeq, prop);
-		dataVec.push_back(prop);
-	}
+	// samples are vectorized concurrently, each thread with its own buffers
+	std::vector<VectorizeScratch> scratch(std::max<uint>(numThreads, 1));
+	for(uint t = 0; t < scratch.size(); ++t)
+		m_dataVec.InitScratch(scratch[t]);
 
-	std::clock_t endDataVecs = std::clock();
+	#pragma omp parallel for schedule(dynamic) num_threads(numThreads) if(numThreads > 1)
+	for(int k = 0; k < (int)blockSize; ++k)
+	{
+		uint thread = 0;
+#ifdef _OPENMP
+		thread = omp_get_thread_num();
+#endif
+		CalculateDataVector(startIndex + k, k, block, seqsToDraw, scratch[thread]);
+	}
 }
 
-void DiversityCalculator::CalculateColumnExtents()
+void DiversityCalculator::CalculateDataVector(uint index, uint k, DataVectorBlock& block, uint seqsToDraw, VectorizeScratch& scratch)
 {
-	std::clock_t extentsStart = std::clock();
+	bool bSparse = IsSparse();
+	bool bBitPacked = IsBitPacked();
 
-	m_minExtent.clear();
-	m_maxExtent.clear();
-	m_minExtent.resize(m_dataVec.GetSize(), std::numeric_limits<double>::max());
-	m_maxExtent.resize(m_dataVec.GetSize(), 0);
-
-	for(uint i = 0; i < m_seqCountIO.GetNumSamples(); ++i)
+	// jackknife replicates draw a new set of sequences each time so are never cached, and
+	// data vectors are cached in the representation used to compare samples
+	if(seqsToDraw == 0)
 	{
-		std::vector<double> count;
-		double totalNumSeq;
-		m_seqCountIO.GetData(i, count, totalNumSeq);
+		bool bCached = false;
 
-		std::vector<double> prop;
-		m_dataVec.CalculateDataVector(count, false, totalNumSeq, prop);
-	
-		for(uint j = 0; j < prop.size(); ++j)
+		#pragma omp critical(DataVectorCache)
 		{
-			if(prop[j] < m_minExtent[j])
-				m_minExtent[j] = prop[j];
-
-			if(prop[j] > m_maxExtent[j])
-				m_maxExtent[j] = prop[j];
+			if(bBitPacked)
+			{
+				const BitDataVector* cachedBits = m_dataVecCache.GetBits(index);
+				if(cachedBits != NULL)
+				{
+					block.bitDataVec[k] = *cachedBits;
+					bCached = true;
+				}
+			}
+			else if(bSparse)
+			{
+				const SparseDataVector* cachedSparse = m_dataVecCache.GetSparse(index);
+				if(cachedSparse != NULL)
+				{
+					block.sparseDataVec[k] = *cachedSparse;
+					bCached = true;
+				}
+			}
+			else if(m_bSinglePrecision)
+			{
+				const std::vector<float>* cachedFloat = m_dataVecCache.GetFloat(index);
+				if(cachedFloat != NULL)
+				{
+					block.floatDataVec[k] = *cachedFloat;
+					bCached = true;
+				}
+			}
+			else
+			{
+				const std::vector<double>* cachedProp = m_dataVecCache.Get(index);
+				if(cachedProp != NULL)
+				{
+					block.dataVec[k] = *cachedProp;
+					bCached = true;
+				}
+			}
 		}
-	}
 
-	std::clock_t extentsEnd = std::clock();
+		if(bCached)
+			return;
+	}
 
-	if(m_bVerbose)
+	// the cost of a sample is the time to read and vectorize it, excluding time spent waiting for other threads
+	std::vector<uint> seqIndices;
+	std::vector<double> count;
+	double totalNumSeq;
+	double readStart;
+	#pragma omp critical(SeqCountIO)
 	{
-		std::cout << "  Time to calculate column extents: " << ( extentsEnd - extentsStart ) / (double)CLOCKS_PER_SEC << " s" << std::endl; 
-		std::cout << std::endl;
+		readStart = WallTime();
+		m_seqCountIO.GetSparseData(index, seqIndices, count, totalNumSeq);
 	}
-}
-
-void DiversityCalculator::CalculateColumnSums()
-{
-	std::clock_t colSumStart = std::clock();
 
-	m_colSum.clear();
-	m_colSum.resize(m_dataVec.GetSize(), 0);
+	if(seqsToDraw != 0)
+		m_subsampler.Draw(m_jackknifeRep, index, seqIndices, count, totalNumSeq, seqsToDraw);
 
-	for(uint i = 0; i < m_seqCountIO.GetNumSamples(); ++i)
+	if(bBitPacked)
+		m_dataVec.CalculateDataVector(seqIndices, count, totalNumSeq, block.bitDataVec[k], scratch);
+	else if(bSparse)
+		m_dataVec.CalculateDataVector(seqIndices, count, totalNumSeq, block.sparseDataVec[k], scratch);
+	else if(m_bSinglePrecision)
 	{
-		std::vector<double> count;
-		double totalNumSeq;
-		m_seqCountIO.GetData(i, count, totalNumSeq);
+		// data vectors are always calculated in double precision
+		std::vector<double> dataVec;
+		m_dataVec.CalculateDataVector(seqIndices, count, false, totalNumSeq, dataVec, scratch);
+		block.floatDataVec[k].assign(dataVec.begin(), dataVec.end());
+	}
+	else
+		m_dataVec.CalculateDataVector(seqIndices, count, false, totalNumSeq, block.dataVec[k], scratch);
 
-		std::vector<double> prop;
-		m_dataVec.CalculateDataVector(count, false, totalNumSeq, prop);
+	if(seqsToDraw != 0)
+		return;
 
-		for(uint j = 0; j < prop.size(); ++j)
-			m_colSum[j] += prop[j];
+	double cost = WallTime() - readStart + MIN_READ_COST;
+	#pragma omp critical(DataVectorCache)
+	{
+		if(bBitPacked)
+			m_dataVecCache.Insert(index, block.bitDataVec[k], cost);
+		else if(bSparse)
+			m_dataVecCache.Insert(index, block.sparseDataVec[k], cost);
+		else if(m_bSinglePrecision)
+			m_dataVecCache.Insert(index, block.floatDataVec[k], cost);
+		else
+			m_dataVecCache.Insert(index, block.dataVec[k], cost);
 	}
+}
 
-	std::clock_t colSumEnd = std::clock();
+double DiversityCalculator::WallTime()
+{
+#ifdef _OPENMP
+	return omp_get_wtime();
+#else
+	return std::clock() / (double)CLOCKS_PER_SEC;
+#endif
+}
 
-	if(m_bVerbose)
+void DiversityCalculator::CacheDataVector(uint index, const std::vector<double>& dataVec, double cost)
+{
+	if(IsBitPacked())
 	{
-		std::cout << "  Time to calculate column sums: " << ( colSumEnd - colSumStart ) / (double)CLOCKS_PER_SEC << " s" << std::endl; 
-		std::cout << std::endl;
+		BitDataVector bitDataVec;
+		m_dataVec.ToBits(dataVec, bitDataVec);
+		m_dataVecCache.Insert(index, bitDataVec, cost);
 	}
+	else if(IsSparse())
+	{
+		SparseDataVector sparseDataVec;
+		m_dataVec.ToSparse(dataVec, sparseDataVec);
+		m_dataVecCache.Insert(index, sparseDataVec, cost);
+	}
+	else if(m_bSinglePrecision)
+		m_dataVecCache.Insert(index, std::vector<float>(dataVec.begin(), dataVec.end()), cost);
+	else
+		m_dataVecCache.Insert(index, dataVec, cost);
 }
 
-void DiversityCalculator::CalculateRowLeafSums(bool bSquared)
+void DiversityCalculator::CalculateStatistics(uint statistics)
 {
-	std::clock_t rowSumStart = std::clock();
+	// statistics remain valid until the data vectorizer is initialized again
+	statistics &= ~m_validStatistics;
+	if(statistics == 0)
+		return;
+
+	std::clock_t statisticsStart = std::clock();
+
+	if(statistics & COLUMN_EXTENTS)
+	{
+		m_minExtent.clear();
+		m_maxExtent.clear();
+		m_minExtent.resize(m_dataVec.GetSize(), std::numeric_limits<double>::max());
+		m_maxExtent.resize(m_dataVec.GetSize(), 0);
+	}
 
-	if(!bSquared)
+	if(statistics & COLUMN_SUMS)
+	{
+		m_colSum.clear();
+		m_colSum.resize(m_dataVec.GetSize(), 0);
+	}
+
+	if(statistics & ROW_LEAF_SUMS)
 	{
 		m_rowLeafSum.clear();
 		m_rowLeafSum.resize(m_seqCountIO.GetNumSamples(), 0);
 	}
-	else
+
+	if(statistics & ROW_LEAF_SUMS_SQRD)
 	{
 		m_rowLeafSumSqrd.clear();
 		m_rowLeafSumSqrd.resize(m_seqCountIO.GetNumSamples(), 0);
 	}
 
+	if(statistics & WEIGHTED_ROW_SUMS)
+	{
+		m_weightedRowSum.clear();
+		m_weightedRowSum.resize(m_seqCountIO.GetNumSamples(), 0);
+	}
+
+	// read and vectorize each sample once for all requested statistics
+	bool bNeedProp = (statistics & (COLUMN_EXTENTS | COLUMN_SUMS | WEIGHTED_ROW_SUMS)) != 0;
+	bool bNeedLeafProp = (statistics & (ROW_LEAF_SUMS | ROW_LEAF_SUMS_SQRD)) != 0;
 	for(uint i = 0; i < m_seqCountIO.GetNumSamples(); ++i)
 	{
+		double readStart = WallTime();
+
+		// data vectors calculated here are cached for calculating dissimilarities
+		const std::vector<double>* cachedProp = bNeedProp ? m_dataVecCache.Get(i) : NULL;
+
+		std::vector<uint> seqIndices;
 		std::vector<double> count;
 		double totalNumSeq;
-		m_seqCountIO.GetData(i, count, totalNumSeq);
+		if(cachedProp == NULL || bNeedLeafProp)
+			m_seqCountIO.GetSparseData(i, seqIndices, count, totalNumSeq);
 
-		std::vector<double> leafProp;
-		m_dataVec.CalculateDataVector(count, true, totalNumSeq, leafProp);
-
-		for(uint j = 0; j < leafProp.size(); ++j)
+		if(bNeedProp)
 		{
-			if(!bSquared)
-				m_rowLeafSum[i] += leafProp[j];
-			else
-				m_rowLeafSumSqrd[i] += leafProp[j]*leafProp[j];
-		}
-	}
+			std::vector<double> calculatedProp;
+			if(cachedProp == NULL)
+			{
+				m_dataVec.CalculateDataVector(seqIndices, count, false, totalNumSeq, calculatedProp);
+				CacheDataVector(i, calculatedProp, WallTime() - readStart + MIN_READ_COST);
+			}
+			const std::vector<double>& prop = (cachedProp != NULL) ? *cachedProp : calculatedProp;
 
-	std::clock_t rowSumEnd = std::clock();
+			for(uint j = 0; j < prop.size(); ++j)
+			{
+				if(statistics & COLUMN_EXTENTS)
+				{
+					if(prop[j] < m_minExtent[j])
+						m_minExtent[j] = prop[j];
 
-	if(m_bVerbose)
-	{
-		std::cout << "  Time to calculate row sums: " << ( rowSumEnd - rowSumStart ) / (double)CLOCKS_PER_SEC << " s" << std::endl; 
-		std::cout << std::endl;
-	}
-}
+					if(prop[j] > m_maxExtent[j])
+						m_maxExtent[j] = prop[j];
+				}
 
-void DiversityCalculator::CalculateWeightedRowSums()
-{
-	std::clock_t weightedRowSumStart = std::clock();
+				if(statistics & COLUMN_SUMS)
+					m_colSum[j] += prop[j];
 
-	m_weightedRowSum.clear();
-	m_weightedRowSum.resize(m_seqCountIO.GetNumSamples(), 0);
+				if(statistics & WEIGHTED_ROW_SUMS)
+					m_weightedRowSum[i] += m_branchWeight[j] * prop[j];
+			}
+		}
 
-	for(uint i = 0; i < m_seqCountIO.GetNumSamples(); ++i)
-	{
-		std::vector<double> count;
-		double totalNumSeq;
-		m_seqCountIO.GetData(i, count, totalNumSeq);
+		if(bNeedLeafProp)
+		{
+			std::vector<double> leafProp;
+			m_dataVec.CalculateDataVector(seqIndices, count, true, totalNumSeq, leafProp);
 
-		std::vector<double> prop;
-		m_dataVec.CalculateDataVector(count, false, totalNumSeq, prop);
+			for(uint j = 0; j < leafProp.size(); ++j)
+			{
+				if(statistics & ROW_LEAF_SUMS)
+					m_rowLeafSum[i] += leafProp[j];
 
-		for(uint j = 0; j < prop.size(); ++j)
-			m_weightedRowSum[i] += m_branchWeight[j] * prop[j];
+				if(statistics & ROW_LEAF_SUMS_SQRD)
+					m_rowLeafSumSqrd[i] += leafProp[j]*leafProp[j];
+			}
+		}
 	}
 
-	std::clock_t weightedRowSumEnd = std::clock();
+	m_validStatistics |= statistics;
+
+	std::clock_t statisticsEnd = std::clock();
 
 	if(m_bVerbose)
 	{
-		std::cout << "  Time to calculate weighted row sums: " << ( weightedRowSumEnd - weightedRowSumStart ) / (double)CLOCKS_PER_SEC << " s" << std::endl; 
+		std::cout << "  Time to calculate column and row statistics: " << ( statisticsEnd - statisticsStart ) / (double)CLOCKS_PER_SEC << " s" << std::endl; 
 		std::cout << std::endl;
 	}
 }
@@ -525,25 +732,42 @@ void DiversityCalculator::CalculateWeightedRowSums()
 void DiversityCalculator::GetBranchWeights()
 {
 	if(m_bPhylogenetic)
-	{
-		std::vector<Node*> postOrder = m_tree->PostOrder(m_tree->GetRootNode());
-
-		m_branchWeight.clear();
-		m_branchWeight.reserve(postOrder.size());
-
-		std::vector<Node*>::const_iterator it;
-		for(it = postOrder.begin(); it != postOrder.end(); ++it)
-		{
-			Node* curNode = *it;
-			m_branchWeight.push_back(curNode->GetDistanceToParent());
-		}
-	}
+		m_branchWeight = m_dataVec.GetBranchLengths();
 	else
 	{
 		// create a star tree
 		m_branchWeight.clear();
 		m_branchWeight.resize(m_seqCountIO.GetNumSeqs(), 1);
 	}
+
+	m_floatBranchWeight.assign(m_branchWeight.begin(), m_branchWeight.end());
+
+	if(IsBitPacked())
+		BuildBitWeightTable();
+	else
+		m_bitWeightTable.clear();
+}
+
+void DiversityCalculator::BuildBitWeightTable()
+{
+	// the weight of each nibble value is the weight of the nibble value without its lowest set bit
+	// plus the branch weight of that bit; 16 entries per nibble take an eighth of the memory of 
+	// 256 entries per byte
+	uint numNibbles = 16*((m_branchWeight.size() + 63) / 64);
+	m_bitWeightTable.assign(numNibbles*16, 0);
+	for(uint b = 0; b < numNibbles; ++b)
+	{
+		double* table = &m_bitWeightTable[b*16];
+		for(uint value = 1; value < 16; ++value)
+		{
+			uint bit = 0;
+			while(!(value & (1 << bit)))
+				++bit;
+
+			uint n = b*4 + bit;
+			table[value] = table[value & (value - 1)] + (n < m_branchWeight.size() ? m_branchWeight[n] : 0);
+		}
+	}
 }
 
 bool DiversityCalculator::InitDataVectorizer()
@@ -552,25 +776,65 @@ bool DiversityCalculator::InitDataVectorizer()
 	std::clock_t dataVecStart = std::clock();
 	if(!m_dataVec.Init(m_tree, m_bPhylogenetic, m_bWeighted, !m_bCount, m_seqCountIO.GetSeqs()))
 		return false;
+	m_validStatistics = 0;
+	m_dataVecCache.Clear();
+	EstimateDensity();
+
 	std::clock_t dataVecEnd = std::clock();
 
 	if(m_bVerbose)
+	{
 		std::cout << "  Time to initialize data vectoring object: " << ( dataVecEnd - dataVecStart ) / (double)CLOCKS_PER_SEC << " s" << std::endl; 
+		std::cout << "  Estimated fraction of non-zero data vector entries: " << m_density << std::endl; 
+		if(m_bSinglePrecision)
+			std::cout << "  Storing profiles and dissimilarities in single precision." << std::endl;
+	}
 
 	return true;
 }
 
-bool DiversityCalculator::Dissimilarity(const std::string& outputPrefix, const std::string& clusteringMethod, uint jackknifeRep, uint seqsToDraw)
+void DiversityCalculator::EstimateDensity()
+{
+	uint numSamples = std::min<uint>(m_seqCountIO.GetNumSamples(), DENSITY_SAMPLES);
+
+	uint64 nonZero = 0;
+	SparseDataVector dataVec;
+	for(uint i = 0; i < numSamples; ++i)
+	{
+		std::vector<uint> seqIndices;
+		std::vector<double> count;
+		double totalNumSeq;
+		m_seqCountIO.GetSparseData(i, seqIndices, count, totalNumSeq);
+
+		m_dataVec.CalculateDataVector(seqIndices, count, totalNumSeq, dataVec);
+		nonZero += dataVec.index.size();
+	}
+
+	m_density = 1;
+	if(numSamples > 0 && m_dataVec.GetSize() > 0)
+		m_density = nonZero / ((double)numSamples * m_dataVec.GetSize());
+}
+
+bool DiversityCalculator::Dissimilarity(const std::string& outputPrefix, const std::string& clusteringMethod, uint jackknifeRep, uint seqsToDraw, 
+																					bool bReplacement, uint seed)
 {
 	std::clock_t dissStart = std::clock();
 
 	std::string dissFile = outputPrefix + ".diss";
 
+	m_subsampler.SetSeed(seed);
+	m_subsampler.SetReplacement(bReplacement);
+
 	std::vector<Tree<Node>*> jackknifeTrees;
 	if(jackknifeRep != 0)
 	{
+		if(m_bVerbose)
+			std::cout << "  Seed for drawing sequences of jackknife replicates: " << seed << std::endl;
+
 		for(uint i = 0; i < jackknifeRep; ++i)
 		{
+			m_jackknifeRep = i;
+
 			Tree<Node>* jacknifeTree = new Tree<Node>;
 			if(!CreateDissimilarityMatrix(dissFile, jacknifeTree, clusteringMethod, seqsToDraw))
 				return false;
@@ -595,6 +859,9 @@ bool DiversityCalculator::Dissimilarity(const std::string& outputPrefix, const s
 	if(m_bVerbose)
 	{
 		std::cout << std::endl;
+		std::cout << "  Data vectors read from cache: " << m_dataVecCache.GetHits() << " of " << m_dataVecCache.GetHits() + m_dataVecCache.GetMisses();
+		std::cout << " (" << m_dataVecCache.GetSize() / (1024.0*1024.0) << " MB cached)" << std::endl;
+		std::cout << "  Memory allocations while comparing " << m_numPairs << " pairs of samples: " << m_pairAllocations << std::endl;
 		std::cout << "  Total time to calculate dissimilarity matrix and jackknife trees: " << (dissEnd - dissStart) / (double)CLOCKS_PER_SEC << " s" << std::endl; 
 		std::cout << std::endl;
 	}
@@ -608,6 +875,114 @@ bool DiversityCalculator::Dissimilarity(const std::string& outputPrefix, const s
 	return true;
 }
 
+template<class T>
+double DiversityCalculator::Compare(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, 
+																		double (*calculator)(const std::vector<T>&, const std::vector<T>&, uint, uint, CompareContext&), CompareContext& context)
+{
+	context.begin = 0;
+	context.end = com1.size();
+
+	if(m_bMRCA)
+	{
+		// Check if all MRCA weighted branches are zero. This is a degenerate case and
+		// indicates both samples are contained in a single leaf node.
+		if(!m_dataVec.ApplyWeightsMRCA(com1, com2, context.mrcaNodeWeight, context.MRCABranchWeights(com1)))
+			return 0;
+	}
+	else if(m_bStrictMRCA)
+	{
+		// nodes in the MRCA subtree precede its root in post-order, so the calculator 
+		// visits this range of the data vectors in place
+		m_dataVec.GetMRCARange(com1, com2, context.begin, context.end);
+	}
+
+	return calculator(com1, com2, i, j, context);
+}
+
+double DiversityCalculator::Compare(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context)
+{
+	context.begin = 0;
+	context.end = m_dataVec.GetSize();
+	if(m_bStrictMRCA)
+		m_dataVec.GetMRCARange(com1, com2, context.begin, context.end);
+
+	return m_sparseCalculator(com1, com2, i, j, context);
+}
+
+template<class T>
+void DiversityCalculator::CompareBlocks(uint row, uint col, uint blockLen, T* partialDissMatrix, std::vector<CompareContext>& contexts)
+{
+	bool bSparse = IsSparse();
+	bool bBitPacked = IsBitPacked();
+	int numRows = m_dataVecRows.GetSize();
+	uint numCols = m_dataVecCols.GetSize();
+	int numThreads = contexts.size();
+	uint64 pairAllocations = 0;
+
+	// rows are compared by a team of threads, with each thread using its own context
+	#pragma omp parallel num_threads(numThreads) if(numThreads > 1) reduction(+:pairAllocations)
+	{
+		int thread = 0;
+#ifdef _OPENMP
+		thread = omp_get_thread_num();
+#endif
+		CompareContext& context = contexts[thread];
+
+		// allocations are counted per thread so blocks being loaded are not included
+		uint64 numAllocations = AllocationCounter::GetCount();
+
+		#pragma omp for schedule(dynamic)
+		for(int r = 0; r < numRows; ++r)
+		{
+			uint colStop = numCols;
+			if(row == 0)
+				colStop = std::min<uint>(r, numCols);
+
+			for(uint c = 0; c < colStop; ++c)
+			{
+				double diss;
+				if(bBitPacked)
+					diss = m_bitCalculator(m_dataVecRows.bitDataVec[r], m_dataVecCols.bitDataVec[c], r, c);
+				else if(bSparse)
+					diss = Compare(m_dataVecRows.sparseDataVec[r], m_dataVecCols.sparseDataVec[c], r, c, context);
+				else if(m_bSinglePrecision)
+					diss = Compare(m_dataVecRows.floatDataVec[r], m_dataVecCols.floatDataVec[c], r, c, m_floatCalculator, context);
+				else
+					diss = Compare(m_dataVecRows.dataVec[r], m_dataVecCols.dataVec[c], r, c, m_calculator, context);
+
+				partialDissMatrix[r*m_seqCountIO.GetNumSamples() + col*blockLen + c] = (T)diss;
+			}
+		}
+
+		pairAllocations += AllocationCounter::GetCount() - numAllocations;
+	}
+
+	m_pairAllocations += pairAllocations;
+}
+
+void DiversityCalculator::InitCompareContext(CompareContext& context)
+{
+	m_dataVec.InitScratch(context.scratch);
+
+	// pairs compared with MRCA weightings use the MRCA branch weights of the thread, and 
+	// all other pairs, including those restricted to their MRCA subtree, use the branch 
+	// weights shared by all threads
+	if(m_bMRCA)
+	{
+		context.branchWeight = &context.mrcaBranchWeight;
+		context.floatBranchWeight = &context.floatMrcaBranchWeight;
+
+		context.mrcaBranchWeight.reserve(m_dataVec.GetSize());
+		context.floatMrcaBranchWeight.reserve(m_dataVec.GetSize());
+		context.mrcaNodeWeight.reserve(m_dataVec.GetSize() + 1);
+	}
+	else
+	{
+		context.branchWeight = &m_branchWeight;
+		context.floatBranchWeight = &m_floatBranchWeight;
+	}
+}
+
 bool DiversityCalculator::CreateDissimilarityMatrix(const std::string& dissFile, Tree<Node>* tree, const std::string& clusteringMethod, uint seqsToDraw)
 {
 	// open dissimilarity file
@@ -618,8 +993,21 @@ bool DiversityCalculator::CreateDissimilarityMatrix(const std::string& dissFile,
 		return false;
 	}
 
+	// half of the threads load the next pair of blocks while the other half compare the current pair
+	uint numThreads = 1;
+#ifdef _OPENMP
+	numThreads = omp_get_max_threads();
+#endif
+	bool bAsyncLoad = numThreads > 1;
+	uint loadThreads = bAsyncLoad ? numThreads / 2 : 1;
+	uint compareThreads = bAsyncLoad ? numThreads - loadThreads : 1;
+
 	// get blocking information
-	uint blockLen = m_maxDataVecs / 2;
+	// single precision data vectors take half the memory so twice as many fit in each block, and
+	// blocks are half as long when the next pair of blocks is loaded while the current pair is compared
+	uint blockLen = m_bSinglePrecision ? m_maxDataVecs : m_maxDataVecs / 2;
+	if(bAsyncLoad)
+		blockLen = std::max<uint>(blockLen / 2, 1);
 	uint numBlocks = m_seqCountIO.GetNumSamples() / blockLen;
 	if(numBlocks*blockLen != m_seqCountIO.GetNumSamples())
 		++numBlocks;	// extra block if samples do not fit perfectly into blocks
@@ -627,64 +1015,82 @@ bool DiversityCalculator::CreateDissimilarityMatrix(const std::string& dissFile,
 	// calculate dissimilarity
 	dissOut << m_seqCountIO.GetNumSamples() << std::endl;
 
-	double* partialDissMatrix = new double[blockLen*m_seqCountIO.GetNumSamples()];
+	// dissimilarities are stored with the same precision as the data vectors
+	double* partialDissMatrix = NULL;
+	float* floatPartialDissMatrix = NULL;
+	if(m_bSinglePrecision)
+		floatPartialDissMatrix = new float[blockLen*m_seqCountIO.GetNumSamples()];
+	else
+		partialDissMatrix = new double[blockLen*m_seqCountIO.GetNumSamples()];
+
+	// load first pair of row and column blocks
+	CalculateDataVectors(0, blockLen, m_dataVecRows, seqsToDraw, numThreads);
+	CalculateDataVectors(0, blockLen, m_dataVecCols, seqsToDraw, numThreads);
+
+#ifdef _OPENMP
+	// threads loading the next pair of blocks and threads comparing the current pair are teams nested within each section
+	int maxActiveLevels = omp_get_max_active_levels();
+	if(bAsyncLoad)
+		omp_set_max_active_levels(std::max<int>(maxActiveLevels, 2));
+#endif
+
+	DataVectorBlock nextDataVecRows;
+	DataVectorBlock nextDataVecCols;
+
+	// contexts are initialized in place as they point to their own buffers
+	std::vector<CompareContext> contexts(compareThreads);
+	for(uint t = 0; t < compareThreads; ++t)
+		InitCompareContext(contexts[t]);
 
-	double innerLoopTime = 0;
 	for(uint row = 0; row < numBlocks; ++row)
 	{
-		CalculateDataVectors(row*blockLen, blockLen, m_dataVecRows, seqsToDraw);
+		if(row > 0)
+			m_dataVecRows.Swap(nextDataVecRows);
 
 		for(uint col = 0; col <= row; ++col)
 		{
-			CalculateDataVectors(col*blockLen, blockLen, m_dataVecCols, seqsToDraw);
+			// blocks are loaded in the same order as they are compared so jackknife replicates are unchanged
+			uint nextRow = (col == row) ? row + 1 : row;
+			uint nextCol = (col == row) ? 0 : col + 1;
 
-			std::clock_t innerDissLoopStart = std::clock();	
-			for(uint r = 0; r < m_dataVecRows.size(); ++r)
+			#pragma omp parallel sections num_threads(2) if(bAsyncLoad)
 			{
-				uint colStop = m_dataVecCols.size();
-				if(row == 0)
-					colStop = std::min<uint>(r, m_dataVecCols.size());
-
-				for(uint c = 0; c < colStop; ++c)
+				#pragma omp section
 				{
-					double diss;
-					if(m_bMRCA)
+					if(nextRow < numBlocks)
 					{
-						m_dataVec.ApplyWeightsMRCA(m_dataVecRows[r], m_dataVecCols[c], m_branchWeight);
-
-						// Check if all MRCA weighted branches are zero. This is a degenerate case and
-						// indicates both samples are contained in a single leaf node.
-						double branchSum =std::accumulate(m_branchWeight.begin(), m_branchWeight.end(), 0.0);
-						if(branchSum == 0)
-							diss = 0;
-						else
-							diss = m_calculator(m_dataVecRows[r], m_dataVecCols[c], r, c);
-					}
-					else if(m_bStrictMRCA)
-					{
-						std::vector<double> MRCAi;
-						std::vector<double> MRCAj;
-						m_dataVec.RestrictToMRCA(m_dataVecRows[r], m_dataVecCols[c], MRCAi, MRCAj, m_branchWeight);
-						diss = m_calculator(MRCAi, MRCAj, r, c);
+						if(nextRow != row)
+							CalculateDataVectors(nextRow*blockLen, blockLen, nextDataVecRows, seqsToDraw, loadThreads);
+
+						CalculateDataVectors(nextCol*blockLen, blockLen, nextDataVecCols, seqsToDraw, loadThreads);
 					}
-					else
-						diss = m_calculator(m_dataVecRows[r], m_dataVecCols[c], r, c);
+				}
 
-					partialDissMatrix[r*m_seqCountIO.GetNumSamples() + col*blockLen + c] = diss;
+				#pragma omp section
+				{
+					if(m_bSinglePrecision)
+						CompareBlocks(row, col, blockLen, floatPartialDissMatrix, contexts);
+					else
+						CompareBlocks(row, col, blockLen, partialDissMatrix, contexts);
 				}
 			}
 
-			std::clock_t innerDissLoopEnd = std::clock();	
-			innerLoopTime += (innerDissLoopEnd - innerDissLoopStart);
+			m_dataVecCols.Swap(nextDataVecCols);
 		}
 
 		// write out partial dissimilarity matrix to file
-		for(uint r = 0; r < m_dataVecRows.size(); ++r)
+		for(uint r = 0; r < m_dataVecRows.GetSize(); ++r)
 		{
 			dissOut << m_seqCountIO.GetSampleName(row*blockLen + r);
 
 			for(uint c = 0; c < (row*blockLen + r); ++c)
-				dissOut << '\t' << partialDissMatrix[r*m_seqCountIO.GetNumSamples() + c];
+			{
+				uint index = r*m_seqCountIO.GetNumSamples() + c;
+				if(m_bSinglePrecision)
+					dissOut << '\t' << floatPartialDissMatrix[index];
+				else
+					dissOut << '\t' << partialDissMatrix[index];
+			}
 
 			dissOut << std::endl;
 		}
@@ -692,7 +1098,14 @@ bool DiversityCalculator::CreateDissimilarityMatrix(const std::string& dissFile,
 
 	dissOut.close();
 
+#ifdef _OPENMP
+	omp_set_max_active_levels(maxActiveLevels);
+#endif
+
+	m_numPairs += (uint64)m_seqCountIO.GetNumSamples()*(m_seqCountIO.GetNumSamples() - 1) / 2;
+
 	delete[] partialDissMatrix;
+	delete[] floatPartialDissMatrix;
 
 	// read complete dissimilarity matrix and create hierarchical cluster tree
 	Matrix dissMatrix;
@@ -839,68 +1252,82 @@ bool DiversityCalculator::JackknifeTree(Tree<Node>* inputTree, const std::vector
 	return true;
 }
 
-double DiversityCalculator::BrayCurtis(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j)
+template<class T>
+void DiversityCalculator::SumElements(typename VectorKernelTable<T>::Kernel kernel, const std::vector<T>& com1, const std::vector<T>& com2, CompareContext& context, double* sums)
 {
-	double num = 0;
-	double den = 0;
-	for(uint n = 0; n < com1.size(); ++n)
+	uint begin = context.begin;
+	if(begin == context.end)
 	{
-		num += fabs(com1[n] - com2[n])*m_branchWeight[n];
-		den += (com1[n] + com2[n])*m_branchWeight[n];
+		kernel(NULL, NULL, NULL, NULL, NULL, 0, sums);
+		return;
 	}
 
-	return num / den;
+	const std::vector<T>& branchWeight = context.BranchWeights(com1);
+	const double* minExtent = m_minExtent.empty() ? NULL : &m_minExtent[begin];
+	const double* maxExtent = m_maxExtent.empty() ? NULL : &m_maxExtent[begin];
+	kernel(&com1[begin], &com2[begin], &branchWeight[begin], minExtent, maxExtent, context.end - begin, sums);
 }
 
-double DiversityCalculator::Canberra(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j)
+template<class T>
+double DiversityCalculator::BrayCurtis(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context)
 {
-	double diss = 0;
-	for(uint n = 0; n < com1.size(); ++n)
-	{
-		double den = com1[n] + com2[n];
-		if(den != 0)
-			diss += (fabs(com1[n] - com2[n]) / den)*m_branchWeight[n];
-	}
+	double sums[2];
+	SumElements(VectorKernels::Get(com1).brayCurtis, com1, com2, context, sums);
+
+	return sums[0] / sums[1];
+}
+
+template<class T>
+double DiversityCalculator::Canberra(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context)
+{
+	double diss;
+	SumElements(VectorKernels::Get(com1).canberra, com1, com2, context, &diss);
 
 	return diss;
 }
 
-double DiversityCalculator::ChiSquared(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j)
+template<class T>
+double DiversityCalculator::ChiSquared(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context)
 {
+	const std::vector<T>& branchWeight = context.BranchWeights(com1);
 	double diss = 0;
-	for(uint n = 0; n < com1.size(); ++n)
+	for(uint n = context.begin; n < context.end; ++n)
 	{
 		if(m_colSum[n] > 0)
 		{
 			double d = (com1[n]/m_rowLeafSum[i] - com2[n]/m_rowLeafSum[j]);
-			diss += (m_branchWeight[n]*d*d / m_colSum[n]);
+			diss += (branchWeight[n]*d*d / m_colSum[n]);
 		}
 	}
 
 	return sqrt(diss);
 }
 
-double DiversityCalculator::CoefficientOfSimilarity(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j)
+template<class T>
+double DiversityCalculator::CoefficientOfSimilarity(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context)
 {
+	const std::vector<T>& branchWeight = context.BranchWeights(com1);
 	double diss = 0;
-	for(uint n = 0; n < com1.size(); ++n)
+	for(uint n = context.begin; n < context.end; ++n)
 	{
 		double max = std::max<double>(com1[n],com2[n]);
 		if(max > 0)
-			diss += (fabs(com1[n]-com2[n])/max)*m_branchWeight[n];
+			diss += (fabs(com1[n]-com2[n])/max)*branchWeight[n];
 	}
 
 	return diss;
 }
 
-double DiversityCalculator::CompleteTree(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j)
+template<class T>
+double DiversityCalculator::CompleteTree(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context)
 {
+	const std::vector<T>& branchWeight = context.BranchWeights(com1);
 	double num = 0;
 	double den = 0;
-	for(uint n = 0; n < com1.size(); ++n)
+	for(uint n = context.begin; n < context.end; ++n)
 	{
-		num += fabs(com1[n] - com2[n])*m_branchWeight[n];
-		den += (m_maxExtent[n] - m_minExtent[n])*m_branchWeight[n];
+		num += fabs(com1[n] - com2[n])*branchWeight[n];
+		den += (m_maxExtent[n] - m_minExtent[n])*branchWeight[n];
 	}
 
 	if(den == 0)
@@ -909,24 +1336,20 @@ double DiversityCalculator::CompleteTree(const std::vector<double>& com1, const
 	return num / den;
 }
 
-double DiversityCalculator::Euclidean(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j)
+template<class T>
+double DiversityCalculator::Euclidean(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context)
 {
-	double diss = 0;
-	for(uint n = 0; n < com1.size(); ++n)
-	{
-		double d = com1[n] - com2[n];
-		diss += m_branchWeight[n]*d*d;
-	}
+	double diss;
+	SumElements(VectorKernels::Get(com1).euclidean, com1, com2, context, &diss);
 
 	return sqrt(diss);
 }
 
-double DiversityCalculator::Fst(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j)
+template<class DataVector>
+double DiversityCalculator::Fst(const DataVector& com1, const DataVector& com2, uint i, uint j, CompareContext& context)
 {
-	std::vector<double> leafPropI;
-	std::vector<double> leafPropJ;
-	std::vector< std::vector<double> > pairedLeafDistances;
-	m_dataVec.PairedLeafSetDistance(com1, com2, leafPropI, leafPropJ, pairedLeafDistances);
+	LeafSetDistanceSums sums;
+	m_dataVec.LeafSetDistanceSum(com1, com2, !m_bWeighted, sums, context.scratch);
 
 	double DT = 0;
 	double DS_A = 0;
@@ -934,53 +1357,25 @@ double DiversityCalculator::Fst(const std::vector<double>& com1, const std::vect
 
 	if(m_bWeighted)
 	{
-		for(uint x = 0; x < leafPropI.size(); ++x)
-		{
-			for(uint y = 0; y < leafPropI.size(); ++y)
-			{
-				DT += 0.5*(leafPropI[x] + leafPropJ[x]) * 0.5*(leafPropI[y] + leafPropJ[y]) * pairedLeafDistances[x][y];
-				DS_A += leafPropI[x]*leafPropI[y]*pairedLeafDistances[x][y];
-				DS_B += leafPropJ[x]*leafPropJ[y]*pairedLeafDistances[x][y];
-			}
-		}
+		DT = 0.25*(sums.sumII + 2*sums.sumIJ + sums.sumJJ);
+		DS_A = sums.sumII;
+		DS_B = sums.sumJJ;
 	}
 	else
 	{
-		uint compA = 0;
-		uint compB = 0;
-		uint compAB = 0;
-		for(uint x = 0; x < leafPropI.size(); ++x)
-		{
-			for(uint y = 0; y < leafPropI.size(); ++y)
-			{
-				if(x == y)
-					continue;
-
-				DT += pairedLeafDistances[x][y];
-				compAB++;
-
-				if(leafPropI[x] == 1 && leafPropI[y] == 1)
-				{
-					DS_A += pairedLeafDistances[x][y];
-					compA++;
-				}
-
-				if(leafPropJ[x] == 1 && leafPropJ[y] == 1)
-				{
-					DS_B += pairedLeafDistances[x][y];
-					compB++;
-				}
-			}
-		}
+		// average over ordered pairs of distinct leaf nodes, with leaf mass indicating presence in a community
+		double compAB = sums.numLeaves*(sums.numLeaves - 1);
+		double compA = sums.totalI*(sums.totalI - 1);
+		double compB = sums.totalJ*(sums.totalJ - 1);
 
-		DT /= compAB;
+		DT = sums.sumUnion / compAB;
 		if(compA != 0)
-			DS_A /= compA;
+			DS_A = sums.sumII / compA;
 		else
 			DS_A = 0;
 
 		if(compB != 0)
-			DS_B /= compB;
+			DS_B = sums.sumJJ / compB;
 		else
 			DS_B = 0;
 	}	
@@ -990,84 +1385,83 @@ double DiversityCalculator::Fst(const std::vector<double>& com1, const std::vect
 	return (DT - DS) / DT;
 }
 
-double DiversityCalculator::Gower(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j)
+template<class T>
+double DiversityCalculator::Gower(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context)
 {
-	double diss = 0;
-	for(uint n = 0; n < com1.size(); ++n)
-	{
-		double d = m_maxExtent[n] - m_minExtent[n];
-		if(d > 0)
-			diss += (fabs(com1[n] - com2[n]) / (m_maxExtent[n] - m_minExtent[n]))*m_branchWeight[n];
-	}
+	double diss;
+	SumElements(VectorKernels::Get(com1).gower, com1, com2, context, &diss);
 
 	return diss;
 }
 
-double DiversityCalculator::Hellinger(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j)
+template<class T>
+double DiversityCalculator::Hellinger(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context)
 {
+	const std::vector<T>& branchWeight = context.BranchWeights(com1);
 	double diss = 0;
-	for(uint n = 0; n < com1.size(); ++n)
+	for(uint n = context.begin; n < context.end; ++n)
 	{
 		double d = sqrt(com1[n]/m_rowLeafSum[i]) - sqrt(com2[n]/m_rowLeafSum[j]);
-		diss += m_branchWeight[n]*d*d;
+		diss += branchWeight[n]*d*d;
 	}
 
 	return sqrt(diss);
 }
 
-double DiversityCalculator::Kulczynski(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j)
+template<class T>
+double DiversityCalculator::Kulczynski(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context)
 {
-	double sumMin = 0;
-	for(uint n = 0; n < com1.size(); ++n)
-		sumMin += std::min<double>(com1[n], com2[n])*m_branchWeight[n];
+	double sumMin;
+	SumElements(VectorKernels::Get(com1).kulczynski, com1, com2, context, &sumMin);
 
 	return 1 - 0.5*(sumMin/m_weightedRowSum[i] + sumMin/m_weightedRowSum[j]);
 }
 
-double DiversityCalculator::LennonCD(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j)
+template<class T>
+double DiversityCalculator::LennonCD(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context)
 {
-	double A = 0;
-	double B = 0;
-	double C = 0;
-	for(uint n = 0; n < com1.size(); ++n)
-	{
-		A += std::min<double>(com1[n], com2[n])*m_branchWeight[n];
-		B += (std::max<double>(com1[n], com2[n]) - com2[n])*m_branchWeight[n];
-		C += (std::max<double>(com1[n], com2[n]) - com1[n])*m_branchWeight[n];
-	}
+	double sums[3];
+	SumElements(VectorKernels::Get(com1).lennonCD, com1, com2, context, sums);
+
+	double A = sums[0];
+	double B = sums[1];
+	double C = sums[2];
 
 	return std::min<double>(B, C) / (std::min<double>(B, C) + A);
 }
 
-double DiversityCalculator::LennonLRG(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j)
+template<class T>
+double DiversityCalculator::LennonLRG(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context)
 {
+	const std::vector<T>& branchWeight = context.BranchWeights(com1);
 	double A = 0;
 	double B = 0;
 	double C = 0;
-	for(uint n = 0; n < com1.size(); ++n)
+	for(uint n = context.begin; n < context.end; ++n)
 	{
-		A += std::min<double>(com1[n], com2[n])*m_branchWeight[n];
-		B += (std::max<double>(com1[n], com2[n]) - com2[n])*m_branchWeight[n];
-		C += (std::max<double>(com1[n], com2[n]) - com1[n])*m_branchWeight[n];
+		A += std::min<double>(com1[n], com2[n])*branchWeight[n];
+		B += (std::max<double>(com1[n], com2[n]) - com2[n])*branchWeight[n];
+		C += (std::max<double>(com1[n], com2[n]) - com1[n])*branchWeight[n];
 	}		
 
 	return 2*fabs(B-C) / (2*A+B+C);
 }
 
-double DiversityCalculator::Manhattan(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j)
+template<class T>
+double DiversityCalculator::Manhattan(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context)
 {
-	double diss = 0;
-	for(uint n = 0; n < com1.size(); ++n)
-		diss += fabs(com1[n] - com2[n])*m_branchWeight[n];
+	double diss;
+	SumElements(VectorKernels::Get(com1).manhattan, com1, com2, context, &diss);
 
 	return diss;
 }
 
-double DiversityCalculator::MNND(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j)
+template<class DataVector>
+double DiversityCalculator::MNND(const DataVector& com1, const DataVector& com2, uint i, uint j, CompareContext& context)
 {
-	std::vector<double> minLeafI;
-	std::vector<double> minLeafJ;
-	m_dataVec.LeafSetMinDistance(com1, com2, minLeafI, minLeafJ);
+	std::vector<double>& minLeafI = context.scratch.leafValuesI;
+	std::vector<double>& minLeafJ = context.scratch.leafValuesJ;
+	m_dataVec.LeafSetMinDistance(com1, com2, minLeafI, minLeafJ, context.scratch);
 
 	double dissA = 0;
 	for(uint i = 0; i < minLeafI.size(); ++i)
@@ -1086,38 +1480,28 @@ double DiversityCalculator::MNND(const std::vector<double>& com1, const std::vec
 	return 0.5*(dissA + dissB);
 }
 
-double DiversityCalculator::MPD(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j)
+template<class DataVector>
+double DiversityCalculator::MPD(const DataVector& com1, const DataVector& com2, uint i, uint j, CompareContext& context)
 {
-	std::vector<double> leafPropI;
-	std::vector<double> leafPropJ;
-	std::vector< std::vector<double> > leafDist;
-	m_dataVec.LeafSetDistance(com1, com2, leafPropI, leafPropJ, leafDist);
-
-	double diss = 0;
-	double weight = 0;
-	for(uint a = 0; a < leafPropI.size(); ++a)
-	{
-		for(uint b = 0; b < leafPropJ.size(); ++b)
-		{
-			diss += leafPropI[a]*leafPropJ[b]*leafDist[a][b];
-			weight += leafPropI[a]*leafPropJ[b];
-		}
-	}
+	LeafSetDistanceSums sums;
+	m_dataVec.LeafSetDistanceSum(com1, com2, false, sums, context.scratch);
 
-	return diss / weight;
+	return sums.sumIJ / (sums.totalI*sums.totalJ);
 }
 
-double DiversityCalculator::MorisitaHorn(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j)
+template<class T>
+double DiversityCalculator::MorisitaHorn(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context)
 {
+	const std::vector<T>& branchWeight = context.BranchWeights(com1);
 	double prodSum = 0;
 	double com1SumSqrd = 0;
 	double com2SumSqrd = 0;
-	for(uint n = 0; n < com1.size(); ++n)
+	for(uint n = context.begin; n < context.end; ++n)
 	{
-		prodSum += com1[n]*com2[n]*m_branchWeight[n];
+		prodSum += com1[n]*com2[n]*branchWeight[n];
 
-		com1SumSqrd += com1[n]*com1[n]*m_branchWeight[n];
-		com2SumSqrd += com2[n]*com2[n]*m_branchWeight[n];
+		com1SumSqrd += com1[n]*com1[n]*branchWeight[n];
+		com2SumSqrd += com2[n]*com2[n]*branchWeight[n];
 	}
 
 	double num = 2*prodSum;
@@ -1126,15 +1510,17 @@ double DiversityCalculator::MorisitaHorn(const std::vector<double>& com1, const
 	return 1.0 - num / den;
 }
 
-double DiversityCalculator::NormalizedWeightedUniFrac(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j)
+template<class T>
+double DiversityCalculator::NormalizedWeightedUniFrac(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context)
 {
-	std::vector<double> rootDistI;
-	std::vector<double> rootDistJ;
-	m_dataVec.LeafSetRootDistance(com1, com2, rootDistI, rootDistJ);
+	const std::vector<T>& branchWeight = context.BranchWeights(com1);
+	std::vector<double>& rootDistI = context.scratch.leafValuesI;
+	std::vector<double>& rootDistJ = context.scratch.leafValuesJ;
+	m_dataVec.LeafSetRootDistance(com1, com2, rootDistI, rootDistJ, context.scratch);
 
 	double num = 0;
-	for(uint n = 0; n < com1.size(); ++n)
-		num += fabs(com1[n] - com2[n])*m_branchWeight[n];
+	for(uint n = context.begin; n < context.end; ++n)
+		num += fabs(com1[n] - com2[n])*branchWeight[n];
 		
 	double den = 0;
 	for(uint l = 0; l < rootDistI.size(); ++l)
@@ -1146,19 +1532,21 @@ double DiversityCalculator::NormalizedWeightedUniFrac(const std::vector<double>&
 	return num / den;
 }
 
-double DiversityCalculator::Pearson(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j)
+template<class T>
+double DiversityCalculator::Pearson(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context)
 {
-	double meanCol1 = m_weightedRowSum[i] / com1.size();
-	double meanCol2 = m_weightedRowSum[j] / com2.size();
+	const std::vector<T>& branchWeight = context.BranchWeights(com1);
+	double meanCol1 = m_weightedRowSum[i] / (context.end - context.begin);
+	double meanCol2 = m_weightedRowSum[j] / (context.end - context.begin);
 
 	double sumProdDiff = 0;
 	double sumCom1DiffSqrd = 0;
 	double sumCom2DiffSqrd = 0;
 
-	for(uint n = 0; n < com1.size(); ++n)
+	for(uint n = context.begin; n < context.end; ++n)
 	{
-		double diff1 = com1[n]*m_branchWeight[n] - meanCol1;
-		double diff2 = com2[n]*m_branchWeight[n] - meanCol2;
+		double diff1 = com1[n]*branchWeight[n] - meanCol1;
+		double diff2 = com2[n]*branchWeight[n] - meanCol2;
 
 		sumProdDiff += diff1*diff2;
 
@@ -1174,22 +1562,24 @@ double DiversityCalculator::Pearson(const std::vector<double>& com1, const std::
 	return diss;
 }
 
-double DiversityCalculator::WeightedCorrelation(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j)
+template<class T>
+double DiversityCalculator::WeightedCorrelation(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context)
 {
+	const std::vector<T>& branchWeight = context.BranchWeights(com1);
 	double meanCol1 = m_weightedRowSum[i] / m_totalBranchLen;
 	double meanCol2 = m_weightedRowSum[j] / m_totalBranchLen;
 
 	double covXY = 0;
 	double covX = 0;
 	double covY = 0;
-	for(uint n = 0; n < com1.size(); ++n)
+	for(uint n = context.begin; n < context.end; ++n)
 	{
 		double diff1 = com1[n] - meanCol1;
 		double diff2 = com2[n] - meanCol2;
 
-		covXY += m_branchWeight[n]*diff1*diff2;
-		covX += m_branchWeight[n]*diff1*diff1;
-		covY += m_branchWeight[n]*diff2*diff2;
+		covXY += branchWeight[n]*diff1*diff2;
+		covX += branchWeight[n]*diff1*diff1;
+		covY += branchWeight[n]*diff2*diff2;
 	}
 
 	covXY /= m_totalBranchLen;
@@ -1204,112 +1594,422 @@ double DiversityCalculator::WeightedCorrelation(const std::vector<double>& com1,
 	return diss;
 }
 
-double DiversityCalculator::RaoHp(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j)
+template<class DataVector>
+double DiversityCalculator::RaoHp(const DataVector& com1, const DataVector& com2, uint i, uint j, CompareContext& context)
+{
+	LeafSetDistanceSums sums;
+	m_dataVec.LeafSetDistanceSum(com1, com2, false, sums, context.scratch);
+
+	double dT = 0.25*(sums.sumII + 2*sums.sumIJ + sums.sumJJ);
+	double dA = sums.sumII;
+	double dB = sums.sumJJ;
+
+	return dT - 0.5*(dA+dB);
+}
+
+template<class T>
+double DiversityCalculator::Soergel(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context)
 {
-	std::vector<double> leafPropI;
-	std::vector<double> leafPropJ;
-	std::vector< std::vector<double> > pairedLeafDistances;
-	m_dataVec.PairedLeafSetDistance(com1, com2, leafPropI, leafPropJ, pairedLeafDistances);
+	double sums[2];
+	SumElements(VectorKernels::Get(com1).soergel, com1, com2, context, sums);
 
-	double dT = 0;
-	double dA = 0;
-	double dB = 0;
-	for(uint a = 0; a < leafPropI.size(); ++a)
+	return sums[0] / sums[1];
+}
+
+template<class T>
+double DiversityCalculator::SpeciesProfile(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context)
+{
+	const std::vector<T>& branchWeight = context.BranchWeights(com1);
+	double diss = 0;
+	for(uint n = context.begin; n < context.end; ++n)
 	{
-		for(uint b = 0; b < leafPropJ.size(); ++b)
-		{
-			dT += 0.5*(leafPropI[a]+leafPropJ[a])*0.5*(leafPropI[b]+leafPropJ[b])*pairedLeafDistances[a][b];
-			dA += leafPropI[a]*leafPropI[b]*pairedLeafDistances[a][b];
-			dB += leafPropJ[a]*leafPropJ[b]*pairedLeafDistances[a][b];
-		}
+		double d = com1[n]/m_rowLeafSum[i] - com2[n]/m_rowLeafSum[j];
+		diss += branchWeight[n]*d*d;
 	}
 
-	return dT - 0.5*(dA+dB);
+	return sqrt(diss);
 }
 
-double DiversityCalculator::Soergel(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j)
+template<class T>
+double DiversityCalculator::TamasCoefficient(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context)
 {
+	const std::vector<T>& branchWeight = context.BranchWeights(com1);
 	double num = 0;
 	double den = 0;
-	for(uint n = 0; n < com1.size(); ++n)
+	for(uint n = context.begin; n < context.end; ++n)
 	{
-		num += fabs(com1[n] - com2[n])*m_branchWeight[n];
-		den += std::max<double>(com1[n], com2[n])*m_branchWeight[n];
+		num += fabs(com1[n] - com2[n])*branchWeight[n];
+		den += m_maxExtent[n]*branchWeight[n];
 	}
 
 	return num / den;
 }
 
-double DiversityCalculator::SpeciesProfile(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j)
+template<class T>
+double DiversityCalculator::Whittaker(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context)
 {
+	const std::vector<T>& branchWeight = context.BranchWeights(com1);
 	double diss = 0;
-	for(uint n = 0; n < com1.size(); ++n)
-	{
-		double d = com1[n]/m_rowLeafSum[i] - com2[n]/m_rowLeafSum[j];
-		diss += m_branchWeight[n]*d*d;
-	}
+	for(uint n = context.begin; n < context.end; ++n)
+		diss += fabs(com1[n] / m_rowLeafSum[i] - com2[n] / m_rowLeafSum[j])*branchWeight[n];
 
-	return sqrt(diss);
+	return 0.5 * diss;
+}
+
+template<class T>
+double DiversityCalculator::YueClayton(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context)
+{
+	double sums[2];
+	SumElements(VectorKernels::Get(com1).yueClayton, com1, com2, context, sums);
+
+	return 1.0 - sums[0] / sums[1];
+}
+
+template<class T>
+double DiversityCalculator::Unit(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context)
+{
+	return 1.0;
+}
+
+template<class T>
+double DiversityCalculator::Sum(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context)
+{
+	const std::vector<T>& branchWeight = context.BranchWeights(com1);
+	double sum = 0;
+	for(uint n = context.begin; n < context.end; ++n)
+		sum += (com1[n] + com2[n])*branchWeight[n];
+
+	return sum;
+}
+
+template<class T>
+double DiversityCalculator::Extents(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context)
+{
+	const std::vector<T>& branchWeight = context.BranchWeights(com1);
+	double extents = 0;
+	for(uint n = context.begin; n < context.end; ++n)
+		extents += (m_maxExtent[n] - m_minExtent[n])*branchWeight[n];
+
+	return extents;
 }
 
-double DiversityCalculator::TamasCoefficient(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j)
+double DiversityCalculator::BrayCurtis(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context)
 {
+	const std::vector<double>& branchWeight = context.BranchWeights(com1);
 	double num = 0;
 	double den = 0;
-	for(uint n = 0; n < com1.size(); ++n)
+	uint n;
+	double p1, p2;
+	SparseDataVectorPair pair(com1, com2, context.begin, context.end);
+	while(pair.Next(n, p1, p2))
 	{
-		num += fabs(com1[n] - com2[n])*m_branchWeight[n];
-		den += m_maxExtent[n]*m_branchWeight[n];
+		num += fabs(p1 - p2)*branchWeight[n];
+		den += (p1 + p2)*branchWeight[n];
 	}
 
 	return num / den;
 }
 
-double DiversityCalculator::Whittaker(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j)
+double DiversityCalculator::Canberra(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context)
 {
+	const std::vector<double>& branchWeight = context.BranchWeights(com1);
 	double diss = 0;
-	for(uint n = 0; n < com1.size(); ++n)
-		diss += fabs(com1[n] / m_rowLeafSum[i] - com2[n] / m_rowLeafSum[j])*m_branchWeight[n];
+	uint n;
+	double p1, p2;
+	SparseDataVectorPair pair(com1, com2, context.begin, context.end);
+	while(pair.Next(n, p1, p2))
+	{
+		double den = p1 + p2;
+		if(den != 0)
+			diss += (fabs(p1 - p2) / den)*branchWeight[n];
+	}
 
-	return 0.5 * diss;
+	return diss;
+}
+
+double DiversityCalculator::CoefficientOfSimilarity(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context)
+{
+	const std::vector<double>& branchWeight = context.BranchWeights(com1);
+	double diss = 0;
+	uint n;
+	double p1, p2;
+	SparseDataVectorPair pair(com1, com2, context.begin, context.end);
+	while(pair.Next(n, p1, p2))
+	{
+		double max = std::max<double>(p1,p2);
+		if(max > 0)
+			diss += (fabs(p1-p2)/max)*branchWeight[n];
+	}
+
+	return diss;
+}
+
+double DiversityCalculator::Euclidean(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context)
+{
+	const std::vector<double>& branchWeight = context.BranchWeights(com1);
+	double diss = 0;
+	uint n;
+	double p1, p2;
+	SparseDataVectorPair pair(com1, com2, context.begin, context.end);
+	while(pair.Next(n, p1, p2))
+	{
+		double d = p1 - p2;
+		diss += branchWeight[n]*d*d;
+	}
+
+	return sqrt(diss);
+}
+
+double DiversityCalculator::Kulczynski(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context)
+{
+	const std::vector<double>& branchWeight = context.BranchWeights(com1);
+	double sumMin = 0;
+	uint n;
+	double p1, p2;
+	SparseDataVectorPair pair(com1, com2, context.begin, context.end);
+	while(pair.Next(n, p1, p2))
+		sumMin += std::min<double>(p1, p2)*branchWeight[n];
+
+	return 1 - 0.5*(sumMin/m_weightedRowSum[i] + sumMin/m_weightedRowSum[j]);
+}
+
+double DiversityCalculator::LennonCD(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context)
+{
+	const std::vector<double>& branchWeight = context.BranchWeights(com1);
+	double A = 0;
+	double B = 0;
+	double C = 0;
+	uint n;
+	double p1, p2;
+	SparseDataVectorPair pair(com1, com2, context.begin, context.end);
+	while(pair.Next(n, p1, p2))
+	{
+		A += std::min<double>(p1, p2)*branchWeight[n];
+		B += (std::max<double>(p1, p2) - p2)*branchWeight[n];
+		C += (std::max<double>(p1, p2) - p1)*branchWeight[n];
+	}
+
+	return std::min<double>(B, C) / (std::min<double>(B, C) + A);
+}
+
+double DiversityCalculator::LennonLRG(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context)
+{
+	const std::vector<double>& branchWeight = context.BranchWeights(com1);
+	double A = 0;
+	double B = 0;
+	double C = 0;
+	uint n;
+	double p1, p2;
+	SparseDataVectorPair pair(com1, com2, context.begin, context.end);
+	while(pair.Next(n, p1, p2))
+	{
+		A += std::min<double>(p1, p2)*branchWeight[n];
+		B += (std::max<double>(p1, p2) - p2)*branchWeight[n];
+		C += (std::max<double>(p1, p2) - p1)*branchWeight[n];
+	}		
+
+	return 2*fabs(B-C) / (2*A+B+C);
 }
 
-double DiversityCalculator::YueClayton(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j)
+double DiversityCalculator::Manhattan(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context)
 {
+	const std::vector<double>& branchWeight = context.BranchWeights(com1);
+	double diss = 0;
+	uint n;
+	double p1, p2;
+	SparseDataVectorPair pair(com1, com2, context.begin, context.end);
+	while(pair.Next(n, p1, p2))
+		diss += fabs(p1 - p2)*branchWeight[n];
+
+	return diss;
+}
+
+double DiversityCalculator::MorisitaHorn(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context)
+{
+	const std::vector<double>& branchWeight = context.BranchWeights(com1);
+	double prodSum = 0;
+	double com1SumSqrd = 0;
+	double com2SumSqrd = 0;
+	uint n;
+	double p1, p2;
+	SparseDataVectorPair pair(com1, com2, context.begin, context.end);
+	while(pair.Next(n, p1, p2))
+	{
+		prodSum += p1*p2*branchWeight[n];
+
+		com1SumSqrd += p1*p1*branchWeight[n];
+		com2SumSqrd += p2*p2*branchWeight[n];
+	}
+
+	double num = 2*prodSum;
+	double den = ((com1SumSqrd/(m_weightedRowSum[i]*m_weightedRowSum[i])) + (com2SumSqrd/(m_weightedRowSum[j]*m_weightedRowSum[j])))*m_weightedRowSum[i]*m_weightedRowSum[j];
+
+	return 1.0 - num / den;
+}
+
+double DiversityCalculator::NormalizedWeightedUniFrac(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context)
+{
+	const std::vector<double>& branchWeight = context.BranchWeights(com1);
+	std::vector<double>& rootDistI = context.scratch.leafValuesI;
+	std::vector<double>& rootDistJ = context.scratch.leafValuesJ;
+	m_dataVec.LeafSetRootDistance(com1, com2, rootDistI, rootDistJ, context.scratch);
+
+	double num = 0;
+	uint n;
+	double p1, p2;
+	SparseDataVectorPair pair(com1, com2, context.begin, context.end);
+	while(pair.Next(n, p1, p2))
+		num += fabs(p1 - p2)*branchWeight[n];
+		
+	double den = 0;
+	for(uint l = 0; l < rootDistI.size(); ++l)
+		den += (rootDistI[l] + rootDistJ[l]);
+
+	if(den == 0)	// can occur if UniFrac is applied to OTU data
+		return 0;
+
+	return num / den;
+}
+
+double DiversityCalculator::Soergel(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context)
+{
+	const std::vector<double>& branchWeight = context.BranchWeights(com1);
 	double num = 0;
 	double den = 0;
-	for(uint n = 0; n < com1.size(); ++n)
+	uint n;
+	double p1, p2;
+	SparseDataVectorPair pair(com1, com2, context.begin, context.end);
+	while(pair.Next(n, p1, p2))
 	{
-		num += com1[n]*com2[n]*m_branchWeight[n];
+		num += fabs(p1 - p2)*branchWeight[n];
+		den += std::max<double>(p1, p2)*branchWeight[n];
+	}
+
+	return num / den;
+}
 
-		double d = com1[n] - com2[n];
-		den += (d*d + com1[n]*com2[n])*m_branchWeight[n];
+double DiversityCalculator::YueClayton(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context)
+{
+	const std::vector<double>& branchWeight = context.BranchWeights(com1);
+	double num = 0;
+	double den = 0;
+	uint n;
+	double p1, p2;
+	SparseDataVectorPair pair(com1, com2, context.begin, context.end);
+	while(pair.Next(n, p1, p2))
+	{
+		num += p1*p2*branchWeight[n];
+
+		double d = p1 - p2;
+		den += (d*d + p1*p2)*branchWeight[n];
 	}
 
 	return 1.0 - num / den;
 }
 
-double DiversityCalculator::Unit(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j)
+double DiversityCalculator::Unit(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context)
 {
 	return 1.0;
 }
 
-double DiversityCalculator::Sum(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j)
+double DiversityCalculator::Sum(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context)
 {
+	const std::vector<double>& branchWeight = context.BranchWeights(com1);
 	double sum = 0;
-	for(uint n = 0; n < com1.size(); ++n)
-		sum += (com1[n] + com2[n])*m_branchWeight[n];
+	uint n;
+	double p1, p2;
+	SparseDataVectorPair pair(com1, com2, context.begin, context.end);
+	while(pair.Next(n, p1, p2))
+		sum += (p1 + p2)*branchWeight[n];
 
 	return sum;
 }
 
-double DiversityCalculator::Extents(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j)
+double DiversityCalculator::BrayCurtis(const BitDataVector& com1, const BitDataVector& com2, uint i, uint j)
 {
-	double extents = 0;
-	for(uint n = 0; n < com1.size(); ++n)
-		extents += (m_maxExtent[n] - m_minExtent[n])*m_branchWeight[n];
+	double num = 0;
+	double den = 0;
+	for(uint w = 0; w < com1.bits.size(); ++w)
+	{
+		num += BitWeight(com1.bits[w] ^ com2.bits[w], w);
+		den += BitWeight(com1.bits[w], w) + BitWeight(com2.bits[w], w);
+	}
 
-	return extents;
+	return num / den;
+}
+
+double DiversityCalculator::Canberra(const BitDataVector& com1, const BitDataVector& com2, uint i, uint j)
+{
+	// entries present in only one sample contribute their full branch weight
+	double diss = 0;
+	for(uint w = 0; w < com1.bits.size(); ++w)
+		diss += BitWeight(com1.bits[w] ^ com2.bits[w], w);
+
+	return diss;
+}
+
+double DiversityCalculator::CoefficientOfSimilarity(const BitDataVector& com1, const BitDataVector& com2, uint i, uint j)
+{
+	double diss = 0;
+	for(uint w = 0; w < com1.bits.size(); ++w)
+		diss += BitWeight(com1.bits[w] ^ com2.bits[w], w);
+
+	return diss;
+}
+
+double DiversityCalculator::Euclidean(const BitDataVector& com1, const BitDataVector& com2, uint i, uint j)
+{
+	double diss = 0;
+	for(uint w = 0; w < com1.bits.size(); ++w)
+		diss += BitWeight(com1.bits[w] ^ com2.bits[w], w);
+
+	return sqrt(diss);
+}
+
+double DiversityCalculator::Kulczynski(const BitDataVector& com1, const BitDataVector& com2, uint i, uint j)
+{
+	double sumMin = 0;
+	for(uint w = 0; w < com1.bits.size(); ++w)
+		sumMin += BitWeight(com1.bits[w] & com2.bits[w], w);
+
+	return 1 - 0.5*(sumMin/m_weightedRowSum[i] + sumMin/m_weightedRowSum[j]);
+}
+
+double DiversityCalculator::LennonCD(const BitDataVector& com1, const BitDataVector& com2, uint i, uint j)
+{
+	double A = 0;
+	double B = 0;
+	double C = 0;
+	for(uint w = 0; w < com1.bits.size(); ++w)
+	{
+		A += BitWeight(com1.bits[w] & com2.bits[w], w);
+		B += BitWeight(com1.bits[w] & ~com2.bits[w], w);
+		C += BitWeight(com2.bits[w] & ~com1.bits[w], w);
+	}
+
+	return std::min<double>(B, C) / (std::min<double>(B, C) + A);
+}
+
+double DiversityCalculator::Manhattan(const BitDataVector& com1, const BitDataVector& com2, uint i, uint j)
+{
+	double diss = 0;
+	for(uint w = 0; w < com1.bits.size(); ++w)
+		diss += BitWeight(com1.bits[w] ^ com2.bits[w], w);
+
+	return diss;
+}
+
+double DiversityCalculator::Soergel(const BitDataVector& com1, const BitDataVector& com2, uint i, uint j)
+{
+	double num = 0;
+	double den = 0;
+	for(uint w = 0; w < com1.bits.size(); ++w)
+	{
+		num += BitWeight(com1.bits[w] ^ com2.bits[w], w);
+		den += BitWeight(com1.bits[w] | com2.bits[w], w);
+	}
+
+	return num / den;
 }
 
 bool DiversityCalculator::All(double threshold, const std::string& outputFile, const std::string& clusteringMethod)
@@ -1321,9 +2021,21 @@ bool DiversityCalculator::All(double threshold, const std::string& outputFile, c
 	bool bGood = m_dataVec.Init(m_tree, m_bPhylogenetic, true, !m_bCount, m_seqCountIO.GetSeqs());
 	if(!bGood)
 		return false;
+	m_validStatistics = 0;
+	m_dataVecCache.Clear();
+	EstimateDensity();
 
+	// calculate statistics needed by any weighted calculator in a single pass
 	std::set<std::string>::iterator weightedIter;
 	m_bWeighted = true;
+	uint statistics = 0;
+	for(weightedIter = m_weightedCalculators.begin(); weightedIter != m_weightedCalculators.end(); ++weightedIter)
+	{
+		SetCalculator(*weightedIter, false);
+		statistics |= m_requiredStatistics;
+	}
+	CalculateStatistics(statistics);
+
 	for(weightedIter = m_weightedCalculators.begin(); weightedIter != m_weightedCalculators.end(); ++weightedIter)
 	{
 		std::string calculatorStr = *weightedIter;
@@ -1339,8 +2051,20 @@ bool DiversityCalculator::All(double threshold, const std::string& outputFile, c
 
 	// calculate all unweighted (qualitative) measures
 	m_dataVec.Init(m_tree, m_bPhylogenetic, false, !m_bCount, m_seqCountIO.GetSeqs());
+	m_validStatistics = 0;
+	m_dataVecCache.Clear();
+
+	// calculate statistics needed by any unweighted calculator in a single pass
 	std::set<std::string>::iterator unweightedIter;
 	m_bWeighted = false;
+	statistics = 0;
+	for(unweightedIter = m_unweightedCalculators.begin(); unweightedIter != m_unweightedCalculators.end(); ++unweightedIter)
+	{
+		SetCalculator(*unweightedIter, false);
+		statistics |= m_requiredStatistics;
+	}
+	CalculateStatistics(statistics);
+
 	for(unweightedIter = m_unweightedCalculators.begin(); unweightedIter != m_unweightedCalculators.end(); ++unweightedIter)
 	{
 		std::string calculatorStr = *unweightedIter;
@@ -30,8 +30,90 @@
 #include "NewickIO.hpp"
 #include "SeqCountIO.hpp"
 #include "DataVectorizer.hpp"
+#include "DataVectorCache.hpp"
+#include "Subsampler.hpp"
 #include "LinearRegression.hpp"
 #include "Cluster.hpp"
+#include "VectorKernels.hpp"
+
+/**
+ * @brief Data vectors for a block of samples, held in the form compared by the current calculator.
+ */
+struct DataVectorBlock
+{
+	/** Data vectors in double precision. */
+	std::vector< std::vector<double> > dataVec;
+
+	/** Data vectors in single precision. */
+	std::vector< std::vector<float> > floatDataVec;
+
+	/** Sparse data vectors. */
+	std::vector<SparseDataVector> sparseDataVec;
+
+	/** Presence/absence data vectors. */
+	std::vector<BitDataVector> bitDataVec;
+
+	/** Get number of samples in block. */
+	uint GetSize() const { return dataVec.size() + floatDataVec.size() + sparseDataVec.size() + bitDataVec.size(); }
+
+	/** Remove all data vectors. */
+	void Clear() { dataVec.clear(); floatDataVec.clear(); sparseDataVec.clear(); bitDataVec.clear(); }
+
+	/** Exchange data vectors with another block. */
+	void Swap(DataVectorBlock& block) 
+	{ 
+		dataVec.swap(block.dataVec); 
+		floatDataVec.swap(block.floatDataVec); 
+		sparseDataVec.swap(block.sparseDataVec); 
+		bitDataVec.swap(block.bitDataVec); 
+	}
+};
+
+/**
+ * @brief State used by a thread to compare pairs of samples.
+ *
+ * Each thread comparing pairs has its own context, so the MRCA weighted branch weights, range of 
+ * entries, and buffers of the pair being compared are never shared between threads. Buffers 
+ * keep their capacity between pairs so comparing pairs does not allocate memory.
+ */
+struct CompareContext
+{
+	/** Constructor. */
+	CompareContext(): begin(0), end(0), branchWeight(NULL), floatBranchWeight(NULL) {}
+
+	/** First entry of the data vectors compared for the current pair. */
+	uint begin;
+
+	/** End of the range of entries compared for the current pair, which is the root of the MRCA subtree when restricted to it. */
+	uint end;
+
+	/** Branch weights used to compare the current pair, which point to the MRCA branch weights below when applying MRCA weightings. */
+	const std::vector<double>* branchWeight;
+
+	/** Branch weights used to compare the current pair in single precision. */
+	const std::vector<float>* floatBranchWeight;
+
+	/** Branch weights of the current pair weighted by its MRCA subtree. */
+	std::vector<double> mrcaBranchWeight;
+
+	/** MRCA branch weights of the current pair in single precision. */
+	std::vector<float> floatMrcaBranchWeight;
+
+	/** MRCA weighting of each node for the current pair. */
+	std::vector<double> mrcaNodeWeight;
+
+	/** Buffers for temporary values calculated by phylogenetic calculators. */
+	ScratchArena scratch;
+
+	/** Get branch weights used to compare the current pair with the same precision as a data vector. */
+	const std::vector<double>& BranchWeights(const std::vector<double>&) const { return *branchWeight; }
+	const std::vector<float>& BranchWeights(const std::vector<float>&) const { return *floatBranchWeight; }
+	const std::vector<double>& BranchWeights(const SparseDataVector&) const { return *branchWeight; }
+
+	/** Get MRCA branch weights with the same precision as a data vector. */
+	std::vector<double>& MRCABranchWeights(const std::vector<double>&) { return mrcaBranchWeight; }
+	std::vector<float>& MRCABranchWeights(const std::vector<float>&) { return floatMrcaBranchWeight; }
+};
 
 /**
  * @brief Measure beta-diversity with a variety of calculators.
@@ -41,7 +123,8 @@ class DiversityCalculator
 public:		
 	/** Constructor. */
 	DiversityCalculator(const std::string& seqCountFile, const std::string& treeFile, const std::string& calcStr, 
-												uint maxProfiles, bool bWeighted, bool bMRCA, bool bStrictMRCA, bool bCount, bool bVerbose);
+												uint maxProfiles, bool bWeighted, bool bMRCA, bool bStrictMRCA, bool bCount, bool bVerbose, bool bMemoryMap = false, bool bIndexFile = false, uint cacheSize = 1024, uint streamMemory = 4096, 
+												bool bSinglePrecision = false);
 
 	/** Destructor. */
 	~DiversityCalculator();
@@ -49,8 +132,18 @@ public:
 	/** Check good flag. */
 	bool IsGood() const { return m_bGood; }
 
-	/** Calculate dissimilarity between all pairs of samples. */
-	bool Dissimilarity(const std::string& outputPrefix, const std::string& clusteringMethod, uint jackknifeRep = 0, uint seqsToDraw = 0);
+	/** 
+	* @brief Calculate dissimilarity between all pairs of samples.
+	*
+	* @param outputPrefix Prefix of dissimilarity matrix and tree files.
+	* @param clusteringMethod Hierarchical clustering method used to build tree.
+	* @param jackknifeRep Number of jackknife replicates to perform.
+	* @param seqsToDraw Number of sequences to draw from each sample for jackknife replicates.
+	* @param bReplacement Flag indicating if sequences are drawn with replacement.
+	* @param seed Seed for drawing sequences, with identical seeds giving identical jackknife replicates.
+	*/
+	bool Dissimilarity(const std::string& outputPrefix, const std::string& clusteringMethod, uint jackknifeRep = 0, uint seqsToDraw = 0, 
+											bool bReplacement = true, uint seed = 0);
 
 	/** Apply all calculators. */
 	bool All(double threshold, const std::string& outputFile, const std::string& clusteringMethod);
@@ -61,33 +154,78 @@ public:
 	/** Check if a measure is unweighted. */
 	static bool IsUnweighted(const std::string& name);
 
+	/** Set if unweighted data vectors may be packed into presence/absence bits (default) or are always compared as dense data vectors. */
+	static void SetBitPacking(bool bBitPacking) { m_bBitPacking = bBitPacking; }
+
 private:
 	/** Read the sequence count file. */
-	bool ReadSeqCountFile(const std::string& seqCountFile);
+	bool ReadSeqCountFile(const std::string& seqCountFile, bool bMemoryMap, bool bIndexFile, uint streamMemory);
 
 	/** Read tree file.*/
 	bool ReadTreeFile(const std::string& treeFile);
 
-	/** Set desired calculator. */
-	bool SetCalculator(const std::string& calcStr);
+	/** 
+	* @brief Set desired calculator.
+	*
+	* @param calcStr Name of calculator.
+	* @param bCalculateStatistics Flag indicating if statistics required by the calculator should be calculated.
+	* @return True if calculator is valid, else false.
+	*/
+	bool SetCalculator(const std::string& calcStr, bool bCalculateStatistics = true);
 
 	/** Initialize object for vectorizing data in difference manners. */
 	bool InitDataVectorizer();
 
-	/** Calculate data vectors . */
-	void CalculateDataVectors(uint startIndex, uint numSamples, std::vector< std::vector<double> >& dataVec, uint seqsToDraw);
-
-	/** Calculate minimum and maximum value in each column. */
-	void CalculateColumnExtents();
-
-	/** Calculate sum of each column in the data matrix. */
-	void CalculateColumnSums();
-
-	/** Calculate sum of each row in the data matrix. */
-	void CalculateRowLeafSums(bool bSquared);
-
-	/** Calculate branch length weighted sum for each row in the data matrix. */
-	void CalculateWeightedRowSums();
+	/** Estimate fraction of data vector entries which are non-zero from the first few samples. */
+	void EstimateDensity();
+
+	/** 
+	* @brief Check if sparse data vectors are compared by the current calculator.
+	*
+	* Visiting the entries which are non-zero in either of two samples is slower per entry than 
+	* a pass over all entries, so sparse data vectors are only used when most entries are zero.
+	*/
+	bool IsSparse() const { return !IsBitPacked() && !m_bMRCA && m_sparseCalculator != NULL && m_density <= MAX_SPARSE_DENSITY; }
+
+	/** Check if presence/absence data vectors are compared by the current calculator. */
+	bool IsBitPacked() const { return m_bBitPacking && !m_bWeighted && !m_bMRCA && !m_bStrictMRCA && m_bitCalculator != NULL; }
+
+	/** 
+	* @brief Calculate data vectors.
+	*
+	* @param startIndex Index of first sample.
+	* @param numSamples Number of samples.
+	* @param block Data vector for each sample.
+	* @param seqsToDraw Number of sequences to draw from each sample for jackknife replicates.
+	* @param numThreads Number of threads used to calculate data vectors.
+	*/
+	void CalculateDataVectors(uint startIndex, uint numSamples, DataVectorBlock& block, uint seqsToDraw, uint numThreads);
+
+	/** 
+	* @brief Calculate data vector of a sample, which may be called concurrently for different samples.
+	*
+	* @param index Index of sample.
+	* @param k Index of sample within block.
+	* @param block Data vector for each sample of block.
+	* @param seqsToDraw Number of sequences to draw from each sample for jackknife replicates.
+	* @param scratch Buffers of the calling thread.
+	*/
+	void CalculateDataVector(uint index, uint k, DataVectorBlock& block, uint seqsToDraw, VectorizeScratch& scratch);
+
+	/** Get wall-clock time in seconds, which unlike std::clock() excludes time used by other threads. */
+	static double WallTime();
+
+	/** Cache dense data vector of a sample in the representation used to compare samples. */
+	void CacheDataVector(uint index, const std::vector<double>& dataVec, double cost);
+
+	/** 
+	* @brief Calculate column and row statistics of the data matrix in a single pass.
+	*
+	* Statistics already calculated since the data vectorizer was last initialized are not recalculated.
+	*
+	* @param statistics Statistics to calculate (combination of STATISTIC flags).
+	*/
+	void CalculateStatistics(uint statistics);
 
 	/** Get length or weight of each branch. */
 	void GetBranchWeights();
@@ -107,45 +245,152 @@ private:
 	/** Create dissimilarity matrix. */
 	bool CreateDissimilarityMatrix(const std::string& dissFile, Tree<Node>* tree, const std::string& clusteringMethod, uint seqsToDraw = 0);
 
+	/** 
+	* @brief Calculate dissimilarity between samples in the current row and column blocks.
+	*
+	* Rows are compared by a team with one thread for each context, and memory allocated while comparing 
+	* pairs is added to the count of pair allocations.
+	*
+	* @param row Index of row block.
+	* @param col Index of column block.
+	* @param blockLen Number of samples in each block.
+	* @param partialDissMatrix Dissimilarity between samples in the row block and all preceding samples.
+	* @param contexts State of each thread comparing the blocks.
+	*/
+	template<class T>
+	void CompareBlocks(uint row, uint col, uint blockLen, T* partialDissMatrix, std::vector<CompareContext>& contexts);
+
+	/** Set branch weights and size buffers of a thread so they never grow while comparing pairs. */
+	void InitCompareContext(CompareContext& context);
+
+	/** 
+	* @brief Calculate dissimilarity between a pair of samples.
+	*
+	* @param com1 Data vector of first sample.
+	* @param com2 Data vector of second sample.
+	* @param i Index of first sample within its block.
+	* @param j Index of second sample within its block.
+	* @param calculator Calculator for data vectors of this precision.
+	* @param context State of the thread comparing the pair, which holds the MRCA branch weights and range of entries of the pair.
+	*/
+	template<class T>
+	double Compare(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, 
+										double (*calculator)(const std::vector<T>&, const std::vector<T>&, uint, uint, CompareContext&), CompareContext& context);
+
+	/** Calculate dissimilarity between a pair of samples given as sparse data vectors. */
+	double Compare(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context);
+
+	/** Build table giving the summed branch weight of each nibble (4 bits) of a presence/absence data vector. */
+	void BuildBitWeightTable();
+
+	/** Get summed branch weight of the set bits in a word of a presence/absence data vector. */
+	static double BitWeight(uint64 bits, uint word)
+	{
+		// high nibbles without set bits are skipped, and partial sums are kept 
+		// separately so lookups of consecutive nibbles do not wait on each other
+		const double* table = &m_bitWeightTable[word*16*16];
+		double sums[2] = { 0, 0 };
+		for(uint k = 0; bits != 0; ++k, bits >>= 4)
+			sums[k & 1] += table[k*16 + (bits & 0xf)];
+
+		return sums[0] + sums[1];
+	}
+
+	/** Sum branch weighted terms over the range of a pair of data vectors given by a context with a kernel of the selected instruction set. */
+	template<class T>
+	static void SumElements(typename VectorKernelTable<T>::Kernel kernel, const std::vector<T>& com1, const std::vector<T>& com2, CompareContext& context, double* sums);
+
 	/** Create jackknife tree.*/
 	bool JackknifeTree(Tree<Node>* inputTree, const std::vector<Tree<Node>*>& jackknifeTrees);
 
-	static double BrayCurtis(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j);
-	static double Canberra(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j);
-	static double ChiSquared(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j);
-	static double CoefficientOfSimilarity(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j);
-	static double CompleteTree(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j);
-	static double Euclidean(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j);
-	static double Fst(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j);
-	static double Gower(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j);
-	static double Hellinger(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j);
-	static double Kulczynski(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j);
-	static double LennonCD(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j);
-	static double LennonLRG(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j);
-	static double Manhattan(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j);
-	static double MNND(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j);
-	static double MPD(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j);
-	static double MorisitaHorn(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j);
-	static double NormalizedWeightedUniFrac(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j);
-	static double Pearson(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j);
-	static double RaoHp(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j);
-	static double Soergel(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j);
-	static double SpeciesProfile(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j);
-	static double TamasCoefficient(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j);
-	static double WeightedCorrelation(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j);
-	static double Whittaker(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j);
-	static double YueClayton(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j);
-
-	static double Unit(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j);
-	static double Sum(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j);
-	static double Extents(const std::vector<double>& com1, const std::vector<double>& com2, uint i, uint j);
+	template<class T> static double BrayCurtis(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context);
+	template<class T> static double Canberra(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context);
+	template<class T> static double ChiSquared(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context);
+	template<class T> static double CoefficientOfSimilarity(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context);
+	template<class T> static double CompleteTree(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context);
+	template<class T> static double Euclidean(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context);
+	template<class DataVector> static double Fst(const DataVector& com1, const DataVector& com2, uint i, uint j, CompareContext& context);
+	template<class T> static double Gower(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context);
+	template<class T> static double Hellinger(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context);
+	template<class T> static double Kulczynski(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context);
+	template<class T> static double LennonCD(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context);
+	template<class T> static double LennonLRG(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context);
+	template<class T> static double Manhattan(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context);
+	template<class DataVector> static double MNND(const DataVector& com1, const DataVector& com2, uint i, uint j, CompareContext& context);
+	template<class DataVector> static double MPD(const DataVector& com1, const DataVector& com2, uint i, uint j, CompareContext& context);
+	template<class T> static double MorisitaHorn(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context);
+	template<class T> static double NormalizedWeightedUniFrac(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context);
+	template<class T> static double Pearson(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context);
+	template<class DataVector> static double RaoHp(const DataVector& com1, const DataVector& com2, uint i, uint j, CompareContext& context);
+	template<class T> static double Soergel(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context);
+	template<class T> static double SpeciesProfile(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context);
+	template<class T> static double TamasCoefficient(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context);
+	template<class T> static double WeightedCorrelation(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context);
+	template<class T> static double Whittaker(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context);
+	template<class T> static double YueClayton(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context);
+
+	template<class T> static double Unit(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context);
+	template<class T> static double Sum(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context);
+	template<class T> static double Extents(const std::vector<T>& com1, const std::vector<T>& com2, uint i, uint j, CompareContext& context);
+
+	// calculators over sparse data vectors visit only entries which are non-zero in either sample
+	static double BrayCurtis(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context);
+	static double Canberra(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context);
+	static double CoefficientOfSimilarity(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context);
+	static double Euclidean(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context);
+	static double Kulczynski(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context);
+	static double LennonCD(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context);
+	static double LennonLRG(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context);
+	static double Manhattan(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context);
+	static double MorisitaHorn(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context);
+	static double NormalizedWeightedUniFrac(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context);
+	static double Soergel(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context);
+	static double YueClayton(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context);
+
+	static double Unit(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context);
+	static double Sum(const SparseDataVector& com1, const SparseDataVector& com2, uint i, uint j, CompareContext& context);
+
+	// calculators over presence/absence data vectors sum branch weights over the AND, OR, or XOR of both samples
+	static double BrayCurtis(const BitDataVector& com1, const BitDataVector& com2, uint i, uint j);
+	static double Canberra(const BitDataVector& com1, const BitDataVector& com2, uint i, uint j);
+	static double CoefficientOfSimilarity(const BitDataVector& com1, const BitDataVector& com2, uint i, uint j);
+	static double Euclidean(const BitDataVector& com1, const BitDataVector& com2, uint i, uint j);
+	static double Kulczynski(const BitDataVector& com1, const BitDataVector& com2, uint i, uint j);
+	static double LennonCD(const BitDataVector& com1, const BitDataVector& com2, uint i, uint j);
+	static double Manhattan(const BitDataVector& com1, const BitDataVector& com2, uint i, uint j);
+	static double Soergel(const BitDataVector& com1, const BitDataVector& com2, uint i, uint j);
 	
 private:
-	typedef std::tr1::function<double (const std::vector<double>&, const std::vector<double>&, uint, uint)> CalculatorFunc;
+	/** Maximum fraction of non-zero data vector entries for sparse data vectors to be compared. */
+	static const double MAX_SPARSE_DENSITY;
+
+	/** Number of samples used to estimate the fraction of non-zero data vector entries. */
+	static const uint DENSITY_SAMPLES;
 
-	/** Function object indicating calculator to use. */
+	/** Smallest cost in seconds of reading and vectorizing a sample, so samples read faster than the timer resolution still have a cost. */
+	static const double MIN_READ_COST;
+
+	/** Column and row statistics of the data matrix required by some calculators. */
+	enum STATISTIC { COLUMN_EXTENTS = 1, COLUMN_SUMS = 2, ROW_LEAF_SUMS = 4, ROW_LEAF_SUMS_SQRD = 8, WEIGHTED_ROW_SUMS = 16 };
+
+	typedef double (*CalculatorFunc)(const std::vector<double>&, const std::vector<double>&, uint, uint, CompareContext&);
+	typedef double (*FloatCalculatorFunc)(const std::vector<float>&, const std::vector<float>&, uint, uint, CompareContext&);
+
+	typedef double (*SparseCalculatorFunc)(const SparseDataVector&, const SparseDataVector&, uint, uint, CompareContext&);
+	typedef double (*BitCalculatorFunc)(const BitDataVector&, const BitDataVector&, uint, uint);
+
+	/** Calculator to use. */
 	CalculatorFunc m_calculator;
 
+	/** Variant of calculator over single precision data vectors. */
+	FloatCalculatorFunc m_floatCalculator;
+
+	/** Variant of calculator over sparse data vectors (NULL if there is none). */
+	SparseCalculatorFunc m_sparseCalculator;
+
+	/** Variant of unweighted calculator over presence/absence data vectors (NULL if there is none). */
+	BitCalculatorFunc m_bitCalculator;
+
 	/** Provides access to data in sequence count file. */
 	SeqCountIO m_seqCountIO;
 
@@ -158,6 +403,15 @@ private:
 	/** Maximum number of data vectors to have in memory at once. */
 	uint m_maxDataVecs;
 
+	/** Data vectors retained between blocks of the dissimilarity matrix. */
+	DataVectorCache m_dataVecCache;
+
+	/** Draws sequences from samples for jackknife replicates. */
+	Subsampler m_subsampler;
+
+	/** Index of jackknife replicate being calculated. */
+	uint m_jackknifeRep;
+
 	/** Flag indicating if weighted vectors are to be generated. */
 	static bool m_bWeighted;
 
@@ -170,6 +424,9 @@ private:
 	/** Flag indicating if count data should be used or if it should be normalized to relative proportions. */
 	bool m_bCount;
 
+	/** Flag indicating if data vectors, branch weights, and dissimilarities are stored in single precision. */
+	bool m_bSinglePrecision;
+
 	/** Flag indicating if phylogenetic vectors are to be generated. */
 	bool m_bPhylogenetic;
 
@@ -179,6 +436,21 @@ private:
 	/** Tree for phylogenetic beta-diversity calculations. */
 	Tree<Node>* m_tree;
 
+	/** Estimated fraction of data vector entries which are non-zero. */
+	double m_density;
+
+	/** Number of pairs of samples compared. */
+	uint64 m_numPairs;
+
+	/** Number of memory allocations made while comparing pairs of samples. */
+	uint64 m_pairAllocations;
+
+	/** Statistics required by the current calculator. */
+	uint m_requiredStatistics;
+
+	/** Statistics calculated since the data vectorizer was last initialized. */
+	uint m_validStatistics;
+
 	/** Number of samples. */
 	static uint m_numSamples;
 
@@ -188,11 +460,20 @@ private:
 	/** Branch length/weight associated with each column. */
 	static std::vector<double> m_branchWeight;
 
+	/** Branch length/weight associated with each column in single precision. */
+	static std::vector<float> m_floatBranchWeight;
+
+	/** Summed branch weight of each of the 256 values of each byte of a presence/absence data vector. */
+	static std::vector<double> m_bitWeightTable;
+
+	/** Flag indicating if unweighted data vectors may be packed into presence/absence bits. */
+	static bool m_bBitPacking;
+
 	/** Data vectors for current rows in dissimilarity matrix being processed. */ 
-	static std::vector< std::vector<double> > m_dataVecRows;
+	static DataVectorBlock m_dataVecRows;
 
 	/** Data vectors for current columns in dissimilarity matrix being processed. */ 
-	static std::vector< std::vector<double> > m_dataVecCols;
+	static DataVectorBlock m_dataVecCols;
 
 	/** Minimum value in each column of data matrix. */
 	static std::vector<double> m_minExtent;
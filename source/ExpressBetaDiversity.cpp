@@ -30,16 +30,23 @@
 
 #include "UnitTests.hpp"
 
+#include "VectorKernels.hpp"
+
 bool ParseCommandLine(int argc, char* argv[], std::string& treeFile, std::string& seqCountFile, std::string& outputPrefix,
-											std::string& clusteringMethod, uint& jackknifeRep, uint& seqToDraw, bool& bSampleSize,
-											std::string& calcStr, uint& maxDataVecs, bool& bWeighted, bool& bMRCA, bool& bStrictMRCA, bool& bCount,
-											bool& bAll, double& threshold, std::string& outputFile, bool& bVerbose)
+											std::string& clusteringMethod, uint& jackknifeRep, uint& seqToDraw, bool& bReplacement, uint& seed, bool& bSampleSize,
+											std::string& calcStr, uint& maxDataVecs, uint& cacheSize, bool& bSinglePrecision, bool& bWeighted, bool& bMRCA, bool& bStrictMRCA, bool& bCount,
+											bool& bAll, double& threshold, std::string& outputFile, bool& bMemoryMap, bool& bIndexFile, uint& streamMemory, std::string& binaryFile, std::string& bgzfFile, uint& numThreads, bool& bVerbose)
 {
 	bool bShowHelp, bShowCalc, bUnitTests;
 	std::string maxDataVecsStr;
+	std::string cacheSizeStr;
+	std::string streamMemoryStr;
+	std::string precisionStr;
 	std::string thresholdStr;
 	std::string jackknifeRepStr;
 	std::string seqToDrawStr;
+	std::string seedStr;
+	std::string numThreadsStr;
 	GetOpt::GetOpt_pp opts(argc, argv);
 	opts >> GetOpt::OptionPresent('h', "help", bShowHelp);
 	opts >> GetOpt::OptionPresent('l', "list-calc", bShowCalc);
@@ -51,9 +58,15 @@ bool ParseCommandLine(int argc, char* argv[], std::string& treeFile, std::string
 	opts >> GetOpt::Option('g', "clustering", clusteringMethod, "UPGMA");
 	opts >> GetOpt::Option('j', "jackknife", jackknifeRepStr, "0");
 	opts >> GetOpt::Option('d', "seqs-to-draw", seqToDrawStr, "0");
+	bool bWithoutReplacement;
+	opts >> GetOpt::OptionPresent(0, "without-replacement", bWithoutReplacement);
+	bReplacement = !bWithoutReplacement;
+	opts >> GetOpt::Option(0, "seed", seedStr);
 	opts >> GetOpt::OptionPresent('z', "sample-size", bSampleSize);
 	opts >> GetOpt::Option('c', "calculator", calcStr);
 	opts >> GetOpt::Option('x', "max-data-vecs", maxDataVecsStr, "1000");
+	opts >> GetOpt::Option(0, "cache-size", cacheSizeStr, "1024");
+	opts >> GetOpt::Option(0, "precision", precisionStr, "double");
 	opts >> GetOpt::OptionPresent('w', "weighted", bWeighted);
 	opts >> GetOpt::OptionPresent('m', "mrca", bMRCA);
 	opts >> GetOpt::OptionPresent('r', "strict-mrca", bStrictMRCA);
@@ -61,11 +74,24 @@ bool ParseCommandLine(int argc, char* argv[], std::string& treeFile, std::string
 	opts >> GetOpt::OptionPresent('a', "all", bAll);
 	opts >> GetOpt::Option('b', "threshold", thresholdStr, "0.8");
 	opts >> GetOpt::Option('o', "output-file", outputFile, "clusters.txt");
+	opts >> GetOpt::OptionPresent(0, "mmap", bMemoryMap);
+	bool bNoIndexFile;
+	opts >> GetOpt::OptionPresent(0, "no-index", bNoIndexFile);
+	bIndexFile = !bNoIndexFile;
+	opts >> GetOpt::Option(0, "stream-memory", streamMemoryStr, "4096");
+	opts >> GetOpt::Option(0, "write-binary", binaryFile);
+	opts >> GetOpt::Option(0, "write-bgzf", bgzfFile);
+	opts >> GetOpt::Option(0, "threads", numThreadsStr, "0");
 
 	maxDataVecs = atoi(maxDataVecsStr.c_str());
+	cacheSize = atoi(cacheSizeStr.c_str());
+	streamMemory = atoi(streamMemoryStr.c_str());
+	bSinglePrecision = (precisionStr == "float");
 	threshold = atof(thresholdStr.c_str());
 	jackknifeRep = atoi(jackknifeRepStr.c_str());
 	seqToDraw = atoi(seqToDrawStr.c_str());
+	seed = seedStr.empty() ? (uint)time(NULL) : (uint)strtoul(seedStr.c_str(), NULL, 10);
+	numThreads = atoi(numThreadsStr.c_str());
 
 	if(bShowHelp || argc <= 1)
 	{
@@ -79,13 +105,15 @@ bool ParseCommandLine(int argc, char* argv[], std::string& treeFile, std::string
 		std::cout << "  -u, --unit-tests     Execute unit tests." << std::endl;
 		std::cout << std::endl;
 		std::cout << "  -t, --tree-file      Tree in Newick format (if phylogenetic beta-diversity is desired)." << std::endl;
-		std::cout << "  -s, --seq-count-file Sequence count file." << std::endl;
+		std::cout << "  -s, --seq-count-file Sequence count file ('-' to read from standard input)." << std::endl;
 		std::cout << "  -p, --output-prefix  Output prefix (default = output)." << std::endl;
 		std::cout << std::endl;
 		std::cout << "  -g, --clustering     Hierarchical clustering method: UPGMA, SingleLinkage, CompleteLinkage, NJ (default = UPGMA)." << std::endl;
 		std::cout << std::endl;
 		std::cout << "  -j, --jackknife      Number of jackknife replicates to perform (default = 0)." << std::endl;
 		std::cout << "  -d, --seqs-to-draw   Number of sequence to draw for jackknife replicates." << std::endl;
+		std::cout << "      --without-replacement Draw sequences for jackknife replicates without replacement (i.e., rarefy samples)." << std::endl;
+		std::cout << "      --seed           Seed for drawing sequences, so jackknife replicates can be reproduced (default = current time)." << std::endl;
 		std::cout << "  -z, --sample-size    Print number of sequences in each sample." << std::endl;
 		std::cout << std::endl;
 		std::cout << "  -c, --calculator     Desired calculator (e.g., Bray-Curtis, Canberra)." << std::endl;
@@ -95,11 +123,20 @@ bool ParseCommandLine(int argc, char* argv[], std::string& treeFile, std::string
 		std::cout << "  -y, --count          Use count data as opposed to relative proportions." << std::endl;
 		std::cout << std::endl;
 		std::cout << "  -x, --max-data-vecs  Maximum number of profiles (data vectors) to have in memory at once (default = 1000)." << std::endl;
+		std::cout << "      --cache-size     Memory in MB for caching profiles between blocks of the dissimilarity matrix (default = 1024)." << std::endl;
+		std::cout << "      --precision      Precision of profiles and dissimilarities: double or float (default = double)." << std::endl;
 		std::cout << std::endl;
 		std::cout << "  -a, --all            Apply all calculators and cluster calculators at the specified threshold." << std::endl;
 		std::cout << "  -b, --threshold      Correlation threshold for clustering calculators (default = 0.8)." << std::endl;
 		std::cout << "  -o, --output-file    Output file for cluster of calculators (default = clusters.txt)." << std::endl;
 		std::cout << std::endl;
+		std::cout << "      --mmap           Memory map the sequence count file instead of reading it through a file stream." << std::endl;
+		std::cout << "      --no-index       Do not read or write an index of the samples next to a tab-delimited sequence count file." << std::endl;
+		std::cout << "      --stream-memory  Memory in MB for samples read from standard input or a pipe before they are spilled to disk (default = 4096)." << std::endl;
+		std::cout << "      --write-binary   Convert sequence count file to the specified binary sequence count file." << std::endl;
+		std::cout << "      --write-bgzf     Compress tab-delimited sequence count file into the specified block compressed (BGZF) file." << std::endl;
+		std::cout << "      --threads        Number of threads to use (default = 0, i.e. all available processors)." << std::endl;
+		std::cout << std::endl;
 		std::cout << "  -v, --verbose        Provide additional information on program execution." << std::endl;
 
 		return false;
@@ -156,11 +193,18 @@ bool ParseCommandLine(int argc, char* argv[], std::string& treeFile, std::string
 		return false;
 	}
 
-	if(bSampleSize)
+	if(bSampleSize || !binaryFile.empty() || !bgzfFile.empty())
 	{
 		return true;
 	}
 
+	if(precisionStr != "double" && precisionStr != "float")
+	{
+		std::cout << std::endl;
+		std::cout << "  [Error] Unknown precision specified: " << precisionStr << " (must be double or float)." << std::endl;
+		return false;
+	}
+
 	if(!seqCountFile.empty() && !bAll && calcStr.empty())
 	{
 		std::cout << std::endl;
@@ -237,6 +281,9 @@ int main(int argc, char* argv[])
 
 	srand((uint)time(NULL));
 
+	// select vector instructions supported by this processor
+	VectorKernels::Init();
+
 	// parse command line arguments
 	std::string treeFile;
 	std::string seqCountFile;
@@ -245,27 +292,42 @@ int main(int argc, char* argv[])
 	std::string calcStr;
 	uint jackknifeRep;
 	uint seqToDraw;
+	bool bReplacement;
+	uint seed;
 	bool bSampleSize;
 	uint maxDataVecs;
+	uint cacheSize;
+	bool bSinglePrecision;
 	bool bWeighted;
 	bool bMRCA;
 	bool bStrictMRCA;
 	bool bCount;
+	bool bMemoryMap;
+	bool bIndexFile;
+	uint streamMemory;
+	std::string binaryFile;
+	std::string bgzfFile;
+	uint numThreads;
 	bool bVerbose;
 	bool bAll;
 	double threshold;
 	std::string outputFile;
 	if(!ParseCommandLine(argc, argv, treeFile, seqCountFile, outputPrefix, clusteringMethod,
-												jackknifeRep, seqToDraw, bSampleSize,
-												calcStr, maxDataVecs, bWeighted, bMRCA, bStrictMRCA,
-												bCount, bAll, threshold, outputFile, bVerbose))
+												jackknifeRep, seqToDraw, bReplacement, seed, bSampleSize,
+												calcStr, maxDataVecs, cacheSize, bSinglePrecision, bWeighted, bMRCA, bStrictMRCA,
+												bCount, bAll, threshold, outputFile, bMemoryMap, bIndexFile, streamMemory, binaryFile, bgzfFile, numThreads, bVerbose))
 	{
 		return 0;
 	}
 
+#ifdef _OPENMP
+	if(numThreads > 0)
+		omp_set_num_threads(numThreads);
+#endif
+
 	if(bAll)
 	{
-		DiversityCalculator calculator(seqCountFile, treeFile, "", maxDataVecs, false, false, bStrictMRCA, bCount, bVerbose);
+		DiversityCalculator calculator(seqCountFile, treeFile, "", maxDataVecs, false, false, bStrictMRCA, bCount, bVerbose, bMemoryMap, bIndexFile, cacheSize, streamMemory, bSinglePrecision);
 
 		if(!calculator.IsGood())
 			return -1;
@@ -274,10 +336,45 @@ int main(int argc, char* argv[])
 		return 0;
 	}
 
+	if(!binaryFile.empty())
+	{
+		SeqCountIO seqCountIO;
+		if(!seqCountIO.Read(seqCountFile, bMemoryMap, bIndexFile, streamMemory))
+			return -1;
+
+		if(!seqCountIO.WriteBinary(binaryFile))
+			return -1;
+
+		std::cout << "Binary sequence count file written to: " << binaryFile << std::endl;
+
+		return 0;
+	}
+
+	if(!bgzfFile.empty())
+	{
+		SeqCountIO seqCountIO;
+		if(!seqCountIO.Read(seqCountFile, bMemoryMap, bIndexFile, streamMemory))
+			return -1;
+
+		if(seqCountIO.GetFormat() != SeqCountIO::TAB_DELIMITED_FORMAT || seqCountIO.IsCompressed() || seqCountIO.IsStream())
+		{
+			std::cerr << "Only uncompressed tab-delimited sequence count files can be block compressed." << std::endl;
+			return -1;
+		}
+
+		if(!BgzfFile::Compress(seqCountFile, bgzfFile))
+			return -1;
+
+		std::cout << "Block compressed sequence count file written to: " << bgzfFile << std::endl;
+
+		return 0;
+	}
+
 	if(bSampleSize)
 	{
 		SeqCountIO sampleCountIO;
-		sampleCountIO.Read(seqCountFile);
+		if(!sampleCountIO.Read(seqCountFile, bMemoryMap, bIndexFile, streamMemory))
+			return -1;
 
 		std::string sampleWithMinSeqs;
 		double minSeqs = std::numeric_limits<double>::max();
@@ -285,9 +382,10 @@ int main(int argc, char* argv[])
 		std::cout << "Sample Id" << '\t' << "Number of Sequences" << std::endl;
 		for(uint i = 0; i < sampleCountIO.GetNumSamples(); ++i)
 		{
+			std::vector<uint> seqIndices;
 			std::vector<double> count;
 			double totalNumSeqs;
-			sampleCountIO.GetData(i, count, totalNumSeqs);
+			sampleCountIO.GetSparseData(i, seqIndices, count, totalNumSeqs);
 
 			std::cout << sampleCountIO.GetSampleName(i) << '\t' << totalNumSeqs << std::endl;
 
@@ -305,15 +403,18 @@ int main(int argc, char* argv[])
 	}
 
 	if(bVerbose)
+	{
 		std::cout << "Express Beta Diversity:" << std::endl << std::endl;
+		std::cout << "  Vector instructions for element-wise calculators: " << VectorKernels::GetName(VectorKernels::GetInstructionSet()) << std::endl;
+	}
 
 	// set diversity calculator
-	DiversityCalculator calculator(seqCountFile, treeFile, calcStr, maxDataVecs, bWeighted, bMRCA, bStrictMRCA, bCount, bVerbose);
+	DiversityCalculator calculator(seqCountFile, treeFile, calcStr, maxDataVecs, bWeighted, bMRCA, bStrictMRCA, bCount, bVerbose, bMemoryMap, bIndexFile, cacheSize, streamMemory, bSinglePrecision);
 	if(!calculator.IsGood())
 		return -1;
 
 	// compute dissimilarity between all pairs of samples
-	if(!calculator.Dissimilarity(outputPrefix, clusteringMethod, jackknifeRep, seqToDraw))
+	if(!calculator.Dissimilarity(outputPrefix, clusteringMethod, jackknifeRep, seqToDraw, bReplacement, seed))
 		return -1;
 
 	std::clock_t timeEnd = std::clock();
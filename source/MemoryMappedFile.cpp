@@ -0,0 +1,141 @@
+//=======================================================================
+// Author: Donovan Parks
+//
+// Copyright 2011 Donovan Parks
+//
+// This file is part of ExpressBetaDiversity.
+//
+// ExpressBetaDiversity is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+//
+// ExpressBetaDiversity is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ExpressBetaDiversity. If not, see
+// <http://www.gnu.org/licenses/>.
+//=======================================================================
+
+#include "Precompiled.hpp"
+
+#include "MemoryMappedFile.hpp"
+
+#if defined(WIN32) || defined(_WIN32)
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+MemoryMappedFile::MemoryMappedFile()
+	: m_data(NULL), m_size(0)
+{
+#if defined(WIN32) || defined(_WIN32)
+	m_file = INVALID_HANDLE_VALUE;
+	m_mapping = NULL;
+#endif
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+	Close();
+}
+
+#if defined(WIN32) || defined(_WIN32)
+
+bool MemoryMappedFile::Open(const std::string& filename)
+{
+	Close();
+
+	m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(m_file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if(!GetFileSizeEx(m_file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+
+	m_mapping = CreateFileMapping(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(m_mapping == NULL)
+	{
+		Close();
+		return false;
+	}
+
+	m_data = (const char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+	if(m_data == NULL)
+	{
+		Close();
+		return false;
+	}
+
+	m_size = (size_t)fileSize.QuadPart;
+
+	return true;
+}
+
+void MemoryMappedFile::Close()
+{
+	if(m_data)
+		UnmapViewOfFile(m_data);
+
+	if(m_mapping)
+		CloseHandle(m_mapping);
+
+	if(m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+
+	m_data = NULL;
+	m_size = 0;
+	m_mapping = NULL;
+	m_file = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+bool MemoryMappedFile::Open(const std::string& filename)
+{
+	Close();
+
+	int fd = open(filename.c_str(), O_RDONLY);
+	if(fd == -1)
+		return false;
+
+	struct stat fileStat;
+	if(fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	void* data = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);	// mapping remains valid after the descriptor is closed
+
+	if(data == MAP_FAILED)
+		return false;
+
+	m_data = (const char*)data;
+	m_size = (size_t)fileStat.st_size;
+
+	return true;
+}
+
+void MemoryMappedFile::Close()
+{
+	if(m_data)
+		munmap((void*)m_data, m_size);
+
+	m_data = NULL;
+	m_size = 0;
+}
+
+#endif
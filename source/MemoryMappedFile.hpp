@@ -0,0 +1,81 @@
+//=======================================================================
+// Author: Donovan Parks
+//
+// Copyright 2011 Donovan Parks
+//
+// This file is part of ExpressBetaDiversity.
+//
+// ExpressBetaDiversity is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+//
+// ExpressBetaDiversity is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ExpressBetaDiversity. If not, see
+// <http://www.gnu.org/licenses/>.
+//=======================================================================
+
+#ifndef _MEMORY_MAPPED_FILE_
+#define _MEMORY_MAPPED_FILE_
+
+#include "Precompiled.hpp"
+
+/**
+ * @brief Read-only view of a file mapped into memory.
+ */
+class MemoryMappedFile
+{
+public:
+	/** Constructor. */
+	MemoryMappedFile();
+
+	/** Destructor. */
+	~MemoryMappedFile();
+
+	/**
+	* @brief Map file into memory.
+	*
+	* @param filename Path to file.
+	* @return True if file mapped successfully, else false.
+	*/
+	bool Open(const std::string& filename);
+
+	/** Unmap file. */
+	void Close();
+
+	/** Check if a file is currently mapped. */
+	bool IsOpen() const { return m_data != NULL; }
+
+	/** Get pointer to start of mapped file. */
+	const char* GetData() const { return m_data; }
+
+	/** Get size of mapped file in bytes. */
+	size_t GetSize() const { return m_size; }
+
+private:
+	/** Disallow copying as the mapping is owned by this object. */
+	MemoryMappedFile(const MemoryMappedFile& rhs);
+	MemoryMappedFile& operator=(const MemoryMappedFile& rhs);
+
+private:
+	/** Start of mapped file. */
+	const char* m_data;
+
+	/** Size of mapped file. */
+	size_t m_size;
+
+#if defined(WIN32) || defined(_WIN32)
+	/** Handle to file. */
+	void* m_file;
+
+	/** Handle to file mapping object. */
+	void* m_mapping;
+#endif
+};
+
+#endif
@@ -61,6 +61,10 @@
 	#include <tr1/functional>
 #endif
 
+#ifdef _OPENMP
+	#include <omp.h>
+#endif
+
 #include "DataTypes.hpp"
 
 #endif
@@ -25,9 +25,55 @@
 #include "SeqCountIO.hpp"
 #include "StringTools.hpp"
 
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#if !defined(WIN32) && !defined(_WIN32)
+	#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+	#include <emmintrin.h>
+	#define EBD_SSE2
+#endif
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+// Index files have the following layout (all values in native byte order):
+//   magic ('EBDI'), version (uint32), size of sequence count file (uint64), modification time of sequence count file (uint64),
+//   number of sequences (uint32), number of samples (uint32), length of longest sample (uint64),
+//   sequence names and sample names (each a uint32 length followed by the characters of the name),
+//   file offset of each sample plus the end of the last sample (uint64).
+
+// Binary sequence count files have the following layout (all values in native byte order):
+//   magic ('EBDB'), version (uint32), number of sequences (uint32), number of samples (uint32), 
+//   count type (uint32), flags (uint32),
+//   sequence names and sample names (each a uint32 length followed by the characters of the name),
+//   file offset of each sample plus the end of the last sample (uint64),
+//   count data for each sample, with each sample padded to a multiple of 8 bytes.
+// Count data is either a count for every sequence or, if the BINARY_SPARSE_ROWS flag is set, the
+// number of non-zero counts (uint32) followed by the index of each sequence with a non-zero 
+// count (uint32) and then the non-zero counts.
+const char SeqCountIO::BINARY_MAGIC[4] = { 'E', 'B', 'D', 'B' };
+const uint SeqCountIO::BINARY_VERSION = 1;
+
+const char SeqCountIO::INDEX_MAGIC[4] = { 'E', 'B', 'D', 'I' };
+const uint SeqCountIO::INDEX_VERSION = 1;
+const std::string SeqCountIO::INDEX_EXTENSION = ".ebdidx";
+
+const std::string SeqCountIO::STDIN_FILENAME = "-";
+
+const size_t SeqCountIO::READ_BLOCK_SIZE = 1024*1024;
+const size_t SeqCountIO::PARALLEL_SCAN_SIZE = 256*1024;
+const uint SeqCountIO::PARALLEL_LINES = 1024;
+const int SeqCountIO::MAX_INTEGER_DIGITS = 15;
+
 SeqCountIO::SeqCountIO() 
+	: m_buffer(NULL), m_longestRow(0), m_format(TAB_DELIMITED_FORMAT), m_binaryCountType(BINARY_UINT32), m_binaryFlags(0), m_bIndexFileUsed(false), m_bStream(false)
 {
-	m_buffer = NULL;
+
 }
 
 SeqCountIO::~SeqCountIO() 
@@ -37,128 +83,1397 @@ SeqCountIO::~SeqCountIO()
 
 	if(m_file.is_open())
 		m_file.close(); 
+
+	if(IsSpilled())
+	{
+		m_mappedFile.Close();
+		remove(m_spillFile.c_str());
+	}
 }
 
-bool SeqCountIO::Read(const std::string& filename)
+bool SeqCountIO::Read(const std::string& filename, bool bMemoryMap, bool bIndexFile, uint streamMemory)
 {
-	m_file.open(filename.c_str());
-	if(!m_file.is_open())
+	// pipes can only be read once so the format of the file can not be determined in advance
+	if(IsStreamFile(filename))
 	{
-		std::cerr << "Unable to open sequence file: " << filename << std::endl;
+#if defined(WIN32) || defined(_WIN32)
+		if(filename == STDIN_FILENAME)
+			return ReadStream(std::cin, bMemoryMap, streamMemory);
+#endif
+
+		// standard input is opened as a file as reading lines through std::cin is slow
+		std::string streamFile = (filename == STDIN_FILENAME) ? "/dev/stdin" : filename;
+		std::ifstream fin(streamFile.c_str(), std::ios::in | std::ios::binary);
+		if(!fin.is_open())
+		{
+			std::cerr << "Unable to open sequence file: " << filename << std::endl;
+			return false;
+		}
+
+		return ReadStream(fin, bMemoryMap, streamMemory);
+	}
+
+	// only tab-delimited files are read compressed, so compressed data is never taken for another format
+	bool bGzip = BgzfFile::IsGzipFile(filename);
+	if(!bGzip)
+	{
+		if(IsBinaryFile(filename))
+			return ReadBinary(filename, bMemoryMap);
+		else if(BiomIO::IsBiomFile(filename))
+			return ReadBiom(filename);
+		else if(IsTripletFile(filename))
+			return ReadTriplets(filename);
+	}
+
+	// reuse start of each sample from a previous run if the file is unchanged
+	m_bIndexFileUsed = bIndexFile && ReadIndexFile(filename);
+
+	if(bGzip && !BgzfFile::IsBgzfFile(filename))
+	{
+		std::cerr << "Sequence file is gzip compressed, but not block compressed (BGZF): " << filename << std::endl;
 		return false;
 	}
+	else if(BgzfFile::IsBgzfFile(filename))
+	{
+		if(!m_bgzfFile.Open(filename))
+		{
+			std::cerr << "Unable to open block compressed sequence file: " << filename << std::endl;
+			return false;
+		}
+
+		if(!m_bIndexFileUsed && !IndexBgzf())
+		{
+			std::cerr << "Unable to decompress sequence file: " << filename << std::endl;
+			return false;
+		}
+
+		// allocate temporary buffer for reading lines
+		m_buffer = new char[(uint)m_longestRow];
+	}
+	else if(bMemoryMap)
+	{
+		if(!m_mappedFile.Open(filename))
+		{
+			std::cerr << "Unable to memory map sequence file: " << filename << std::endl;
+			return false;
+		}
+
+		if(!m_bIndexFileUsed)
+			IndexTextBlock(m_mappedFile.GetData(), m_mappedFile.GetSize(), 0, true);
+	}
+	else
+	{
+		// file is opened in binary mode so stream positions are byte offsets on all platforms
+		m_file.open(filename.c_str(), std::ios::in | std::ios::binary);
+		if(!m_file.is_open())
+		{
+			std::cerr << "Unable to open sequence file: " << filename << std::endl;
+			return false;
+		}
+
+		if(!m_bIndexFileUsed)
+			IndexStream();
+
+		// allocate temporary buffer for reading lines
+		m_buffer = new char[(uint)m_longestRow];
+	}
+
+	if(bIndexFile && !m_bIndexFileUsed)
+		WriteIndexFile(filename);
+
+	return true;
+}
+
+void SeqCountIO::IndexStream()
+{
+	// index file a block at a time, carrying any partial line at the end of a block over to the next block
+	std::vector<char> block(READ_BLOCK_SIZE);
+	size_t carry = 0;
+	uint64 blockOffset = 0;
+	bool bEndOfFile = false;
+	while(!bEndOfFile)
+	{
+		if(carry == block.size())
+			block.resize(2*block.size());	// line is longer than a block
+
+		m_file.read(&block[carry], block.size() - carry);
+		size_t blockSize = carry + (size_t)m_file.gcount();
+		bEndOfFile = !m_file.good();
+
+		// only index complete lines
+		size_t blockEnd = blockSize;
+		if(!bEndOfFile)
+		{
+			while(blockEnd > 0 && block[blockEnd-1] != '\n')
+				--blockEnd;
+		}
+
+		if(blockEnd > 0)
+			IndexTextBlock(&block[0], blockEnd, blockOffset, bEndOfFile);
+
+		carry = blockSize - blockEnd;
+		memmove(&block[0], &block[blockEnd], carry);
+		blockOffset += blockEnd;
+	}
+	m_file.clear();
+}
+
+bool SeqCountIO::IndexBgzf()
+{
+	// decompress enough blocks at a time to keep all threads busy, carrying any partial line over to the next batch
+	uint blocksPerBatch = (uint)(READ_BLOCK_SIZE / BgzfFile::MAX_BLOCK_SIZE);
+#ifdef _OPENMP
+	blocksPerBatch = std::max<uint>(blocksPerBatch, omp_get_max_threads());
+#endif
+
+	std::vector<char> block;
+	uint64 blockOffset = 0;
+	uint numBlocks = m_bgzfFile.GetNumBlocks();
+	for(uint firstBlock = 0; firstBlock < numBlocks; firstBlock += blocksPerBatch)
+	{
+		if(!m_bgzfFile.ReadBlocks(firstBlock, std::min(blocksPerBatch, numBlocks - firstBlock), block))
+			return false;
+
+		bool bEndOfFile = (firstBlock + blocksPerBatch >= numBlocks);
+
+		// only index complete lines
+		size_t blockEnd = block.size();
+		if(!bEndOfFile)
+		{
+			while(blockEnd > 0 && block[blockEnd-1] != '\n')
+				--blockEnd;
+		}
+
+		if(blockEnd > 0)
+			IndexTextBlock(&block[0], blockEnd, blockOffset, bEndOfFile);
+
+		block.erase(block.begin(), block.begin() + blockEnd);
+		blockOffset += blockEnd;
+	}
+
+	return true;
+}
+
+bool SeqCountIO::IsStreamFile(const std::string& filename)
+{
+	if(filename == STDIN_FILENAME)
+		return true;
+
+#if defined(WIN32) || defined(_WIN32)
+	return false;
+#else
+	struct stat fileStat;
+	if(stat(filename.c_str(), &fileStat) != 0)
+		return false;
+
+	return S_ISFIFO(fileStat.st_mode) || S_ISCHR(fileStat.st_mode) || S_ISSOCK(fileStat.st_mode);
+#endif
+}
 
-	// check if file ends with a end-of-line character(s)
-	char c;
-	bool bEndOfLineTerminator = true;
-	m_file.seekg(-1, std::ios::end);
-	m_file.read(&c, 1);
-	if(c != '\n')
-		bEndOfLineTerminator = false;
-	m_file.seekg(0, std::ios::beg);
+bool SeqCountIO::ReadStream(std::istream& in, bool bMemoryMap, uint streamMemory)
+{
+	m_bStream = true;
 
 	// parse header line to get order of sequences
-	std::string line, token;
-	std::getline(m_file, line);
-	std::stringstream ss(line);
-	while(std::getline(ss, token, '\t'))
+	std::string line;
+	if(!std::getline(in, line))
+		return true;	// empty stream
+
+	if(line.compare(0, sizeof(BINARY_MAGIC), BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0 
+				|| line.compare(0, 2, "\x1f\x8b") == 0 || (!line.empty() && line[0] == '{'))
+	{
+		std::cerr << "Only uncompressed tab-delimited sequence count files can be read from a stream." << std::endl;
+		return false;
+	}
+
+	std::stringstream header(line);
+	std::string token;
+	while(std::getline(header, token, '\t'))
 	{
+		token = StringTools::RemoveSurroundingWhiteSpaces(token);
 		if(!token.empty())
-			m_seqs.push_back(StringTools::RemoveSurroundingWhiteSpaces(token));
+			m_seqs.push_back(token);
 	}
 
-	// get number of samples and starting index of each sample line
-	std::streamsize longestLine = 0;
-	do
+	// read each sample once, holding its non-zero counts in memory until the memory limit is reached
+	uint64 memoryLimit = (uint64)streamMemory*1024*1024;
+	m_sampleOffsets.assign(1, 0);
+
+	std::ofstream spill;
+	std::vector<uint> seqIndices;
+	std::vector<double> count;
+	while(std::getline(in, line))
 	{
-		if(!line.empty())
+		if(line.empty())
+			continue;
+
+		const char* lineStart = line.c_str();
+		const char* lineEnd = lineStart + line.size();
+		const char* tabPos = (const char*)memchr(lineStart, '\t', lineEnd - lineStart);
+		m_sampleNames.push_back(std::string(lineStart, (tabPos != NULL) ? tabPos : lineEnd));
+
+		double totalNumSeq;
+		ParseSparseCounts((tabPos != NULL) ? tabPos + 1 : lineEnd, lineEnd, seqIndices, count, totalNumSeq);
+
+		if(spill.is_open())
 		{
-			if(!m_sampleStreamPos.empty())
-			{
-				uint pos = line.find('\t');
-				m_sampleNames.push_back(line.substr(0, pos));
+			m_longestRow = std::max(m_longestRow, WriteSparseRow(spill, seqIndices, count, BINARY_DOUBLE));
+			m_sampleStreamPos.push_back(spill.tellp());
+		}
+		else
+		{
+			m_memSeqIndices.insert(m_memSeqIndices.end(), seqIndices.begin(), seqIndices.end());
+			m_memCounts.insert(m_memCounts.end(), count.begin(), count.end());
+			m_sampleOffsets.push_back(m_memCounts.size());
 
-				std::streamsize lineLen = m_file.tellg() - m_sampleStreamPos[m_sampleStreamPos.size()-1] + 2;	// +2 is for end-of-line character
-				if(lineLen > longestLine)
-					longestLine = lineLen;
-			}
+			if(m_memCounts.size()*(sizeof(uint) + sizeof(double)) >= memoryLimit && !SpillToDisk(spill))
+				return false;
+		}
+	}
+
+	if(!spill.is_open())
+		return true;
+
+	// access spilled samples as a sparse binary sequence count file
+	spill.close();
+	if(spill.fail())
+	{
+		std::cerr << "Failed to write temporary file: " << m_spillFile << std::endl;
+		return false;
+	}
 
-			m_sampleStreamPos.push_back(m_file.tellg());
+	m_format = BINARY_FORMAT;
+	m_binaryCountType = BINARY_DOUBLE;
+	m_binaryFlags = BINARY_SPARSE_ROWS;
+
+	if(bMemoryMap)
+	{
+		if(!m_mappedFile.Open(m_spillFile))
+		{
+			std::cerr << "Unable to memory map temporary file: " << m_spillFile << std::endl;
+			return false;
 		}
-	} while(std::getline(m_file, line));
-	m_file.clear();
+	}
+	else
+	{
+		m_file.open(m_spillFile.c_str(), std::ios::in | std::ios::binary);
+		if(!m_file.is_open())
+		{
+			std::cerr << "Unable to open temporary file: " << m_spillFile << std::endl;
+			return false;
+		}
+
+		m_buffer = new char[(uint)std::max<std::streamsize>(m_longestRow, 1)];
+	}
 
-	// allocate temporary buffer for reading lines
-	m_buffer = new char[(uint)longestLine];
+	return true;
+}
 
-	// ensure we read the entire last line of the file
-	if(!bEndOfLineTerminator)
+bool SeqCountIO::SpillToDisk(std::ofstream& spill)
+{
+	if(!CreateTempFile(m_spillFile))
 	{
-		int endOfLineLen = 1;
-		#if defined(WIN32) || defined(_WIN32) || defined(__WIN32) && !defined(__CYGWIN__)
-			endOfLineLen = 2;
-		#endif
-	
-		m_file.seekg(endOfLineLen, std::ios::end);
-		m_sampleStreamPos[m_sampleStreamPos.size()-1] = m_file.tellg();
+		std::cerr << "Unable to create temporary file for spilling sequence count data to disk." << std::endl;
+		return false;
+	}
+
+	spill.open(m_spillFile.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if(!spill.is_open())
+	{
+		std::cerr << "Unable to open temporary file: " << m_spillFile << std::endl;
+		return false;
+	}
+
+	m_sampleStreamPos.assign(1, 0);
+
+	std::vector<uint> seqIndices;
+	std::vector<double> count;
+	for(uint i = 0; i < m_sampleNames.size(); ++i)
+	{
+		double totalNumSeq;
+		GetMemoryData(i, seqIndices, count, totalNumSeq);
+		m_longestRow = std::max(m_longestRow, WriteSparseRow(spill, seqIndices, count, BINARY_DOUBLE));
+		m_sampleStreamPos.push_back(spill.tellp());
 	}
 
+	// release memory held by samples
+	std::vector<uint64>().swap(m_sampleOffsets);
+	std::vector<uint>().swap(m_memSeqIndices);
+	std::vector<double>().swap(m_memCounts);
+
 	return true;
 }
 
-void SeqCountIO::GetData(uint index, std::vector<double>& count, double& totalNumSeq, uint seqsToDraw)
+bool SeqCountIO::CreateTempFile(std::string& filename)
 {
-	// read the ith sample from file
-	m_file.seekg(m_sampleStreamPos[index]);
-	
-	std::streamsize charsInLine = m_sampleStreamPos[index+1] - m_sampleStreamPos[index] - 1;
-	m_file.read(m_buffer, charsInLine);
-	m_buffer[charsInLine] = 0;
-	
-	// read sample name
-	char* curPos = (char *)memchr(m_buffer, '\t', (size_t)charsInLine);
-	++curPos;
-	charsInLine -= (curPos - m_buffer);
-
-	// read count data
-	totalNumSeq = 0;
-	count.clear();
-	count.reserve(m_seqs.size());
-	do
+#if defined(WIN32) || defined(_WIN32)
+	char* name = _tempnam(NULL, "ebd");
+	if(name == NULL)
+		return false;
+
+	filename = name;
+	free(name);
+	return true;
+#else
+	const char* tempDir = getenv("TMPDIR");
+	std::string pattern = std::string((tempDir != NULL && tempDir[0] != 0) ? tempDir : "/tmp") + "/ebd_spill_XXXXXX";
+
+	std::vector<char> name(pattern.begin(), pattern.end());
+	name.push_back(0);
+	int fd = mkstemp(&name[0]);
+	if(fd == -1)
+		return false;
+
+	close(fd);
+	filename = &name[0];
+	return true;
+#endif
+}
+
+bool SeqCountIO::GetFileFingerprint(const std::string& filename, uint64& fileSize, uint64& modTime)
+{
+	struct stat fileStat;
+	if(stat(filename.c_str(), &fileStat) != 0)
+		return false;
+
+	fileSize = (uint64)fileStat.st_size;
+	modTime = (uint64)fileStat.st_mtime;
+
+	return true;
+}
+
+bool SeqCountIO::ReadIndexFile(const std::string& filename)
+{
+	uint64 fileSize, modTime;
+	if(!GetFileFingerprint(filename, fileSize, modTime))
+		return false;
+
+	std::ifstream fin((filename + INDEX_EXTENSION).c_str(), std::ios::in | std::ios::binary);
+	if(!fin.is_open())
+		return false;
+
+	uint64 indexSize = GetStreamSize(fin);
+
+	// index is only valid if the sequence count file has not changed since the index was written
+	char magic[sizeof(INDEX_MAGIC)];
+	fin.read(magic, sizeof(magic));
+
+	uint version;
+	uint64 indexFileSize, indexModTime;
+	ReadValue(fin, version);
+	ReadValue(fin, indexFileSize);
+	ReadValue(fin, indexModTime);
+
+	if(!fin.good() || memcmp(magic, INDEX_MAGIC, sizeof(magic)) != 0 || version != INDEX_VERSION 
+				|| indexFileSize != fileSize || indexModTime != modTime)
+		return false;
+
+	uint numSeqs, numSamples;
+	uint64 longestRow;
+	ReadValue(fin, numSeqs);
+	ReadValue(fin, numSamples);
+	ReadValue(fin, longestRow);
+
+	if(!CheckHeaderSize(fin, indexSize, numSeqs, numSamples))
+		return false;
+
+	m_seqs.resize(numSeqs);
+	for(uint i = 0; i < numSeqs && fin.good(); ++i)
+		ReadString(fin, m_seqs[i], indexSize);
+
+	m_sampleNames.resize(numSamples);
+	for(uint i = 0; i < numSamples && fin.good(); ++i)
+		ReadString(fin, m_sampleNames[i], indexSize);
+
+	m_sampleStreamPos.resize((uint64)numSamples+1);
+	for(uint64 i = 0; i < (uint64)numSamples+1 && fin.good(); ++i)
 	{
-		char* tabPos = (char *)memchr(curPos, '\t', (size_t)charsInLine);
-		if(tabPos != NULL)
-			tabPos[0] = 0;
+		uint64 pos;
+		ReadValue(fin, pos);
+		m_sampleStreamPos[i] = (std::streamoff)pos;
+	}
 
-		double numSeq = (double)StringTools::ToDouble(curPos);
-		count.push_back(numSeq);
-		totalNumSeq += numSeq;		
+	if(!fin.good())
+	{
+		// truncated or corrupt index
+		m_seqs.clear();
+		m_sampleNames.clear();
+		m_sampleStreamPos.clear();
+		return false;
+	}
+
+	m_longestRow = (std::streamsize)longestRow;
+
+	return true;
+}
+
+bool SeqCountIO::WriteIndexFile(const std::string& filename) const
+{
+	uint64 fileSize, modTime;
+	if(!GetFileFingerprint(filename, fileSize, modTime) || m_sampleStreamPos.empty())
+		return false;
+
+	// write to a temporary file first so other processes never see a partially written index
+	std::string indexFile = filename + INDEX_EXTENSION;
+	std::string tempFile = indexFile + ".tmp" + StringTools::ToString(rand());
+	std::ofstream fout(tempFile.c_str(), std::ios::out | std::ios::binary);
+	if(!fout.is_open())
+		return false;
+
+	fout.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+	WriteValue<uint>(fout, INDEX_VERSION);
+	WriteValue(fout, fileSize);
+	WriteValue(fout, modTime);
+	WriteValue<uint>(fout, m_seqs.size());
+	WriteValue<uint>(fout, m_sampleNames.size());
+	WriteValue<uint64>(fout, m_longestRow);
+
+	for(uint i = 0; i < m_seqs.size(); ++i)
+		WriteString(fout, m_seqs[i]);
+
+	for(uint i = 0; i < m_sampleNames.size(); ++i)
+		WriteString(fout, m_sampleNames[i]);
+
+	for(uint i = 0; i < m_sampleStreamPos.size(); ++i)
+		WriteValue<uint64>(fout, (std::streamoff)m_sampleStreamPos[i]);
+
+	bool bGood = fout.good();
+	fout.close();
+
+	if(bGood)
+	{
+		#if defined(WIN32) || defined(_WIN32)
+			remove(indexFile.c_str());	// rename will not replace an existing file
+		#endif
+
+		bGood = (rename(tempFile.c_str(), indexFile.c_str()) == 0);
+	}
+
+	if(!bGood)
+		remove(tempFile.c_str());
+
+	return bGood;
+}
+
+void SeqCountIO::FindAll(const char* data, size_t size, char c, std::vector<size_t>& positions)
+{
+	positions.clear();
+
+	// split data into a chunk per thread, unless it is too small to benefit from multiple threads
+	int numChunks = 1;
+#ifdef _OPENMP
+	if(size >= PARALLEL_SCAN_SIZE)
+		numChunks = omp_get_max_threads();
+#endif
 
-		charsInLine -= (tabPos - curPos) + 1;
-		curPos = tabPos + 1;
-	}while(count.size() != m_seqs.size());
+	std::vector< std::vector<size_t> > chunkPositions(numChunks);
 
-	// jackknife data vector
-	if(seqsToDraw != 0)
-	{	
-		std::vector<double> jackknife(m_seqs.size(), 0);
-		for(uint i = 0; i < seqsToDraw; ++i)
+	#pragma omp parallel for schedule(static, 1) if(numChunks > 1)
+	for(int chunk = 0; chunk < numChunks; ++chunk)
+	{
+		const char* curPos = data + (size * chunk) / numChunks;
+		const char* endPos = data + (size * (chunk+1)) / numChunks;
+		while((curPos = (const char*)memchr(curPos, c, endPos - curPos)) != NULL)
 		{
-			double r = rand()/(RAND_MAX/totalNumSeq);
+			chunkPositions[chunk].push_back(curPos - data);
+			++curPos;
+		}
+	}
 
-			double seqCount = 0;
-			for(uint j = 0; j < count.size(); ++j)
-			{
-				seqCount += count.at(j);
-				if(r <= seqCount)
-				{
-					jackknife.at(j) += 1;
-					break;
-				}
-			}
+	for(int chunk = 0; chunk < numChunks; ++chunk)
+		positions.insert(positions.end(), chunkPositions[chunk].begin(), chunkPositions[chunk].end());
+}
+
+void SeqCountIO::IndexTextBlock(const char* block, size_t size, uint64 blockOffset, bool bEndOfFile)
+{
+	// find end of each line
+	std::vector<size_t> lineEnds;
+	FindAll(block, size, '\n', lineEnds);
+	if(bEndOfFile && size > 0 && block[size-1] != '\n')
+		lineEnds.push_back(size);	// last line is not terminated by an end-of-line character
+
+	uint firstLine = 0;
+	if(m_sampleStreamPos.empty())
+	{
+		if(lineEnds.empty())
+			return;
+
+		// parse header line to get order of sequences
+		std::vector<size_t> tabs;
+		FindAll(block, lineEnds[0], '\t', tabs);
+		tabs.push_back(lineEnds[0]);
+
+		std::vector<std::string> tokens(tabs.size());
+		#pragma omp parallel for if(tabs.size() >= PARALLEL_LINES)
+		for(int i = 0; i < (int)tabs.size(); ++i)
+		{
+			size_t tokenStart = (i == 0) ? 0 : tabs[i-1] + 1;
+			tokens[i] = StringTools::RemoveSurroundingWhiteSpaces(std::string(block + tokenStart, block + tabs[i]));
+		}
+
+		for(uint i = 0; i < tokens.size(); ++i)
+		{
+			if(!tokens[i].empty())
+				m_seqs.push_back(tokens[i]);
+		}
+
+		m_sampleStreamPos.push_back(blockOffset + lineEnds[0] + 1);
+		firstLine = 1;
+	}
+
+	// get name of each sample
+	std::vector<std::string> names(lineEnds.size());
+	#pragma omp parallel for if(lineEnds.size() >= PARALLEL_LINES)
+	for(int i = firstLine; i < (int)lineEnds.size(); ++i)
+	{
+		const char* lineStart = block + ((i == 0) ? 0 : lineEnds[i-1] + 1);
+		const char* lineEnd = block + lineEnds[i];
+		if(lineStart != lineEnd)
+		{
+			const char* tabPos = (const char*)memchr(lineStart, '\t', lineEnd - lineStart);
+			names[i].assign(lineStart, (tabPos != NULL) ? tabPos : lineEnd);
+		}
+	}
+
+	// record start of each sample line
+	for(uint i = firstLine; i < lineEnds.size(); ++i)
+	{
+		size_t lineStart = (i == 0) ? 0 : lineEnds[i-1] + 1;
+		if(lineEnds[i] == lineStart)
+			continue;
+
+		m_sampleNames.push_back(std::string());
+		m_sampleNames.back().swap(names[i]);
+
+		std::streampos samplePos = (std::streamoff)(blockOffset + lineEnds[i] + 1);
+		m_longestRow = std::max<std::streamsize>(m_longestRow, samplePos - m_sampleStreamPos.back() + 1);
+		m_sampleStreamPos.push_back(samplePos);
+	}
+}
+
+void SeqCountIO::GetTextRow(uint index, const char*& curPos, const char*& endPos)
+{
+	const char* lineStart;
+	if(m_mappedFile.IsOpen())
+	{
+		// get the ith sample directly from the mapped file
+		const char* data = m_mappedFile.GetData();
+		lineStart = data + (std::streamoff)m_sampleStreamPos[index];
+		endPos = data + std::min<std::streamoff>((std::streamoff)m_sampleStreamPos[index+1] - 1, m_mappedFile.GetSize());
+	}
+	else if(m_bgzfFile.IsOpen())
+	{
+		// decompress the blocks containing the ith sample
+		std::streamsize charsInLine = m_sampleStreamPos[index+1] - m_sampleStreamPos[index] - 1;
+		if(m_bgzfFile.Read((std::streamoff)m_sampleStreamPos[index], m_buffer, (size_t)charsInLine) != (size_t)charsInLine)
+		{
+			std::cerr << "Unable to decompress sample: " << m_sampleNames[index] << std::endl;
+			charsInLine = 0;
 		}
 
-		totalNumSeq = seqsToDraw;
-		count = jackknife;
+		lineStart = m_buffer;
+		endPos = m_buffer + charsInLine;
+	}
+	else
+	{
+		// read the ith sample from file
+		m_file.seekg(m_sampleStreamPos[index]);
+		
+		std::streamsize charsInLine = m_sampleStreamPos[index+1] - m_sampleStreamPos[index] - 1;
+		m_file.read(m_buffer, charsInLine);
+		m_buffer[charsInLine] = 0;
+
+		lineStart = m_buffer;
+		endPos = m_buffer + charsInLine;
+	}
+
+	// skip sample name
+	curPos = (const char*)memchr(lineStart, '\t', endPos - lineStart);
+	curPos = (curPos != NULL) ? curPos + 1 : endPos;
+}
+
+void SeqCountIO::GetData(uint index, std::vector<double>& count, double& totalNumSeq)
+{
+	if(m_format == BINARY_FORMAT)
+		GetBinaryData(index, count, totalNumSeq);
+	else if(IsInMemory())
+	{
+		std::vector<uint> seqIndices;
+		std::vector<double> nonZeroCount;
+		GetMemoryData(index, seqIndices, nonZeroCount, totalNumSeq);
+
+		count.clear();
+		count.resize(m_seqs.size(), 0);
+		for(uint i = 0; i < seqIndices.size(); ++i)
+			count[seqIndices[i]] = nonZeroCount[i];
+	}
+	else
+	{
+		const char* curPos;
+		const char* endPos;
+		GetTextRow(index, curPos, endPos);
+		ParseCounts(curPos, endPos, count, totalNumSeq);
+	}
+}
+
+void SeqCountIO::GetSparseData(uint index, std::vector<uint>& seqIndices, std::vector<double>& count, double& totalNumSeq)
+{
+	if(m_format == BINARY_FORMAT)
+		GetSparseBinaryData(index, seqIndices, count, totalNumSeq);
+	else if(IsInMemory())
+		GetMemoryData(index, seqIndices, count, totalNumSeq);
+	else
+	{
+		const char* curPos;
+		const char* endPos;
+		GetTextRow(index, curPos, endPos);
+		ParseSparseCounts(curPos, endPos, seqIndices, count, totalNumSeq);
 	}
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Find successive tabs in a row of a tab-delimited file.
+ *
+ * Where SSE2 is available, 16 characters are compared at once and the tabs among them
+ * are recorded in a bit mask, which is far cheaper than a call to memchr per token.
+ */
+class TabScanner
+{
+public:
+	/** Constructor. */
+	TabScanner(const char* start, const char* end) 
+		: m_chunk(start), m_end(end), m_chunkStart(start), m_mask(0) {}
+
+	/** Get position of next tab, or end of row if there are no more tabs. */
+	const char* Next()
+	{
+	#ifdef EBD_SSE2
+		const __m128i tabs = _mm_set1_epi8('\t');
+		while(m_mask == 0 && m_end - m_chunk >= 16)
+		{
+			// never load beyond the end of the row as it may be the end of a memory mapped file
+			__m128i chars = _mm_loadu_si128((const __m128i*)m_chunk);
+			m_mask = (uint)_mm_movemask_epi8(_mm_cmpeq_epi8(chars, tabs));
+			m_chunkStart = m_chunk;
+			m_chunk += 16;
+		}
+
+		if(m_mask != 0)
+		{
+			uint bit = LowestBit(m_mask);
+			m_mask &= m_mask - 1;
+			return m_chunkStart + bit;
+		}
+	#endif
+
+		const char* tabPos = (const char*)memchr(m_chunk, '\t', m_end - m_chunk);
+		if(tabPos == NULL)
+		{
+			m_chunk = m_end;
+			return m_end;
+		}
+
+		m_chunk = tabPos + 1;
+		return tabPos;
+	}
+
+private:
+	/** Get index of lowest set bit in a non-zero mask. */
+	static uint LowestBit(uint mask)
+	{
+	#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return index;
+	#else
+		return __builtin_ctz(mask);
+	#endif
+	}
+
+private:
+	/** Start of characters not yet examined. */
+	const char* m_chunk;
+
+	/** End of row. */
+	const char* m_end;
+
+	/** Start of the characters described by the mask. */
+	const char* m_chunkStart;
+
+	/** Bit mask of tabs in the most recently examined characters not yet returned. */
+	uint m_mask;
+};
+
+double SeqCountIO::ParseCount(const char* curPos, const char* tabPos)
+{
+	// counts are almost always small non-negative integers which are converted exactly here, 
+	// with anything else (e.g., '.', 'e', '-') left to the general parser
+	if(tabPos - curPos <= MAX_INTEGER_DIGITS)
+	{
+		uint64 value = 0;
+		const char* pos = curPos;
+		while(pos < tabPos && (uint)(*pos - '0') < 10)
+		{
+			value = 10*value + (*pos - '0');
+			++pos;
+		}
+
+		if(pos == tabPos || (pos + 1 == tabPos && *pos == '\r'))
+			return (double)value;
+	}
+
+	// tokens are copied so parsing never reads beyond the end of the line
+	char token[64];
+	size_t tokenLen = tabPos - curPos;
+	if(tokenLen < sizeof(token))
+	{
+		memcpy(token, curPos, tokenLen);
+		token[tokenLen] = 0;
+		return StringTools::ToDouble(token);
+	}
+
+	return StringTools::ToDouble(std::string(curPos, tabPos).c_str());
+}
+
+void SeqCountIO::ParseCounts(const char* curPos, const char* endPos, std::vector<double>& count, double& totalNumSeq) const
+{
+	totalNumSeq = 0;
+	count.clear();
+	count.reserve(m_seqs.size());
+
+	TabScanner tabScanner(curPos, endPos);
+	while(count.size() != m_seqs.size())
+	{
+		const char* tabPos = tabScanner.Next();
+
+		double numSeq = ParseCount(curPos, tabPos);
+		count.push_back(numSeq);
+		totalNumSeq += numSeq;		
+
+		curPos = (tabPos < endPos) ? tabPos + 1 : endPos;
+	}
+}
+
+void SeqCountIO::ParseSparseCounts(const char* curPos, const char* endPos, std::vector<uint>& seqIndices, std::vector<double>& count, double& totalNumSeq) const
+{
+	totalNumSeq = 0;
+	seqIndices.clear();
+	count.clear();
+
+	TabScanner tabScanner(curPos, endPos);
+	for(uint i = 0; i < m_seqs.size(); ++i)
+	{
+		const char* tabPos = tabScanner.Next();
+
+		// zero counts are by far the most common token so are skipped without being parsed
+		if(!(tabPos - curPos == 1 && *curPos == '0') && tabPos != curPos)
+		{
+			double numSeq = ParseCount(curPos, tabPos);
+			if(numSeq != 0)
+			{
+				seqIndices.push_back(i);
+				count.push_back(numSeq);
+				totalNumSeq += numSeq;
+			}
+		}
+
+		curPos = (tabPos < endPos) ? tabPos + 1 : endPos;
+	}
+}
+
+bool SeqCountIO::IsTripletFile(const std::string& filename)
+{
+	if(BgzfFile::IsGzipFile(filename))
+		return false;
+
+	std::ifstream fin(filename.c_str());
+	if(!fin.is_open())
+		return false;
+
+	// the header line of a tab-delimited sequence count file starts with a tab whereas the 
+	// first line of a sparse triplet file has a sequence, sample, and (optional) count
+	std::string line;
+	while(std::getline(fin, line))
+	{
+		if(line.empty() || line[0] == '#' || StringTools::IsEmpty(line))
+			continue;
+
+		uint numTabs = std::count(line.begin(), line.end(), '\t');
+		return line[0] != '\t' && (numTabs == 1 || numTabs == 2);
+	}
+
+	return false;
+}
+
+bool SeqCountIO::ReadTriplets(const std::string& filename)
+{
+	std::ifstream fin(filename.c_str());
+	if(!fin.is_open())
+	{
+		std::cerr << "Unable to open sequence file: " << filename << std::endl;
+		return false;
+	}
+
+	std::map<std::string, uint> seqIds;
+	std::map<std::string, uint> sampleIds;
+	std::vector<uint> entrySamples;
+	std::vector<uint> entrySeqs;
+	std::vector<double> entryCounts;
+
+	std::string line;
+	uint lineNum = 0;
+	while(std::getline(fin, line))
+	{
+		++lineNum;
+		if(line.empty() || line[0] == '#' || StringTools::IsEmpty(line))
+			continue;
+
+		size_t seqEnd = line.find('\t');
+		if(seqEnd == std::string::npos)
+		{
+			std::cerr << "Invalid line " << lineNum << " in sparse sequence file: " << filename << std::endl;
+			return false;
+		}
+
+		// count is optional and taken to be 1 if absent
+		size_t sampleEnd = line.find('\t', seqEnd+1);
+		std::string seqId = StringTools::RemoveSurroundingWhiteSpaces(line.substr(0, seqEnd));
+		std::string sampleId = StringTools::RemoveSurroundingWhiteSpaces(line.substr(seqEnd+1, sampleEnd - (seqEnd+1)));
+		double count = 1;
+		if(sampleEnd != std::string::npos)
+			count = StringTools::ToDouble(line.c_str() + sampleEnd + 1);
+
+		std::map<std::string, uint>::iterator seqIt = seqIds.insert(std::make_pair(seqId, seqIds.size())).first;
+
+		std::map<std::string, uint>::iterator sampleIt = sampleIds.find(sampleId);
+		if(sampleIt == sampleIds.end())
+		{
+			sampleIt = sampleIds.insert(std::make_pair(sampleId, m_sampleNames.size())).first;
+			m_sampleNames.push_back(sampleId);
+		}
+
+		if(count != 0)
+		{
+			entrySamples.push_back(sampleIt->second);
+			entrySeqs.push_back(seqIt->second);
+			entryCounts.push_back(count);
+		}
+	}
+
+	// sequences are ordered by name as done by the convertToEBD.py script
+	std::vector<uint> seqOrder(seqIds.size());
+	m_seqs.reserve(seqIds.size());
+	std::map<std::string, uint>::const_iterator it;
+	for(it = seqIds.begin(); it != seqIds.end(); ++it)
+	{
+		seqOrder[it->second] = m_seqs.size();
+		m_seqs.push_back(it->first);
+	}
+
+	for(uint i = 0; i < entrySeqs.size(); ++i)
+		entrySeqs[i] = seqOrder[entrySeqs[i]];
+
+	m_format = SPARSE_TRIPLET_FORMAT;
+	BuildSampleIndex(entrySamples, entrySeqs, entryCounts);
+
+	return true;
+}
+
+bool SeqCountIO::ReadBiom(const std::string& filename)
+{
+	BiomIO biomIO;
+	if(!biomIO.Read(filename))
+		return false;
+
+	m_seqs = biomIO.GetObservations();
+	m_sampleNames = biomIO.GetSamples();
+
+	m_format = BIOM_FORMAT;
+	BuildSampleIndex(biomIO.GetEntrySamples(), biomIO.GetEntryObservations(), biomIO.GetEntryValues());
+
+	return true;
+}
+
+void SeqCountIO::BuildSampleIndex(const std::vector<uint>& entrySamples, const std::vector<uint>& entrySeqs, const std::vector<double>& entryCounts)
+{
+	// bucket entries by sample
+	std::vector<uint64> start(m_sampleNames.size()+1, 0);
+	for(uint64 i = 0; i < entrySamples.size(); ++i)
+		++start[entrySamples[i]+1];
+
+	for(uint i = 0; i < m_sampleNames.size(); ++i)
+		start[i+1] += start[i];
+
+	std::vector< std::pair<uint, double> > entries(entrySamples.size());
+	std::vector<uint64> next(start.begin(), start.end()-1);
+	for(uint64 i = 0; i < entrySamples.size(); ++i)
+		entries[next[entrySamples[i]]++] = std::make_pair(entrySeqs[i], entryCounts[i]);
+
+	// order entries of each sample by sequence and sum duplicate entries
+	m_sampleOffsets.clear();
+	m_sampleOffsets.reserve(m_sampleNames.size()+1);
+	m_sampleOffsets.push_back(0);
+	m_memSeqIndices.clear();
+	m_memSeqIndices.reserve(entries.size());
+	m_memCounts.clear();
+	m_memCounts.reserve(entries.size());
+	for(uint i = 0; i < m_sampleNames.size(); ++i)
+	{
+		std::sort(entries.begin() + start[i], entries.begin() + start[i+1]);
+
+		for(uint64 j = start[i]; j < start[i+1]; ++j)
+		{
+			if(m_memSeqIndices.size() > m_sampleOffsets.back() && m_memSeqIndices.back() == entries[j].first)
+				m_memCounts.back() += entries[j].second;
+			else
+			{
+				m_memSeqIndices.push_back(entries[j].first);
+				m_memCounts.push_back(entries[j].second);
+			}
+		}
+
+		// remove any sequences whose counts sum to zero
+		uint64 numNonZero = m_sampleOffsets.back();
+		for(uint64 j = m_sampleOffsets.back(); j < m_memCounts.size(); ++j)
+		{
+			if(m_memCounts[j] != 0)
+			{
+				m_memSeqIndices[numNonZero] = m_memSeqIndices[j];
+				m_memCounts[numNonZero] = m_memCounts[j];
+				++numNonZero;
+			}
+		}
+		m_memSeqIndices.resize(numNonZero);
+		m_memCounts.resize(numNonZero);
+
+		m_sampleOffsets.push_back(numNonZero);
+	}
+}
+
+void SeqCountIO::GetMemoryData(uint index, std::vector<uint>& seqIndices, std::vector<double>& count, double& totalNumSeq) const
+{
+	seqIndices.assign(m_memSeqIndices.begin() + m_sampleOffsets[index], m_memSeqIndices.begin() + m_sampleOffsets[index+1]);
+	count.assign(m_memCounts.begin() + m_sampleOffsets[index], m_memCounts.begin() + m_sampleOffsets[index+1]);
+
+	totalNumSeq = 0;
+	for(uint i = 0; i < count.size(); ++i)
+		totalNumSeq += count[i];
+}
+
+bool SeqCountIO::IsBinaryFile(const std::string& filename)
+{
+	std::ifstream fin(filename.c_str(), std::ios::in | std::ios::binary);
+	if(!fin.is_open())
+		return false;
+
+	char magic[sizeof(BINARY_MAGIC)];
+	fin.read(magic, sizeof(magic));
+
+	return fin.gcount() == sizeof(magic) && memcmp(magic, BINARY_MAGIC, sizeof(magic)) == 0;
+}
+
+bool SeqCountIO::ReadBinary(const std::string& filename, bool bMemoryMap)
+{
+	m_file.open(filename.c_str(), std::ios::in | std::ios::binary);
+	if(!m_file.is_open())
+	{
+		std::cerr << "Unable to open sequence file: " << filename << std::endl;
+		return false;
+	}
+
+	uint64 fileSize = GetStreamSize(m_file);
+
+	// read header
+	char magic[sizeof(BINARY_MAGIC)];
+	m_file.read(magic, sizeof(magic));
+
+	uint version, numSeqs, numSamples, countType, flags;
+	ReadValue(m_file, version);
+	ReadValue(m_file, numSeqs);
+	ReadValue(m_file, numSamples);
+	ReadValue(m_file, countType);
+	ReadValue(m_file, flags);
+
+	if(!m_file.good() || memcmp(magic, BINARY_MAGIC, sizeof(magic)) != 0 || version != BINARY_VERSION 
+				|| (countType != BINARY_UINT32 && countType != BINARY_DOUBLE))
+	{
+		std::cerr << "Unsupported binary sequence file: " << filename << std::endl;
+		return false;
+	}
+
+	// names and positions must fit in the file before any space is allocated for them
+	if(!CheckHeaderSize(m_file, fileSize, numSeqs, numSamples))
+	{
+		std::cerr << "Binary sequence file is truncated or corrupt: " << filename << std::endl;
+		return false;
+	}
+
+	m_format = BINARY_FORMAT;
+	m_binaryCountType = (BINARY_COUNT_TYPE)countType;
+	m_binaryFlags = flags;
+
+	// read sequence and sample names
+	m_seqs.resize(numSeqs);
+	for(uint i = 0; i < numSeqs && m_file.good(); ++i)
+		ReadString(m_file, m_seqs[i], fileSize);
+
+	m_sampleNames.resize(numSamples);
+	for(uint i = 0; i < numSamples && m_file.good(); ++i)
+		ReadString(m_file, m_sampleNames[i], fileSize);
+
+	// read starting position of each sample
+	std::streamsize longestRow = 0;
+	bool bOrdered = true;
+	m_sampleStreamPos.reserve((uint64)numSamples+1);
+	for(uint64 i = 0; i < (uint64)numSamples+1 && m_file.good(); ++i)
+	{
+		uint64 pos;
+		ReadValue(m_file, pos);
+		m_sampleStreamPos.push_back((std::streamoff)pos);
+
+		if(i > 0 && m_sampleStreamPos[i] < m_sampleStreamPos[i-1])
+			bOrdered = false;
+
+		if(i > 0 && m_sampleStreamPos[i] - m_sampleStreamPos[i-1] > longestRow)
+			longestRow = m_sampleStreamPos[i] - m_sampleStreamPos[i-1];
+	}
+
+	if(!m_file.good())
+	{
+		std::cerr << "Binary sequence file is truncated or corrupt: " << filename << std::endl;
+		return false;
+	}
+
+	// count data must follow the row index and end within the file
+	std::streamoff dataStart = (std::streamoff)m_file.tellg();
+	if(!bOrdered || (std::streamoff)m_sampleStreamPos[0] < dataStart || (uint64)(std::streamoff)m_sampleStreamPos[numSamples] > fileSize)
+	{
+		std::cerr << "Binary sequence file is truncated or corrupt: " << filename << std::endl;
+		return false;
+	}
+
+	if(bMemoryMap)
+	{
+		m_file.close();
+		if(!m_mappedFile.Open(filename))
+		{
+			std::cerr << "Unable to memory map sequence file: " << filename << std::endl;
+			return false;
+		}
+	}
+	else
+		m_buffer = new char[(uint)longestRow];
+
+	m_longestRow = longestRow;
+
+	return CheckBinaryRows(filename);
+}
+
+bool SeqCountIO::CheckBinaryRows(const std::string& filename)
+{
+	uint countSize = (m_binaryCountType == BINARY_DOUBLE) ? sizeof(double) : sizeof(uint);
+	for(uint i = 0; i < m_sampleNames.size(); ++i)
+	{
+		uint64 rowBytes = (uint64)(m_sampleStreamPos[i+1] - m_sampleStreamPos[i]);
+
+		bool bValid = true;
+		if(m_binaryFlags & BINARY_SPARSE_ROWS)
+		{
+			// non-zero counts are preceded by their number and sequence indices
+			const char* row = GetBinaryRow(i);
+			uint numNonZero = 0;
+			if(rowBytes >= sizeof(uint))
+				memcpy(&numNonZero, row, sizeof(uint));
+
+			bValid = rowBytes >= sizeof(uint) && rowBytes >= sizeof(uint) + (uint64)numNonZero*(sizeof(uint) + countSize);
+			const char* indices = row + sizeof(uint);
+			for(uint j = 0; j < numNonZero && bValid; ++j)
+			{
+				uint seqIndex;
+				memcpy(&seqIndex, indices + j*sizeof(uint), sizeof(uint));
+				bValid = seqIndex < m_seqs.size();
+			}
+		}
+		else
+			bValid = rowBytes >= (uint64)m_seqs.size()*countSize;
+
+		if(!bValid)
+		{
+			std::cerr << "Invalid data for sample " << m_sampleNames[i] << " in binary sequence file: " << filename << std::endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+const char* SeqCountIO::GetBinaryRow(uint index)
+{
+	if(m_mappedFile.IsOpen())
+		return m_mappedFile.GetData() + (std::streamoff)m_sampleStreamPos[index];
+
+	m_file.seekg(m_sampleStreamPos[index]);
+	m_file.read(m_buffer, m_sampleStreamPos[index+1] - m_sampleStreamPos[index]);
+	return m_buffer;
+}
+
+double SeqCountIO::GetBinaryCount(const char* values, uint pos) const
+{
+	if(m_binaryCountType == BINARY_DOUBLE)
+	{
+		double value;
+		memcpy(&value, values + pos*sizeof(double), sizeof(double));
+		return value;
+	}
+
+	uint value;
+	memcpy(&value, values + pos*sizeof(uint), sizeof(uint));
+	return value;
+}
+
+void SeqCountIO::GetBinaryData(uint index, std::vector<double>& count, double& totalNumSeq)
+{
+	const char* row = GetBinaryRow(index);
+
+	count.clear();
+	count.resize(m_seqs.size(), 0);
+	totalNumSeq = 0;
+
+	if(m_binaryFlags & BINARY_SPARSE_ROWS)
+	{
+		uint numNonZero;
+		memcpy(&numNonZero, row, sizeof(uint));
+		const char* indices = row + sizeof(uint);
+		const char* values = indices + numNonZero*sizeof(uint);
+
+		for(uint i = 0; i < numNonZero; ++i)
+		{
+			uint seqIndex;
+			memcpy(&seqIndex, indices + i*sizeof(uint), sizeof(uint));
+
+			count[seqIndex] = GetBinaryCount(values, i);
+			totalNumSeq += count[seqIndex];
+		}
+	}
+	else
+	{
+		for(uint i = 0; i < count.size(); ++i)
+		{
+			count[i] = GetBinaryCount(row, i);
+			totalNumSeq += count[i];
+		}
+	}
+}
+
+void SeqCountIO::GetSparseBinaryData(uint index, std::vector<uint>& seqIndices, std::vector<double>& count, double& totalNumSeq)
+{
+	const char* row = GetBinaryRow(index);
+
+	seqIndices.clear();
+	count.clear();
+	totalNumSeq = 0;
+
+	if(m_binaryFlags & BINARY_SPARSE_ROWS)
+	{
+		uint numNonZero;
+		memcpy(&numNonZero, row, sizeof(uint));
+		const char* values = row + sizeof(uint) + numNonZero*sizeof(uint);
+
+		seqIndices.resize(numNonZero);
+		count.resize(numNonZero);
+		if(numNonZero > 0)
+			memcpy(&seqIndices[0], row + sizeof(uint), numNonZero*sizeof(uint));
+
+		for(uint i = 0; i < numNonZero; ++i)
+		{
+			count[i] = GetBinaryCount(values, i);
+			totalNumSeq += count[i];
+		}
+	}
+	else
+	{
+		for(uint i = 0; i < m_seqs.size(); ++i)
+		{
+			double numSeq = GetBinaryCount(row, i);
+			if(numSeq != 0)
+			{
+				seqIndices.push_back(i);
+				count.push_back(numSeq);
+				totalNumSeq += numSeq;
+			}
+		}
+	}
+}
+
+bool SeqCountIO::WriteBinary(const std::string& filename)
+{
+	// most sequence count files contain integer counts so use this more compact 
+	// representation unless a count can not be represented as an unsigned integer
+	BINARY_COUNT_TYPE countType = BINARY_UINT32;
+	uint64 numNonZero = 0;
+
+	std::vector<uint> seqIndices;
+	std::vector<double> count;
+	for(uint i = 0; i < m_sampleNames.size(); ++i)
+	{
+		double totalNumSeq;
+		GetSparseData(i, seqIndices, count, totalNumSeq);
+		numNonZero += count.size();
+
+		for(uint j = 0; j < count.size() && countType == BINARY_UINT32; ++j)
+		{
+			if(count[j] < 0 || count[j] > std::numeric_limits<uint>::max() || count[j] != floor(count[j]))
+				countType = BINARY_DOUBLE;
+		}
+	}
+
+	// only write non-zero counts if this results in a smaller file
+	uint64 countSize = (countType == BINARY_UINT32) ? sizeof(uint) : sizeof(double);
+	uint64 denseSize = (uint64)m_sampleNames.size() * m_seqs.size() * countSize;
+	uint64 sparseSize = (uint64)m_sampleNames.size() * sizeof(uint) + numNonZero * (sizeof(uint) + countSize);
+
+	return WriteBinary(filename, countType, sparseSize < denseSize);
+}
+
+bool SeqCountIO::WriteBinary(const std::string& filename, BINARY_COUNT_TYPE countType, bool bSparse)
+{
+	std::ofstream fout(filename.c_str(), std::ios::out | std::ios::binary);
+	if(!fout.is_open())
+	{
+		std::cerr << "Unable to open binary sequence file: " << filename << std::endl;
+		return false;
+	}
+
+	// write header
+	fout.write(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+	WriteValue<uint>(fout, BINARY_VERSION);
+	WriteValue<uint>(fout, m_seqs.size());
+	WriteValue<uint>(fout, m_sampleNames.size());
+	WriteValue<uint>(fout, countType);
+	WriteValue<uint>(fout, bSparse ? BINARY_SPARSE_ROWS : 0);
+
+	// write sequence and sample names
+	for(uint i = 0; i < m_seqs.size(); ++i)
+		WriteString(fout, m_seqs[i]);
+
+	for(uint i = 0; i < m_sampleNames.size(); ++i)
+		WriteString(fout, m_sampleNames[i]);
+
+	// reserve space for starting position of each sample and pad so count data is aligned
+	std::streampos indexPos = fout.tellp();
+	std::vector<uint64> samplePos(m_sampleNames.size()+1, 0);
+	for(uint i = 0; i < samplePos.size(); ++i)
+		WriteValue(fout, samplePos[i]);
+
+	const char padding[8] = { 0 };
+	fout.write(padding, (8 - (std::streamoff)fout.tellp() % 8) % 8);
+
+	// write count data for each sample
+	std::vector<uint> seqIndices;
+	std::vector<double> count;
+	std::vector<double> denseCount;
+	for(uint i = 0; i < m_sampleNames.size(); ++i)
+	{
+		samplePos[i] = (std::streamoff)fout.tellp();
+
+		double totalNumSeq;
+		GetSparseData(i, seqIndices, count, totalNumSeq);
+
+		if(bSparse)
+			WriteSparseRow(fout, seqIndices, count, countType);
+		else
+		{
+			denseCount.assign(m_seqs.size(), 0);
+			for(uint j = 0; j < seqIndices.size(); ++j)
+				denseCount[seqIndices[j]] = count[j];
+
+			std::streamsize rowBytes = WriteCounts(fout, denseCount, countType);
+			fout.write(padding, (8 - rowBytes % 8) % 8);
+		}
+	}
+	samplePos[m_sampleNames.size()] = (std::streamoff)fout.tellp();
+
+	// write starting position of each sample
+	fout.seekp(indexPos);
+	for(uint i = 0; i < samplePos.size(); ++i)
+		WriteValue(fout, samplePos[i]);
+
+	if(!fout.good())
+	{
+		std::cerr << "Failed to write binary sequence file: " << filename << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+std::streamsize SeqCountIO::WriteSparseRow(std::ostream& out, const std::vector<uint>& seqIndices, const std::vector<double>& count, BINARY_COUNT_TYPE countType)
+{
+	WriteValue<uint>(out, seqIndices.size());
+	if(!seqIndices.empty())
+		out.write((const char*)&seqIndices[0], seqIndices.size()*sizeof(uint));
+
+	std::streamsize rowBytes = (seqIndices.size()+1)*sizeof(uint) + WriteCounts(out, count, countType);
+
+	const char padding[8] = { 0 };
+	std::streamsize paddingBytes = (8 - rowBytes % 8) % 8;
+	out.write(padding, paddingBytes);
+
+	return rowBytes + paddingBytes;
+}
+
+std::streamsize SeqCountIO::WriteCounts(std::ostream& out, const std::vector<double>& count, BINARY_COUNT_TYPE countType)
+{
+	if(count.empty())
+		return 0;
+
+	if(countType == BINARY_DOUBLE)
+	{
+		out.write((const char*)&count[0], count.size()*sizeof(double));
+		return count.size()*sizeof(double);
+	}
+
+	std::vector<uint> intCount(count.begin(), count.end());
+	out.write((const char*)&intCount[0], intCount.size()*sizeof(uint));
+	return intCount.size()*sizeof(uint);
+}
+
+bool SeqCountIO::ReadString(std::istream& in, std::string& str, uint64 fileSize)
+{
+	uint len = 0;
+	ReadValue(in, len);
+	if(!in.good() || (uint64)in.tellg() + len > fileSize)
+	{
+		in.setstate(std::ios::failbit);
+		return false;
+	}
+
+	str.resize(len);
+	if(len > 0)
+		in.read(&str[0], len);
+
+	return in.good();
+}
+
+uint64 SeqCountIO::GetStreamSize(std::istream& in)
+{
+	std::streampos pos = in.tellg();
+	in.seekg(0, std::ios::end);
+	uint64 size = (uint64)in.tellg();
+	in.seekg(pos);
+
+	return size;
+}
+
+bool SeqCountIO::CheckHeaderSize(std::istream& in, uint64 fileSize, uint numSeqs, uint numSamples)
+{
+	// each name has a length and there is one more position than samples
+	uint64 minBytes = ((uint64)numSeqs + numSamples)*sizeof(uint) + ((uint64)numSamples + 1)*sizeof(uint64);
+	return in.good() && (uint64)in.tellg() + minBytes <= fileSize;
+}
+
+void SeqCountIO::WriteString(std::ostream& out, const std::string& str)
+{
+	WriteValue<uint>(out, str.size());
+	out.write(str.data(), str.size());
+}
@@ -25,11 +25,25 @@
 
 #include "Precompiled.hpp"
 
+#include "MemoryMappedFile.hpp"
+#include "BgzfFile.hpp"
+#include "BiomIO.hpp"
+
 /**
  * @brief Read individual sample data from a sequence count file.
  */
 class SeqCountIO
 {
+public:
+	/** Supported sequence count file formats. */
+	enum FILE_FORMAT { TAB_DELIMITED_FORMAT, BINARY_FORMAT, SPARSE_TRIPLET_FORMAT, BIOM_FORMAT };
+
+	/** Type of count data stored in a binary sequence count file. */
+	enum BINARY_COUNT_TYPE { BINARY_UINT32 = 0, BINARY_DOUBLE = 1 };
+
+	/** Flags describing the layout of a binary sequence count file. */
+	enum BINARY_FLAGS { BINARY_SPARSE_ROWS = 1 };
+
 public:		
 	/** Constructor. */
 	SeqCountIO();
@@ -40,10 +54,45 @@ public:
 	/**
 	* @brief Open sequence count file.
 	*
+	* Tab-delimited, binary, sparse triplet (sequence, sample, count), and BIOM (JSON) 
+	* files are supported. The format is determined from the contents of the file. Sparse 
+	* triplet and BIOM files are read entirely into memory as the non-zero counts of each sample.
+	* Tab-delimited files may be block compressed (BGZF), in which case they are never memory mapped.
+	* Standard input ("-") and other non-seekable files (e.g., pipes) are read once as a tab-delimited 
+	* file (see ReadStream).
+	*
 	* @param filename Path to sequence count file.
+	* @param bMemoryMap Flag indicating if file should be memory mapped instead of read through a file stream.
+	* @param bIndexFile Flag indicating if the start of each sample in a tab-delimited file should be read from, 
+	*					or written to, an index file next to the sequence count file.
+	* @param streamMemory Memory in MB for holding samples read from a non-seekable file before they are spilled to disk.
 	* @return True if file opened successfully, else false.
 	*/
-	bool Read(const std::string& filename);
+	bool Read(const std::string& filename, bool bMemoryMap = false, bool bIndexFile = false, uint streamMemory = 4096);
+
+	/**
+	* @brief Read tab-delimited sequence count data from a stream in a single pass.
+	*
+	* The non-zero counts of each sample are held in memory until they exceed the specified 
+	* memory limit, after which all samples are spilled to a temporary file in binary format.
+	*
+	* @param in Input stream positioned at the header line.
+	* @param bMemoryMap Flag indicating if samples spilled to disk should be memory mapped.
+	* @param streamMemory Memory in MB for holding samples before they are spilled to disk (0 to always spill).
+	* @return True if stream read successfully, else false.
+	*/
+	bool ReadStream(std::istream& in, bool bMemoryMap = false, uint streamMemory = 4096);
+
+	/**
+	* @brief Write sequence count data in binary format.
+	*
+	* Counts are stored as 32-bit unsigned integers unless a count can not be 
+	* represented in this manner, in which case they are stored as doubles.
+	*
+	* @param filename Path to binary sequence count file.
+	* @return True if file written successfully, else false.
+	*/
+	bool WriteBinary(const std::string& filename);
 
 	/** Get number of samples. */
 	uint GetNumSamples() const { return m_sampleNames.size(); }
@@ -60,13 +109,208 @@ public:
 	/** Get sequences. */
 	const std::vector<std::string>& GetSeqs() const { return m_seqs; }
 
-	/** Get count data for specified sample. */
-	void GetData(uint index, std::vector<double>& count, double& totalNumSeq, uint seqsToDraw = 0);
+	/** 
+	* @brief Get count data for specified sample. 
+	*
+	* Safe to call concurrently from multiple threads when the file is memory mapped.
+	*/
+	void GetData(uint index, std::vector<double>& count, double& totalNumSeq);
+
+	/** 
+	* @brief Get non-zero count data for specified sample. 
+	*
+	* @param index Index of sample.
+	* @param seqIndices Index of each sequence with a non-zero count in increasing order.
+	* @param count Count data for each sequence in seqIndices.
+	* @param totalNumSeq Sum of count data.
+	*/
+	void GetSparseData(uint index, std::vector<uint>& seqIndices, std::vector<double>& count, double& totalNumSeq);
+
+	/** Check if sequence count file is block compressed (BGZF). */
+	bool IsCompressed() const { return m_bgzfFile.IsOpen(); }
+
+	/** Check if sequence count file is memory mapped. */
+	bool IsMemoryMapped() const { return m_mappedFile.IsOpen(); }
+
+	/** Get length of longest sample in bytes (i.e., buffer size required to read any sample). */
+	std::streamsize GetLongestRow() const { return m_longestRow; }
+
+	/** Check if the start of each sample was read from an index file. */
+	bool IsIndexFileUsed() const { return m_bIndexFileUsed; }
+
+	/** Get format of sequence count file. */
+	FILE_FORMAT GetFormat() const { return m_format; }
+
+	/** Check if sequence count file is in binary format. */
+	bool IsBinary() const { return m_format == BINARY_FORMAT; }
+
+	/** Check if sequence count file is in binary format with sparse rows. */
+	bool IsSparseBinary() const { return m_format == BINARY_FORMAT && (m_binaryFlags & BINARY_SPARSE_ROWS); }
+
+	/** Check if count data is held in memory. */
+	bool IsInMemory() const { return !m_sampleOffsets.empty(); }
+
+	/** Check if sequence count data was read from a non-seekable stream. */
+	bool IsStream() const { return m_bStream; }
+
+	/** Check if samples read from a stream were spilled to disk. */
+	bool IsSpilled() const { return !m_spillFile.empty(); }
+
+	/** Check if file is standard input ("-") or can not be seeked (e.g., a pipe). */
+	static bool IsStreamFile(const std::string& filename);
+
+	/** Check if file is a sparse triplet (sequence, sample, count) file. */
+	static bool IsTripletFile(const std::string& filename);
+
+	/** Check if file is a binary sequence count file. */
+	static bool IsBinaryFile(const std::string& filename);
+
+private:
+	/** Read sparse triplet (sequence, sample, count) file into memory. */
+	bool ReadTriplets(const std::string& filename);
+
+	/** Read BIOM (JSON) file into memory. */
+	bool ReadBiom(const std::string& filename);
+
+	/** 
+	* @brief Build index of non-zero counts for each sample held in memory.
+	*
+	* Duplicate entries for a sequence within a sample are summed.
+	*
+	* @param entrySamples Sample index of each entry.
+	* @param entrySeqs Sequence index of each entry.
+	* @param entryCounts Count of each entry.
+	*/
+	void BuildSampleIndex(const std::vector<uint>& entrySamples, const std::vector<uint>& entrySeqs, const std::vector<double>& entryCounts);
+
+	/** Get non-zero count data for specified sample held in memory. */
+	void GetMemoryData(uint index, std::vector<uint>& seqIndices, std::vector<double>& count, double& totalNumSeq) const;
+
+	/** Read header and row index of a binary sequence count file. */
+	bool ReadBinary(const std::string& filename, bool bMemoryMap);
+
+	/** Check that each row of a binary sequence count file lies within the file and only refers to known sequences. */
+	bool CheckBinaryRows(const std::string& filename);
+
+	/** Get start of data for specified sample in a binary sequence count file. */
+	const char* GetBinaryRow(uint index);
+
+	/** Get count at specified position of a row in a binary sequence count file. */
+	double GetBinaryCount(const char* values, uint pos) const;
+
+	/** Get count data for specified sample from a binary sequence count file. */
+	void GetBinaryData(uint index, std::vector<double>& count, double& totalNumSeq);
+
+	/** Get non-zero count data for specified sample from a binary sequence count file. */
+	void GetSparseBinaryData(uint index, std::vector<uint>& seqIndices, std::vector<double>& count, double& totalNumSeq);
+
+	/** 
+	* @brief Write sequence count data in binary format with the specified type of count data.
+	*
+	* @param filename Path to binary sequence count file.
+	* @param countType Type of count data to write.
+	* @param bSparse Flag indicating if only non-zero counts should be written for each sample.
+	* @return True if file written successfully, else false.
+	*/
+	bool WriteBinary(const std::string& filename, BINARY_COUNT_TYPE countType, bool bSparse);
+
+	/** Write non-zero counts of a sample as a padded sparse row of a binary sequence count file and return number of bytes written. */
+	static std::streamsize WriteSparseRow(std::ostream& out, const std::vector<uint>& seqIndices, const std::vector<double>& count, BINARY_COUNT_TYPE countType);
+
+	/** Spill samples held in memory to a temporary file. */
+	bool SpillToDisk(std::ofstream& spill);
+
+	/** Create a uniquely named temporary file. */
+	static bool CreateTempFile(std::string& filename);
+
+	/** Write count data with the specified type and return number of bytes written. */
+	static std::streamsize WriteCounts(std::ostream& out, const std::vector<double>& count, BINARY_COUNT_TYPE countType);
+
+	/** Read value from binary file. */
+	template<class T> static void ReadValue(std::istream& in, T& value) { in.read((char*)&value, sizeof(T)); }
+
+	/** Write value to binary file. */
+	template<class T> static void WriteValue(std::ostream& out, const T& value) { out.write((const char*)&value, sizeof(T)); }
+
+	/** Read length prefixed string from binary file. Fails if the string would extend past the end of the file. */
+	static bool ReadString(std::istream& in, std::string& str, uint64 fileSize);
+
+	/** Get size of binary file, leaving the read position unchanged. */
+	static uint64 GetStreamSize(std::istream& in);
+
+	/** Determine if the names and positions of a header could fit in the remainder of a binary file. */
+	static bool CheckHeaderSize(std::istream& in, uint64 fileSize, uint numSeqs, uint numSamples);
+
+	/** Write length prefixed string to binary file. */
+	static void WriteString(std::ostream& out, const std::string& str);
+
+	/** Determine start of each sample by reading through the file stream. */
+	void IndexStream();
+
+	/** Determine start of each sample by decompressing blocks of a block compressed file. */
+	bool IndexBgzf();
+
+	/** Get size and modification time of a file. */
+	static bool GetFileFingerprint(const std::string& filename, uint64& fileSize, uint64& modTime);
+
+	/** Read sequences, sample names, and start of each sample from index file if it matches the sequence count file. */
+	bool ReadIndexFile(const std::string& filename);
+
+	/** Write sequences, sample names, and start of each sample to index file. */
+	bool WriteIndexFile(const std::string& filename) const;
+
+	/** 
+	* @brief Determine sequences, sample names, and start of each sample from a block of a tab-delimited sequence count file.
+	*
+	* The block is scanned using multiple threads. Blocks must be given in order and end on a line boundary.
+	*
+	* @param block Start of block.
+	* @param size Size of block in bytes.
+	* @param blockOffset Offset of block from the start of the file.
+	* @param bEndOfFile Flag indicating if this is the last block in the file.
+	*/
+	void IndexTextBlock(const char* block, size_t size, uint64 blockOffset, bool bEndOfFile);
+
+	/** Find position of every occurrence of a character using multiple threads. */
+	static void FindAll(const char* data, size_t size, char c, std::vector<size_t>& positions);
+
+	/** Get start and end of count data for specified sample in a tab-delimited sequence count file. */
+	void GetTextRow(uint index, const char*& curPos, const char*& endPos);
+
+	/** 
+	* @brief Parse count data for a sample.
+	*
+	* @param curPos Start of count data (i.e., first character after the sample name).
+	* @param endPos End of count data (exclusive).
+	* @param count Count data for each sequence.
+	* @param totalNumSeq Sum of count data.
+	*/
+	void ParseCounts(const char* curPos, const char* endPos, std::vector<double>& count, double& totalNumSeq) const;
+
+	/** 
+	* @brief Parse non-zero count data for a sample.
+	*
+	* @param curPos Start of count data (i.e., first character after the sample name).
+	* @param endPos End of count data (exclusive).
+	* @param seqIndices Index of each sequence with a non-zero count.
+	* @param count Count data for each sequence in seqIndices.
+	* @param totalNumSeq Sum of count data.
+	*/
+	void ParseSparseCounts(const char* curPos, const char* endPos, std::vector<uint>& seqIndices, std::vector<double>& count, double& totalNumSeq) const;
+
+	/** Parse a single count, taking a fast path for non-negative integers. */
+	static double ParseCount(const char* curPos, const char* tabPos);
 
 private:
 	/** File stream. */
 	std::ifstream m_file;
 
+	/** Memory mapped sequence count file. */
+	MemoryMappedFile m_mappedFile;
+
+	/** Block compressed sequence count file. */
+	BgzfFile m_bgzfFile;
+
 	/** Start of each sample in sample count file. */
 	std::vector<std::streampos> m_sampleStreamPos;
 
@@ -78,6 +322,66 @@ private:
 
 	/** Temporary buffer for reading sample data. */
 	char* m_buffer;
+
+	/** Length of longest sample in bytes. */
+	std::streamsize m_longestRow;
+
+	/** Format of sequence count file. */
+	FILE_FORMAT m_format;
+
+	/** Type of count data in binary sequence count file. */
+	BINARY_COUNT_TYPE m_binaryCountType;
+
+	/** Layout flags of binary sequence count file. */
+	uint m_binaryFlags;
+
+	/** Flag indicating if the start of each sample was read from an index file. */
+	bool m_bIndexFileUsed;
+
+	/** Start of the non-zero counts of each sample held in memory. */
+	std::vector<uint64> m_sampleOffsets;
+
+	/** Sequence index of the non-zero counts of all samples held in memory. */
+	std::vector<uint> m_memSeqIndices;
+
+	/** Non-zero counts of all samples held in memory. */
+	std::vector<double> m_memCounts;
+
+	/** Flag indicating if sequence count data was read from a non-seekable stream. */
+	bool m_bStream;
+
+	/** Temporary file holding samples spilled to disk. */
+	std::string m_spillFile;
+
+	/** Identifies binary sequence count files. */
+	static const char BINARY_MAGIC[4];
+
+	/** Version of binary sequence count file format. */
+	static const uint BINARY_VERSION;
+
+	/** Identifies index files. */
+	static const char INDEX_MAGIC[4];
+
+	/** Version of index file format. */
+	static const uint INDEX_VERSION;
+
+	/** Filename indicating sequence count data should be read from standard input. */
+	static const std::string STDIN_FILENAME;
+
+	/** Extension appended to sequence count file to give name of index file. */
+	static const std::string INDEX_EXTENSION;
+
+	/** Size of blocks read when determining the start of each sample. */
+	static const size_t READ_BLOCK_SIZE;
+
+	/** Minimum number of bytes before scanning is split across multiple threads. */
+	static const size_t PARALLEL_SCAN_SIZE;
+
+	/** Minimum number of lines or tokens before processing is split across multiple threads. */
+	static const uint PARALLEL_LINES;
+
+	/** Maximum number of digits in an integer count that is guaranteed to be exactly representable as a double. */
+	static const int MAX_INTEGER_DIGITS;
 };
 
 #endif
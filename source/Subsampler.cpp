@@ -0,0 +1,175 @@
+//=======================================================================
+// Author: Donovan Parks
+//
+// Copyright 2011 Donovan Parks
+//
+// This file is part of ExpressBetaDiversity.
+//
+// ExpressBetaDiversity is free software: you can redistribute it 
+// and/or modify it under the terms of the GNU General Public License 
+// as published by the Free Software Foundation, either version 3 of 
+// the License, or (at your option) any later version.
+//
+// ExpressBetaDiversity is distributed in the hope that it will be 
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ExpressBetaDiversity. If not, see 
+// <http://www.gnu.org/licenses/>.
+//=======================================================================
+
+#include "Precompiled.hpp"
+
+#include "Subsampler.hpp"
+
+RandomStream::RandomStream(uint64 seed, uint64 stream)
+{
+	// hash seed and stream together so neighbouring streams start far apart
+	uint64 state = SplitMix(seed) ^ stream;
+	SplitMix(state);
+	for(uint i = 0; i < 4; ++i)
+		m_state[i] = SplitMix(state);
+}
+
+uint64 RandomStream::SplitMix(uint64& state)
+{
+	state += 0x9E3779B97F4A7C15ULL;
+	uint64 z = state;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+uint64 RandomStream::Next()
+{
+	uint64 x = m_state[1] * 5;
+	uint64 result = ((x << 7) | (x >> 57)) * 9;
+
+	uint64 t = m_state[1] << 17;
+	m_state[2] ^= m_state[0];
+	m_state[3] ^= m_state[1];
+	m_state[1] ^= m_state[2];
+	m_state[0] ^= m_state[3];
+	m_state[2] ^= t;
+	m_state[3] = (m_state[3] << 45) | (m_state[3] >> 19);
+
+	return result;
+}
+
+Subsampler::Subsampler(uint seed, bool bReplacement)
+	: m_seed(seed), m_bReplacement(bReplacement)
+{
+
+}
+
+void Subsampler::BuildTree(const std::vector<double>& count, std::vector<double>& tree)
+{
+	uint n = count.size();
+	tree.assign(n+1, 0);
+	for(uint i = 1; i <= n; ++i)
+	{
+		tree[i] += count[i-1];
+
+		uint parent = i + (i & (~i + 1));
+		if(parent <= n)
+			tree[parent] += tree[i];
+	}
+}
+
+uint Subsampler::FindCount(const std::vector<double>& tree, double value)
+{
+	uint n = tree.size() - 1;
+	uint step = 1;
+	while(2*step <= n)
+		step *= 2;
+
+	// descend tree, skipping over counts whose cumulative sum does not exceed the value
+	uint pos = 0;
+	for(; step > 0; step >>= 1)
+	{
+		if(pos + step <= n && tree[pos + step] <= value)
+		{
+			pos += step;
+			value -= tree[pos];
+		}
+	}
+
+	return std::min(pos, n-1);	// guard against rounding error with non-integer counts
+}
+
+void Subsampler::UpdateTree(std::vector<double>& tree, uint index, double value)
+{
+	for(uint i = index+1; i < tree.size(); i += (i & (~i + 1)))
+		tree[i] += value;
+}
+
+void Subsampler::Draw(uint replicate, uint sample, std::vector<uint>& seqIndices, std::vector<double>& count, double& totalNumSeq, uint seqsToDraw) const
+{
+	// each sample of each replicate has its own stream so draws are reproducible
+	RandomStream random(m_seed, ((uint64)replicate << 32) | sample);
+
+	std::vector<double> drawn(count.size(), 0);
+	std::vector<double> tree;
+	if(m_bReplacement)
+	{
+		double total = std::accumulate(count.begin(), count.end(), 0.0);
+		if(total > 0)
+		{
+			BuildTree(count, tree);
+			for(uint i = 0; i < seqsToDraw; ++i)
+				drawn[FindCount(tree, random.NextDouble()*total)] += 1;
+		}
+	}
+	else
+	{
+		std::vector<double> available(count.size());
+		uint64 total = 0;
+		for(uint i = 0; i < count.size(); ++i)
+		{
+			available[i] = floor(std::max(count[i], 0.0));
+			total += (uint64)available[i];
+		}
+
+		if(total <= seqsToDraw)
+			drawn = available;
+		else
+		{
+			// draw whichever of the retained or discarded sequences is smaller
+			bool bComplement = (seqsToDraw > total/2);
+			uint64 numDraws = bComplement ? total - seqsToDraw : seqsToDraw;
+
+			BuildTree(available, tree);
+			for(uint64 i = 0; i < numDraws; ++i)
+			{
+				uint index = FindCount(tree, floor(random.NextDouble()*(total - i)));
+				UpdateTree(tree, index, -1);
+				drawn[index] += 1;
+			}
+
+			if(bComplement)
+			{
+				for(uint i = 0; i < drawn.size(); ++i)
+					drawn[i] = available[i] - drawn[i];
+			}
+		}
+	}
+
+	// remove sequences which were not drawn
+	uint numNonZero = 0;
+	totalNumSeq = 0;
+	for(uint i = 0; i < drawn.size(); ++i)
+	{
+		if(drawn[i] != 0)
+		{
+			seqIndices[numNonZero] = seqIndices[i];
+			count[numNonZero] = drawn[i];
+			totalNumSeq += drawn[i];
+			++numNonZero;
+		}
+	}
+
+	seqIndices.resize(numNonZero);
+	count.resize(numNonZero);
+}
@@ -0,0 +1,113 @@
+//=======================================================================
+// Author: Donovan Parks
+//
+// Copyright 2011 Donovan Parks
+//
+// This file is part of ExpressBetaDiversity.
+//
+// ExpressBetaDiversity is free software: you can redistribute it 
+// and/or modify it under the terms of the GNU General Public License 
+// as published by the Free Software Foundation, either version 3 of 
+// the License, or (at your option) any later version.
+//
+// ExpressBetaDiversity is distributed in the hope that it will be 
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ExpressBetaDiversity. If not, see 
+// <http://www.gnu.org/licenses/>.
+//=======================================================================
+
+#ifndef _SUBSAMPLER_
+#define _SUBSAMPLER_
+
+#include "Precompiled.hpp"
+
+/**
+ * @brief Stream of pseudo-random numbers (xoshiro256**) identified by a seed and a stream number.
+ *
+ * Streams with the same seed but different stream numbers are independent, so each 
+ * sample can be given its own stream and draws do not depend on the order samples are read.
+ */
+class RandomStream
+{
+public:
+	/** Constructor. */
+	RandomStream(uint64 seed, uint64 stream);
+
+	/** Get next 64-bit pseudo-random number. */
+	uint64 Next();
+
+	/** Get pseudo-random number uniformly distributed over [0, 1). */
+	double NextDouble() { return (Next() >> 11) * (1.0 / 9007199254740992.0); }
+
+private:
+	/** Generate well mixed values for initializing the state from a seed (SplitMix64). */
+	static uint64 SplitMix(uint64& state);
+
+private:
+	/** State of generator. */
+	uint64 m_state[4];
+};
+
+/**
+ * @brief Draw random subsets of the sequences in a sample for jackknife replicates.
+ *
+ * Sequences are drawn using a Fenwick tree over the counts of a sample so each draw
+ * takes O(log n) time for a sample with n sequences having a non-zero count. Draws can be 
+ * made with replacement (multinomial) or without replacement (multivariate hypergeometric).
+ */
+class Subsampler
+{
+public:
+	/** Constructor. */
+	Subsampler(uint seed = 0, bool bReplacement = true);
+
+	/** Set seed used to identify random number streams. */
+	void SetSeed(uint seed) { m_seed = seed; }
+
+	/** Get seed used to identify random number streams. */
+	uint GetSeed() const { return m_seed; }
+
+	/** Set flag indicating if sequences are drawn with replacement. */
+	void SetReplacement(bool bReplacement) { m_bReplacement = bReplacement; }
+
+	/** Check if sequences are drawn with replacement. */
+	bool IsReplacement() const { return m_bReplacement; }
+
+	/**
+	* @brief Draw sequences from a sample.
+	*
+	* Without replacement, counts are truncated to integers and all sequences are retained 
+	* if the sample contains no more than seqsToDraw sequences.
+	*
+	* @param replicate Index of replicate.
+	* @param sample Index of sample.
+	* @param seqIndices Index of each sequence with a non-zero count. Set to the sequences drawn.
+	* @param count Count data for each sequence in seqIndices. Set to the number of times each sequence was drawn.
+	* @param totalNumSeq Sum of count data. Set to the number of sequences drawn.
+	* @param seqsToDraw Number of sequences to draw.
+	*/
+	void Draw(uint replicate, uint sample, std::vector<uint>& seqIndices, std::vector<double>& count, double& totalNumSeq, uint seqsToDraw) const;
+
+private:
+	/** Build Fenwick tree (1-based) over counts in linear time. */
+	static void BuildTree(const std::vector<double>& count, std::vector<double>& tree);
+
+	/** Find index of the first count whose cumulative sum exceeds the specified value. */
+	static uint FindCount(const std::vector<double>& tree, double value);
+
+	/** Add value to the specified count in a Fenwick tree. */
+	static void UpdateTree(std::vector<double>& tree, uint index, double value);
+
+private:
+	/** Seed used to identify random number streams. */
+	uint m_seed;
+
+	/** Flag indicating if sequences are drawn with replacement. */
+	bool m_bReplacement;
+};
+
+#endif
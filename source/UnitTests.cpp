@@ -25,6 +25,7 @@
 #include "UnitTests.hpp"
 
 #include "DiversityCalculator.hpp"
+#include "StringTools.hpp"
 
 bool UnitTests::Execute()
 {
@@ -64,6 +65,60 @@ bool UnitTests::Execute()
 		return false;
 	}
 
+	if(!SeqCountFileFormats())
+	{
+		std::cout << "Sequence count file formats test failed." << std::endl;
+		return false;
+	}
+
+	if(!DataVectorCaching())
+	{
+		std::cout << "Data vector caching test failed." << std::endl;
+		return false;
+	}
+
+	if(!Subsampling())
+	{
+		std::cout << "Subsampling test failed." << std::endl;
+		return false;
+	}
+
+	if(!SparseDataVectors())
+	{
+		std::cout << "Sparse data vectors test failed." << std::endl;
+		return false;
+	}
+
+	if(!SinglePrecision())
+	{
+		std::cout << "Single precision test failed." << std::endl;
+		return false;
+	}
+
+	if(!BitDataVectors())
+	{
+		std::cout << "Presence/absence data vectors test failed." << std::endl;
+		return false;
+	}
+
+	if(!LeafDistances())
+	{
+		std::cout << "Leaf distances test failed." << std::endl;
+		return false;
+	}
+
+	if(!VectorInstructions())
+	{
+		std::cout << "Vector instructions test failed." << std::endl;
+		return false;
+	}
+
+	if(!ParallelComparison())
+	{
+		std::cout << "Parallel comparison test failed." << std::endl;
+		return false;
+	}
+
 	return true;
 }
 
@@ -727,4 +782,1016 @@ bool UnitTests::SharedSeqs()
 		return false;
 
 	return true;
-}
\ No newline at end of file
+}
+bool UnitTests::CompareSeqCountIO(SeqCountIO& expected, SeqCountIO& actual)
+{
+	if(expected.GetNumSamples() != actual.GetNumSamples() || expected.GetSeqs() != actual.GetSeqs())
+		return false;
+
+	for(uint i = 0; i < expected.GetNumSamples(); ++i)
+	{
+		if(expected.GetSampleName(i) != actual.GetSampleName(i))
+			return false;
+
+		std::vector<double> expectedCount, actualCount;
+		double expectedTotal, actualTotal;
+		expected.GetData(i, expectedCount, expectedTotal);
+		actual.GetData(i, actualCount, actualTotal);
+		if(expectedCount != actualCount || !Compare(actualTotal, expectedTotal))
+			return false;
+
+		// non-zero count data must agree with the full count data
+		std::vector<uint> seqIndices;
+		std::vector<double> sparseCount;
+		double sparseTotal;
+		actual.GetSparseData(i, seqIndices, sparseCount, sparseTotal);
+		if(seqIndices.size() != sparseCount.size() || !Compare(sparseTotal, expectedTotal))
+			return false;
+
+		std::vector<double> denseCount(expectedCount.size(), 0);
+		for(uint j = 0; j < seqIndices.size(); ++j)
+		{
+			if(seqIndices[j] >= denseCount.size() || sparseCount[j] == 0 || (j > 0 && seqIndices[j] <= seqIndices[j-1]))
+				return false;
+
+			denseCount[seqIndices[j]] = sparseCount[j];
+		}
+
+		if(denseCount != expectedCount)
+			return false;
+	}
+
+	return true;
+}
+
+bool UnitTests::DataVectorCaching()
+{
+	// lowest priority (frequency * cost / size) data vector is evicted once the budget is exceeded
+	std::vector<double> dataVec(16, 1.0);
+
+	DataVectorCache cache;
+	cache.SetBudget(3*(dataVec.size()*sizeof(double) + 64));
+	cache.Insert(0, dataVec, 1.0);
+	cache.Insert(1, dataVec, 3.0);
+	cache.Insert(2, dataVec, 2.0);
+	cache.Insert(3, dataVec, 1.5);
+	if(cache.Get(3) == NULL || cache.Get(0) != NULL || cache.Get(1) == NULL || cache.Get(2) == NULL)
+		return false;
+
+	// data vectors are cached in the representation they are inserted with and sized by that representation
+	SparseDataVector sparseDataVec;
+	sparseDataVec.index.push_back(3);
+	sparseDataVec.value.push_back(1.0);
+	uint64 denseSize = cache.GetSize();
+	cache.Insert(1, sparseDataVec, 3.0);
+	if(cache.Get(1) != NULL || cache.GetSparse(1) == NULL || cache.GetSparse(1)->index != sparseDataVec.index || cache.GetSize() >= denseSize)
+		return false;
+
+	// dissimilarity calculated over many blocks with and without cached data vectors
+	std::vector< std::vector<double> > expectedMatrix;
+	DiversityCalculator singleBlock("../unit-tests/DataMatrixMothur.env", "", "Bray-Curtis", 1000, true, false, false, false, false);
+	singleBlock.Dissimilarity("../unit-tests/temp", "UPGMA");
+	ReadDissMatrix("../unit-tests/temp.diss", expectedMatrix);
+
+	uint cacheSizes[] = { 0, 1, 1024 };
+	for(uint i = 0; i < sizeof(cacheSizes)/sizeof(cacheSizes[0]); ++i)
+	{
+		DiversityCalculator blocks("../unit-tests/DataMatrixMothur.env", "", "Bray-Curtis", 4, true, false, false, false, false, false, false, cacheSizes[i]);
+		blocks.Dissimilarity("../unit-tests/temp", "UPGMA");
+
+		std::vector< std::vector<double> > dissMatrix;
+		ReadDissMatrix("../unit-tests/temp.diss", dissMatrix);
+		if(dissMatrix != expectedMatrix)
+			return false;
+	}
+
+	return true;
+}
+
+bool UnitTests::SeqCountFileFormats()
+{
+	const char* seqCountFiles[] = { "../unit-tests/SimpleDataMatrix.env", "../unit-tests/SimpleTree.env", "../unit-tests/DataMatrixMothur.env", 
+																	"../unit-tests/Multifurcating.env", "../unit-tests/SharedSeqs.env" };
+
+	for(uint i = 0; i < sizeof(seqCountFiles)/sizeof(seqCountFiles[0]); ++i)
+	{
+		SeqCountIO streamIO;
+		if(!streamIO.Read(seqCountFiles[i]))
+			return false;
+
+		// memory mapped file
+		SeqCountIO mappedIO;
+		if(!mappedIO.Read(seqCountFiles[i], true))
+			return false;
+
+		if(!CompareSeqCountIO(streamIO, mappedIO))
+			return false;
+
+		// single pass through a non-seekable stream with samples held in memory, or spilled to disk and memory mapped
+		for(uint j = 0; j < 2; ++j)
+		{
+			bool bSpill = (j == 1);
+			std::ifstream pipeIn(seqCountFiles[i], std::ios::in | std::ios::binary);
+
+			SeqCountIO pipedIO;
+			if(!pipedIO.ReadStream(pipeIn, bSpill, bSpill ? 0 : 4096) || !pipedIO.IsStream() || pipedIO.IsSpilled() != bSpill)
+				return false;
+
+			if(!CompareSeqCountIO(streamIO, pipedIO))
+				return false;
+		}
+
+		// binary file read through a file stream and memory mapped
+		std::string binaryFile = "../unit-tests/temp.bin";
+		if(!streamIO.WriteBinary(binaryFile))
+			return false;
+
+		SeqCountIO binaryIO;
+		if(!binaryIO.Read(binaryFile) || !binaryIO.IsBinary())
+			return false;
+
+		SeqCountIO mappedBinaryIO;
+		if(!mappedBinaryIO.Read(binaryFile, true) || !mappedBinaryIO.IsBinary())
+			return false;
+
+		bool bIdentical = CompareSeqCountIO(streamIO, binaryIO) && CompareSeqCountIO(streamIO, mappedBinaryIO);
+
+		remove(binaryFile.c_str());
+
+		if(!bIdentical)
+			return false;
+	}
+
+	// binary file with only non-zero counts written for each sample
+	std::string sparseFile = "../unit-tests/temp.env";
+	std::ofstream sparseOut(sparseFile.c_str());
+	for(uint j = 0; j < 50; ++j)
+		sparseOut << '\t' << "seq" << j;
+	sparseOut << std::endl;
+
+	for(uint i = 0; i < 4; ++i)
+	{
+		sparseOut << "sample" << i;
+		for(uint j = 0; j < 50; ++j)
+			sparseOut << '\t' << ((j % 17 == i) ? i*j + 1 : 0);
+		sparseOut << std::endl;
+	}
+	sparseOut.close();
+
+	SeqCountIO sparseIO;
+	if(!sparseIO.Read(sparseFile))
+		return false;
+
+	std::string binaryFile = "../unit-tests/temp.bin";
+	if(!sparseIO.WriteBinary(binaryFile))
+		return false;
+
+	SeqCountIO binaryIO;
+	bool bIdentical = binaryIO.Read(binaryFile) && binaryIO.IsSparseBinary() && CompareSeqCountIO(sparseIO, binaryIO);
+
+	// binary files with an out of range sequence index, a truncated row, or counts or name lengths 
+	// that do not fit in the file are rejected
+	std::ifstream binaryIn(binaryFile.c_str(), std::ios::in | std::ios::binary);
+	std::string binaryData((std::istreambuf_iterator<char>(binaryIn)), std::istreambuf_iterator<char>());
+	binaryIn.close();
+
+	uint indices[3] = { 3, 20, 37 };	// sequence indices of sample3
+	std::string indexBytes((const char*)indices, sizeof(indices));
+	std::string::size_type indexPos = binaryData.find(indexBytes);
+	bIdentical = bIdentical && indexPos != std::string::npos;
+
+	uint numSeqsPos = 2*sizeof(uint);
+	uint numSamplesPos = 3*sizeof(uint);
+	uint firstNamePos = 6*sizeof(uint);
+	for(uint i = 0; i < 5 && bIdentical; ++i)
+	{
+		std::string corruptData = binaryData;
+		if(i == 0)
+		{
+			uint invalidIndex = 50;
+			corruptData.replace(indexPos + 2*sizeof(uint), sizeof(uint), (const char*)&invalidIndex, sizeof(uint));
+		}
+		else if(i == 1)
+			corruptData.resize(corruptData.size() - sizeof(uint));
+		else
+		{
+			uint pos[3] = { numSeqsPos, numSamplesPos, firstNamePos };
+			uint value[3] = { 0x0fffffff, std::numeric_limits<uint>::max(), std::numeric_limits<uint>::max() - 1 };
+			corruptData.replace(pos[i-2], sizeof(uint), (const char*)&value[i-2], sizeof(uint));
+		}
+
+		std::ofstream corruptOut(binaryFile.c_str(), std::ios::out | std::ios::binary);
+		corruptOut.write(corruptData.data(), corruptData.size());
+		corruptOut.close();
+
+		SeqCountIO corruptIO;
+		SeqCountIO mappedCorruptIO;
+		bIdentical = !corruptIO.Read(binaryFile) && !mappedCorruptIO.Read(binaryFile, true);
+	}
+
+	remove(binaryFile.c_str());
+	remove(sparseFile.c_str());
+
+	if(!bIdentical)
+		return false;
+
+	// sparse triplet and BIOM files
+	const char* tableFiles[] = { "../unit-tests/SharedSeqs.env", "../unit-tests/SharedSeqs.env", "../unit-tests/SimpleDataMatrix.env" };
+	const char* otherFiles[] = { "../unit-tests/SharedSeqs.sparse", "../unit-tests/SharedSeqs.biom", "../unit-tests/SimpleDataMatrix.biom" };
+	SeqCountIO::FILE_FORMAT otherFormats[] = { SeqCountIO::SPARSE_TRIPLET_FORMAT, SeqCountIO::BIOM_FORMAT, SeqCountIO::BIOM_FORMAT };
+
+	for(uint i = 0; i < sizeof(tableFiles)/sizeof(tableFiles[0]); ++i)
+	{
+		SeqCountIO tableIO;
+		if(!tableIO.Read(tableFiles[i]))
+			return false;
+
+		SeqCountIO otherIO;
+		if(!otherIO.Read(otherFiles[i]) || otherIO.GetFormat() != otherFormats[i])
+			return false;
+
+		if(!CompareSeqCountIO(tableIO, otherIO))
+			return false;
+	}
+
+	// index file is written on first read, used on subsequent reads, and ignored once the file changes
+	std::string indexedFile = "../unit-tests/temp.env";
+	std::string indexFile = indexedFile + ".ebdidx";
+	for(uint i = 0; i < 2; ++i)
+	{
+		std::ofstream indexedOut(indexedFile.c_str());
+		indexedOut << "\tA\tB\tC" << std::endl;
+		for(uint j = 0; j < 3 + i; ++j)
+			indexedOut << "sample" << j << '\t' << j << '\t' << i << '\t' << 2 << std::endl;
+		indexedOut.close();
+
+		SeqCountIO streamIO;
+		if(!streamIO.Read(indexedFile) || streamIO.IsIndexFileUsed())
+			return false;
+
+		SeqCountIO firstIO;
+		if(!firstIO.Read(indexedFile, false, true) || firstIO.IsIndexFileUsed())
+			return false;
+
+		SeqCountIO indexedIO;
+		if(!indexedIO.Read(indexedFile, false, true) || !indexedIO.IsIndexFileUsed())
+			return false;
+
+		SeqCountIO mappedIO;
+		if(!mappedIO.Read(indexedFile, true, true) || !mappedIO.IsIndexFileUsed())
+			return false;
+
+		if(!CompareSeqCountIO(streamIO, firstIO) || !CompareSeqCountIO(streamIO, indexedIO) || !CompareSeqCountIO(streamIO, mappedIO))
+			return false;
+	}
+
+	// index file with counts that do not fit in the file is ignored
+	std::fstream indexIO(indexFile.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+	uint invalidCounts[2] = { 0x0fffffff, std::numeric_limits<uint>::max() };
+	indexIO.seekp(sizeof(uint) + sizeof(uint) + 2*sizeof(uint64));
+	indexIO.write((const char*)invalidCounts, sizeof(invalidCounts));
+	indexIO.close();
+
+	SeqCountIO corruptIndexIO;
+	SeqCountIO unindexedIO;
+	if(!corruptIndexIO.Read(indexedFile, false, true) || corruptIndexIO.IsIndexFileUsed() 
+			|| !unindexedIO.Read(indexedFile) || !CompareSeqCountIO(unindexedIO, corruptIndexIO))
+		return false;
+
+	remove(indexFile.c_str());
+	remove(indexedFile.c_str());
+
+	// integer and non-integer counts
+	std::string countFile = "../unit-tests/temp.env";
+	std::ofstream countOut(countFile.c_str(), std::ios::out | std::ios::binary);
+	countOut << "\tA\tB\tC\tD\tE\tF\tG\tH\tI\tJ\tK\tL\tM\tN\tO\tP\tQ\tR\n";
+	countOut << "sample1\t3\t1.5\t-2\t1e3\t007\t0\t+4\t 5\t123456789012345\t1234567890123456789\t0.25\t2E-1\t10\t0\t0\t11\t0\t12\r\n";
+	countOut.close();
+
+	double expectedCounts[] = { 3, 1.5, -2, 1000, 7, 0, 4, 5, 123456789012345.0, 1234567890123456789.0, 0.25, 0.2, 10, 0, 0, 11, 0, 12 };
+
+	SeqCountIO countIO;
+	if(!countIO.Read(countFile))
+		return false;
+
+	std::vector<double> count;
+	double totalNumSeq;
+	countIO.GetData(0, count, totalNumSeq);
+
+	std::vector<uint> seqIndices;
+	std::vector<double> sparseCount;
+	double sparseTotalNumSeq;
+	countIO.GetSparseData(0, seqIndices, sparseCount, sparseTotalNumSeq);
+
+	remove(countFile.c_str());
+
+	if(count.size() != sizeof(expectedCounts)/sizeof(expectedCounts[0]) || seqIndices.size() != 14)
+		return false;
+
+	for(uint i = 0; i < count.size(); ++i)
+	{
+		if(fabs(count[i] - expectedCounts[i]) > 1e-6 * std::max(1.0, fabs(expectedCounts[i])))
+			return false;
+	}
+
+	for(uint i = 0; i < seqIndices.size(); ++i)
+	{
+		if(sparseCount[i] != count[seqIndices[i]])
+			return false;
+	}
+
+	if(sparseTotalNumSeq != totalNumSeq)
+		return false;
+
+	// small block compressed file whose compressed bytes resemble the first line of a sparse triplet file
+	std::string smallTableFile = "../unit-tests/temp.env";
+	std::ofstream smallTableOut(smallTableFile.c_str());
+	for(uint j = 0; j < 5; ++j)
+		smallTableOut << '\t' << "seq" << j;
+	smallTableOut << std::endl;
+
+	for(uint i = 0; i < 4; ++i)
+	{
+		smallTableOut << "sample" << i;
+		for(uint j = 0; j < 5; ++j)
+			smallTableOut << '\t' << (i*j*7 + i + 3*j) % 5;
+		smallTableOut << std::endl;
+	}
+	smallTableOut.close();
+
+	std::string smallBgzfFile = "../unit-tests/temp.env.gz";
+	SeqCountIO smallTableIO;
+	bool bRoundTrip = smallTableIO.Read(smallTableFile) && BgzfFile::Compress(smallTableFile, smallBgzfFile);
+
+	SeqCountIO smallBgzfIO;
+	bRoundTrip = bRoundTrip && smallBgzfIO.Read(smallBgzfFile) && smallBgzfIO.IsCompressed() && CompareSeqCountIO(smallTableIO, smallBgzfIO);
+
+	remove(smallBgzfFile.c_str());
+	remove(smallTableFile.c_str());
+
+	if(!bRoundTrip)
+		return false;
+
+	// block compressed file with samples spanning several blocks
+	std::string tableFile = "../unit-tests/temp.env";
+	std::ofstream tableOut(tableFile.c_str());
+	for(uint j = 0; j < 12000; ++j)
+		tableOut << '\t' << "seq" << j;
+	tableOut << std::endl;
+
+	for(uint i = 0; i < 12; ++i)
+	{
+		tableOut << "sample" << i;
+		for(uint j = 0; j < 12000; ++j)
+			tableOut << '\t' << ((i == 0) ? j : (i*j) % 7);
+		tableOut << std::endl;
+	}
+	tableOut.close();
+
+	std::string bgzfFile = "../unit-tests/temp.env.gz";
+	SeqCountIO tableIO;
+	bIdentical = tableIO.Read(tableFile) && BgzfFile::Compress(tableFile, bgzfFile);
+
+	SeqCountIO bgzfIO;
+	bIdentical = bIdentical && bgzfIO.Read(bgzfFile) && bgzfIO.IsCompressed() && CompareSeqCountIO(tableIO, bgzfIO);
+
+	remove(bgzfFile.c_str());
+	remove(tableFile.c_str());
+
+	return bIdentical;
+}
+
+bool UnitTests::Subsampling()
+{
+	const uint sampleSeqIndices[] = { 2, 5, 7, 11 };
+	const double sampleCounts[] = { 10, 1, 40, 3 };
+	std::vector<uint> sampleIndices(sampleSeqIndices, sampleSeqIndices + 4);
+	std::vector<double> sampleCount(sampleCounts, sampleCounts + 4);
+
+	// identical seed, replicate, and sample give identical draws
+	Subsampler subsampler(7);
+	std::vector< std::vector<double> > draws;
+	uint replicates[] = { 0, 0, 1 };
+	for(uint i = 0; i < 3; ++i)
+	{
+		std::vector<uint> seqIndices = sampleIndices;
+		std::vector<double> count = sampleCount;
+		double totalNumSeq = 54;
+		subsampler.Draw(replicates[i], 3, seqIndices, count, totalNumSeq, 1000);
+		if(totalNumSeq != 1000 || seqIndices.size() != count.size())
+			return false;
+
+		draws.push_back(count);
+	}
+
+	if(draws[0] != draws[1] || draws[0] == draws[2])
+		return false;
+
+	// sequences are drawn in proportion to their counts when drawn with replacement
+	std::vector<uint> seqIndices = sampleIndices;
+	std::vector<double> count = sampleCount;
+	double totalNumSeq = 54;
+	subsampler.Draw(0, 0, seqIndices, count, totalNumSeq, 100000);
+	if(seqIndices.size() != 4 || seqIndices[2] != 7 || fabs(count[2] / 100000 - 40.0 / 54) > 0.01)
+		return false;
+
+	// drawing without replacement never draws a sequence more often than it occurs in the sample
+	subsampler.SetReplacement(false);
+	uint seqsToDraw[] = { 5, 50, 54, 100 };
+	for(uint i = 0; i < sizeof(seqsToDraw)/sizeof(seqsToDraw[0]); ++i)
+	{
+		seqIndices = sampleIndices;
+		count = sampleCount;
+		totalNumSeq = 54;
+		subsampler.Draw(0, 0, seqIndices, count, totalNumSeq, seqsToDraw[i]);
+		if(totalNumSeq != std::min<uint>(seqsToDraw[i], 54))
+			return false;
+
+		for(uint j = 0; j < seqIndices.size(); ++j)
+		{
+			uint k = std::find(sampleIndices.begin(), sampleIndices.end(), seqIndices[j]) - sampleIndices.begin();
+			if(k == sampleIndices.size() || count[j] > sampleCount[k])
+				return false;
+		}
+	}
+
+	return true;
+}
+
+bool UnitTests::SparseDataVectors()
+{
+	SeqCountIO seqCountIO;
+	if(!seqCountIO.Read("../unit-tests/Multifurcating.env", false, false))
+		return false;
+
+	Tree<Node> tree;
+	NewickIO newickIO;
+	if(!newickIO.Read(tree, "../unit-tests/Multifurcating.tre"))
+		return false;
+	tree.Project(seqCountIO.GetSeqs());
+
+	bool bWeighted[] = { true, false };
+	for(uint w = 0; w < 2; ++w)
+	{
+		DataVectorizer dataVec;
+		if(!dataVec.Init(&tree, true, bWeighted[w], true, seqCountIO.GetSeqs()))
+			return false;
+
+		// dense and sparse pairs are compared with separate buffers, as done by separate threads
+		ScratchArena scratch, sparseScratch;
+		dataVec.InitScratch(scratch);
+		dataVec.InitScratch(sparseScratch);
+
+		// sparse data vectors hold only the non-zero entries of the dense data vector
+		std::vector< std::vector<double> > denseVec(seqCountIO.GetNumSamples());
+		std::vector<SparseDataVector> sparseVec(seqCountIO.GetNumSamples());
+		for(uint i = 0; i < seqCountIO.GetNumSamples(); ++i)
+		{
+			std::vector<uint> seqIndices;
+			std::vector<double> count;
+			double totalNumSeq;
+			seqCountIO.GetSparseData(i, seqIndices, count, totalNumSeq);
+
+			dataVec.CalculateDataVector(seqIndices, count, false, totalNumSeq, denseVec[i]);
+			dataVec.CalculateDataVector(seqIndices, count, totalNumSeq, sparseVec[i]);
+
+			std::vector<double> expandedVec;
+			dataVec.ToDense(sparseVec[i], expandedVec);
+			if(expandedVec != denseVec[i] || std::count(sparseVec[i].value.begin(), sparseVec[i].value.end(), 0.0) != 0)
+				return false;
+		}
+
+		for(uint i = 0; i < seqCountIO.GetNumSamples(); ++i)
+		{
+			for(uint j = 0; j < seqCountIO.GetNumSamples(); ++j)
+			{
+				std::vector<double> denseI, denseJ, sparseI, sparseJ;
+
+				dataVec.LeafSetMinDistance(denseVec[i], denseVec[j], denseI, denseJ, scratch);
+				dataVec.LeafSetMinDistance(sparseVec[i], sparseVec[j], sparseI, sparseJ, sparseScratch);
+				if(denseI.empty() || denseI != sparseI || denseJ != sparseJ)
+					return false;
+
+				dataVec.LeafSetRootDistance(denseVec[i], denseVec[j], denseI, denseJ, scratch);
+				dataVec.LeafSetRootDistance(sparseVec[i], sparseVec[j], sparseI, sparseJ, sparseScratch);
+				if(denseI != sparseI || denseJ != sparseJ)
+					return false;
+
+				uint firstNode, mrcaNode, sparseFirstNode, sparseMRCANode;
+				dataVec.GetMRCARange(denseVec[i], denseVec[j], firstNode, mrcaNode);
+				dataVec.GetMRCARange(sparseVec[i], sparseVec[j], sparseFirstNode, sparseMRCANode);
+				if(firstNode == mrcaNode || firstNode != sparseFirstNode || mrcaNode != sparseMRCANode)
+					return false;
+
+				// pair of sparse data vectors restricted to the MRCA subtree visits the non-zero entries of the dense range
+				uint n;
+				double p1, p2;
+				uint numVisited = 0;
+				SparseDataVectorPair pair(sparseVec[i], sparseVec[j], firstNode, mrcaNode);
+				while(pair.Next(n, p1, p2))
+				{
+					if(n < firstNode || n >= mrcaNode || p1 != denseVec[i][n] || p2 != denseVec[j][n])
+						return false;
+					++numVisited;
+				}
+
+				uint numNonZero = 0;
+				for(n = firstNode; n < mrcaNode; ++n)
+					numNonZero += (denseVec[i][n] != 0 || denseVec[j][n] != 0);
+
+				if(numVisited != numNonZero)
+					return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool UnitTests::SinglePrecision()
+{
+	// dissimilarities calculated from single precision data vectors are within the documented error, with
+	// blocks of the same size as single precision blocks hold twice as many data vectors
+	std::string calculators[] = { "Bray-Curtis", "Canberra", "Soergel", "Kulczynski", "Euclidean", "MPD" };
+	for(uint i = 0; i < sizeof(calculators)/sizeof(calculators[0]); ++i)
+	{
+		for(uint weighted = 0; weighted < 2; ++weighted)
+		{
+			for(uint mrca = 0; mrca < 2; ++mrca)
+			{
+				std::vector< std::vector<double> > expectedMatrix;
+				DiversityCalculator doubleCalc("../unit-tests/SharedSeqs.env", "../unit-tests/SharedSeqs.tre", calculators[i], 8, weighted == 1, false, mrca == 1, false, false);
+				doubleCalc.Dissimilarity("../unit-tests/temp", "UPGMA");
+				ReadDissMatrix("../unit-tests/temp.diss", expectedMatrix);
+
+				std::vector< std::vector<double> > dissMatrix;
+				DiversityCalculator floatCalc("../unit-tests/SharedSeqs.env", "../unit-tests/SharedSeqs.tre", calculators[i], 4, weighted == 1, false, mrca == 1, false, false, false, false, 1024, 4096, true);
+				floatCalc.Dissimilarity("../unit-tests/temp", "UPGMA");
+				ReadDissMatrix("../unit-tests/temp.diss", dissMatrix);
+
+				if(dissMatrix.size() != expectedMatrix.size())
+					return false;
+
+				for(uint r = 0; r < expectedMatrix.size(); ++r)
+				{
+					if(dissMatrix[r].size() != expectedMatrix[r].size())
+						return false;
+
+					for(uint c = 0; c < expectedMatrix[r].size(); ++c)
+					{
+						if(!Compare(dissMatrix[r][c], expectedMatrix[r][c]))
+							return false;
+					}
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+bool UnitTests::BitDataVectors()
+{
+	SeqCountIO seqCountIO;
+	if(!seqCountIO.Read("../unit-tests/Multifurcating.env", false, false))
+		return false;
+
+	Tree<Node> tree;
+	NewickIO newickIO;
+	if(!newickIO.Read(tree, "../unit-tests/Multifurcating.tre"))
+		return false;
+	tree.Project(seqCountIO.GetSeqs());
+
+	DataVectorizer dataVec;
+	if(!dataVec.Init(&tree, true, false, true, seqCountIO.GetSeqs()))
+		return false;
+
+	// presence/absence data vectors set a bit for each non-zero entry of the unweighted data vector
+	for(uint i = 0; i < seqCountIO.GetNumSamples(); ++i)
+	{
+		std::vector<uint> seqIndices;
+		std::vector<double> count;
+		double totalNumSeq;
+		seqCountIO.GetSparseData(i, seqIndices, count, totalNumSeq);
+
+		std::vector<double> denseVec;
+		BitDataVector bitVec;
+		dataVec.CalculateDataVector(seqIndices, count, false, totalNumSeq, denseVec);
+		dataVec.CalculateDataVector(seqIndices, count, totalNumSeq, bitVec);
+
+		BitDataVector convertedVec;
+		dataVec.ToBits(denseVec, convertedVec);
+		if(bitVec.bits != convertedVec.bits || bitVec.bits.size() != (denseVec.size() + 63) / 64)
+			return false;
+
+		std::vector<double> expandedVec;
+		dataVec.ToDense(bitVec, expandedVec);
+		if(expandedVec != denseVec)
+			return false;
+	}
+
+	// presence/absence data vectors give the same dissimilarities as dense data vectors of zeros and ones for 
+	// each calculator with a presence/absence form, over a tree spanning several words of branch weights
+	std::string seqCountFile = "../unit-tests/temp_bits.env";
+	std::string treeFile = "../unit-tests/temp_bits.tre";
+	WriteBalancedTreeData(seqCountFile, treeFile, 70, 12);
+
+	std::string bitCalculators[] = { "Bray-Curtis", "Canberra", "Coefficient of similarity", "Euclidean", "Kulczynski", "Lennon", "Manhattan", "Soergel" };
+	bool bIdentical = true;
+	for(uint i = 0; i < sizeof(bitCalculators)/sizeof(bitCalculators[0]) && bIdentical; ++i)
+	{
+		std::vector< std::vector<double> > bitMatrix;
+		DiversityCalculator bits(seqCountFile, treeFile, bitCalculators[i], 1000, false, false, false, false, false);
+		bits.Dissimilarity("../unit-tests/temp", "UPGMA");
+		ReadDissMatrix("../unit-tests/temp.diss", bitMatrix);
+
+		std::vector< std::vector<double> > denseMatrix;
+		DiversityCalculator::SetBitPacking(false);
+		DiversityCalculator dense(seqCountFile, treeFile, bitCalculators[i], 1000, false, false, false, false, false);
+		dense.Dissimilarity("../unit-tests/temp", "UPGMA");
+		ReadDissMatrix("../unit-tests/temp.diss", denseMatrix);
+		DiversityCalculator::SetBitPacking(true);
+
+		bIdentical = bitMatrix.size() == 12 && denseMatrix.size() == bitMatrix.size();
+		for(uint r = 0; r < bitMatrix.size() && bIdentical; ++r)
+		{
+			bIdentical = bitMatrix[r].size() == denseMatrix[r].size();
+			for(uint c = 0; c < bitMatrix[r].size() && bIdentical; ++c)
+				bIdentical = Compare(bitMatrix[r][c], denseMatrix[r][c]);
+		}
+	}
+
+	remove(seqCountFile.c_str());
+	remove(treeFile.c_str());
+
+	if(!bIdentical)
+		return false;
+
+	// presence/absence data vectors are swapped between blocks in the same manner as other data vectors
+	std::string calculators[] = { "Bray-Curtis", "Soergel" };
+	for(uint i = 0; i < sizeof(calculators)/sizeof(calculators[0]); ++i)
+	{
+		std::vector< std::vector<double> > expectedMatrix;
+		DiversityCalculator singleBlock("../unit-tests/DataMatrixMothur.env", "", calculators[i], 1000, false, false, false, false, false);
+		singleBlock.Dissimilarity("../unit-tests/temp", "UPGMA");
+		ReadDissMatrix("../unit-tests/temp.diss", expectedMatrix);
+
+		std::vector< std::vector<double> > dissMatrix;
+		DiversityCalculator blocks("../unit-tests/DataMatrixMothur.env", "", calculators[i], 2, false, false, false, false, false);
+		blocks.Dissimilarity("../unit-tests/temp", "UPGMA");
+		ReadDissMatrix("../unit-tests/temp.diss", dissMatrix);
+
+		if(expectedMatrix.empty() || dissMatrix != expectedMatrix)
+			return false;
+	}
+
+	return true;
+}
+
+bool UnitTests::LeafDistances()
+{
+	SeqCountIO seqCountIO;
+	if(!seqCountIO.Read("../unit-tests/Multifurcating.env", false, false))
+		return false;
+
+	Tree<Node> tree;
+	NewickIO newickIO;
+	if(!newickIO.Read(tree, "../unit-tests/Multifurcating.tre"))
+		return false;
+	tree.Project(seqCountIO.GetSeqs());
+
+	DataVectorizer dataVec;
+	if(!dataVec.Init(&tree, true, true, true, seqCountIO.GetSeqs()))
+		return false;
+
+	ScratchArena scratch;
+	dataVec.InitScratch(scratch);
+
+	std::vector<Node*> postOrder = tree.PostOrder(tree.GetRootNode());
+
+	// distances found from the lowest common ancestor agree with summing branches along the path between leaves
+	std::vector< std::vector<double> > denseVec(seqCountIO.GetNumSamples());
+	std::vector<SparseDataVector> sparseVec(seqCountIO.GetNumSamples());
+	for(uint i = 0; i < seqCountIO.GetNumSamples(); ++i)
+	{
+		std::vector<uint> seqIndices;
+		std::vector<double> count;
+		double totalNumSeq;
+		seqCountIO.GetSparseData(i, seqIndices, count, totalNumSeq);
+		dataVec.CalculateDataVector(seqIndices, count, false, totalNumSeq, denseVec[i]);
+		dataVec.CalculateDataVector(seqIndices, count, totalNumSeq, sparseVec[i]);
+	}
+
+	for(uint i = 0; i < seqCountIO.GetNumSamples(); ++i)
+	{
+		for(uint j = 0; j < seqCountIO.GetNumSamples(); ++j)
+		{
+			std::vector<Node*> leafSetI, leafSetJ;
+			std::vector<double> leafPropI, leafPropJ;
+			for(uint n = 0; n < denseVec[i].size(); ++n)
+			{
+				if(postOrder[n]->IsLeaf() && denseVec[i][n] > 0)
+				{
+					leafSetI.push_back(postOrder[n]);
+					leafPropI.push_back(denseVec[i][n]);
+				}
+
+				if(postOrder[n]->IsLeaf() && denseVec[j][n] > 0)
+				{
+					leafSetJ.push_back(postOrder[n]);
+					leafPropJ.push_back(denseVec[j][n]);
+				}
+			}
+
+			if(leafSetI.empty())
+				return false;
+
+			// distance between each pair of leaf nodes in the two communities found by summing branches along the path between them
+			std::vector< std::vector<double> > leafDist(leafSetI.size());
+			double expectedSum = 0;
+			for(uint r = 0; r < leafSetI.size(); ++r)
+			{
+				for(uint c = 0; c < leafSetJ.size(); ++c)
+				{
+					leafDist[r].push_back(tree.GetPhylogeneticDistance(leafSetI[r], leafSetJ[c]));
+					expectedSum += leafPropI[r]*leafPropJ[c]*leafDist[r][c];
+				}
+			}
+
+			// summing over branches gives the same proportion weighted distance as summing over pairs of leaf nodes
+			LeafSetDistanceSums sums, sparseSums;
+			dataVec.LeafSetDistanceSum(denseVec[i], denseVec[j], false, sums, scratch);
+			dataVec.LeafSetDistanceSum(sparseVec[i], sparseVec[j], false, sparseSums, scratch);
+			if(!Compare(sums.sumIJ, expectedSum) || !Compare(sparseSums.sumIJ, expectedSum))
+				return false;
+
+			if(!Compare(sums.totalI, std::accumulate(leafPropI.begin(), leafPropI.end(), 0.0)) || !Compare(sums.totalJ, std::accumulate(leafPropJ.begin(), leafPropJ.end(), 0.0)))
+				return false;
+
+			// sums within and across communities agree with summing over pairs of leaf nodes present in either community,
+			// with the mass of a leaf node indicating its presence when bPresence is set
+			for(uint p = 0; p < 2; ++p)
+			{
+				bool bPresence = (p == 1);
+				std::vector<double> presenceI(denseVec[i]);
+				std::vector<double> presenceJ(denseVec[j]);
+				SparseDataVector sparsePresenceI(sparseVec[i]);
+				SparseDataVector sparsePresenceJ(sparseVec[j]);
+				if(bPresence)
+				{
+					for(uint n = 0; n < presenceI.size(); ++n)
+					{
+						presenceI[n] = (presenceI[n] > 0) ? 1 : 0;
+						presenceJ[n] = (presenceJ[n] > 0) ? 1 : 0;
+					}
+
+					std::fill(sparsePresenceI.value.begin(), sparsePresenceI.value.end(), 1.0);
+					std::fill(sparsePresenceJ.value.begin(), sparsePresenceJ.value.end(), 1.0);
+				}
+
+				std::vector<Node*> pairedLeafSet;
+				std::vector<double> pairedPropI, pairedPropJ;
+				for(uint n = 0; n < presenceI.size(); ++n)
+				{
+					if(postOrder[n]->IsLeaf() && (presenceI[n] > 0 || presenceJ[n] > 0))
+					{
+						pairedLeafSet.push_back(postOrder[n]);
+						pairedPropI.push_back(presenceI[n]);
+						pairedPropJ.push_back(presenceJ[n]);
+					}
+				}
+
+				double sumII = 0, sumJJ = 0, sumUnion = 0;
+				for(uint x = 0; x < pairedLeafSet.size(); ++x)
+				{
+					for(uint y = 0; y < pairedLeafSet.size(); ++y)
+					{
+						double dist = tree.GetPhylogeneticDistance(pairedLeafSet[x], pairedLeafSet[y]);
+						sumII += pairedPropI[x]*pairedPropI[y]*dist;
+						sumJJ += pairedPropJ[x]*pairedPropJ[y]*dist;
+						sumUnion += dist;
+					}
+				}
+
+				dataVec.LeafSetDistanceSum(presenceI, presenceJ, bPresence, sums, scratch);
+				dataVec.LeafSetDistanceSum(sparsePresenceI, sparsePresenceJ, bPresence, sparseSums, scratch);
+				if(sums.numLeaves != pairedLeafSet.size() || sparseSums.numLeaves != pairedLeafSet.size())
+					return false;
+
+				if(!Compare(sums.sumII, sumII) || !Compare(sums.sumJJ, sumJJ) || !Compare(sparseSums.sumII, sumII) || !Compare(sparseSums.sumJJ, sumJJ))
+					return false;
+
+				if(bPresence && (!Compare(sums.sumUnion, sumUnion) || !Compare(sparseSums.sumUnion, sumUnion)))
+					return false;
+			}
+
+			// MRCA subtree is the smallest subtree holding every leaf node in either community and occupies a post-order range
+			std::set<Node*> present(leafSetI.begin(), leafSetI.end());
+			present.insert(leafSetJ.begin(), leafSetJ.end());
+
+			Node* mrca = leafSetI[0];
+			std::vector<Node*> subtree;
+			uint numPresent = 0;
+			while(numPresent != present.size())
+			{
+				if(!subtree.empty())
+					mrca = mrca->GetParent();
+
+				subtree = tree.PostOrder(mrca);
+				numPresent = 0;
+				for(uint n = 0; n < subtree.size(); ++n)
+					numPresent += present.count(subtree[n]);
+			}
+
+			uint firstNode, mrcaNode, sparseFirstNode, sparseMRCANode;
+			dataVec.GetMRCARange(denseVec[i], denseVec[j], firstNode, mrcaNode);
+			dataVec.GetMRCARange(sparseVec[i], sparseVec[j], sparseFirstNode, sparseMRCANode);
+			if(postOrder[mrcaNode] != mrca || postOrder[firstNode] != subtree.front() || mrcaNode - firstNode + 1 != subtree.size())
+				return false;
+
+			if(firstNode != sparseFirstNode || mrcaNode != sparseMRCANode)
+				return false;
+
+			// nearest neighbour found by passes up and down the tree is the closest leaf node over all pairs
+			std::vector<double> minLeafI, minLeafJ, sparseMinLeafI, sparseMinLeafJ;
+			dataVec.LeafSetMinDistance(denseVec[i], denseVec[j], minLeafI, minLeafJ, scratch);
+			dataVec.LeafSetMinDistance(sparseVec[i], sparseVec[j], sparseMinLeafI, sparseMinLeafJ, scratch);
+			if(minLeafI.size() != leafSetI.size() || sparseMinLeafI.size() != leafSetI.size())
+				return false;
+
+			if(minLeafJ.size() != leafSetJ.size() || sparseMinLeafJ.size() != leafSetJ.size())
+				return false;
+
+			for(uint r = 0; r < leafSetI.size(); ++r)
+			{
+				double minDist = *std::min_element(leafDist[r].begin(), leafDist[r].end());
+				if(!Compare(minLeafI[r], leafPropI[r]*minDist) || !Compare(sparseMinLeafI[r], leafPropI[r]*minDist))
+					return false;
+			}
+
+			for(uint c = 0; c < leafSetJ.size(); ++c)
+			{
+				double minDist = std::numeric_limits<double>::max();
+				for(uint r = 0; r < leafSetI.size(); ++r)
+					minDist = std::min(minDist, leafDist[r][c]);
+
+				if(!Compare(minLeafJ[c], leafPropJ[c]*minDist) || !Compare(sparseMinLeafJ[c], leafPropJ[c]*minDist))
+					return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool UnitTests::VectorInstructions()
+{
+	// vectors with zero entries and extents exercise the elements skipped by Canberra and Gower, and
+	// their length is not a multiple of any vector width so partial vectors are also tested
+	std::vector<double> com1, com2, branchWeight, minExtent, maxExtent;
+	for(uint n = 0; n < 43; ++n)
+	{
+		com1.push_back(n % 3 == 0 ? 0 : ((n*37) % 11) / 11.0);
+		com2.push_back(n % 4 == 0 ? 0 : ((n*53) % 13) / 13.0);
+		branchWeight.push_back(0.1 + ((n*17) % 7) / 7.0);
+
+		minExtent.push_back(std::min<double>(com1[n], com2[n]));
+		maxExtent.push_back(n % 5 == 0 ? minExtent[n] : std::max<double>(com1[n], com2[n]));
+	}
+
+	std::vector<float> floatCom1(com1.begin(), com1.end());
+	std::vector<float> floatCom2(com2.begin(), com2.end());
+	std::vector<float> floatBranchWeight(branchWeight.begin(), branchWeight.end());
+
+	VectorKernels::InstructionSet selected = VectorKernels::GetInstructionSet();
+
+	bool bPassed = true;
+	for(uint set = VectorKernels::SCALAR; set <= VectorKernels::GetSupportedInstructionSet(); ++set)
+	{
+		VectorKernels::InstructionSet instructionSet = (VectorKernels::InstructionSet)set;
+		bPassed = bPassed && CompareVectorKernels(com1, com2, branchWeight, minExtent, maxExtent, instructionSet);
+		bPassed = bPassed && CompareVectorKernels(floatCom1, floatCom2, floatBranchWeight, minExtent, maxExtent, instructionSet);
+	}
+
+	VectorKernels::SetInstructionSet(selected);
+
+	return bPassed;
+}
+
+template<class T>
+bool UnitTests::CompareVectorKernels(const std::vector<T>& com1, const std::vector<T>& com2, const std::vector<T>& branchWeight, 
+																			const std::vector<double>& minExtent, const std::vector<double>& maxExtent, VectorKernels::InstructionSet instructionSet)
+{
+	VectorKernels::SetInstructionSet(VectorKernels::SCALAR);
+	VectorKernelTable<T> expected = VectorKernels::Get(com1);
+	VectorKernels::SetInstructionSet(instructionSet);
+	VectorKernelTable<T> actual = VectorKernels::Get(com1);
+
+	typename VectorKernelTable<T>::Kernel expectedKernels[] = { expected.brayCurtis, expected.canberra, expected.euclidean, expected.gower, 
+																															expected.kulczynski, expected.lennonCD, expected.manhattan, expected.soergel, expected.yueClayton };
+	typename VectorKernelTable<T>::Kernel actualKernels[] = { actual.brayCurtis, actual.canberra, actual.euclidean, actual.gower, 
+																														actual.kulczynski, actual.lennonCD, actual.manhattan, actual.soergel, actual.yueClayton };
+	uint numSums[] = { 2, 1, 1, 1, 1, 3, 1, 2, 2 };
+
+	for(uint k = 0; k < sizeof(numSums)/sizeof(numSums[0]); ++k)
+	{
+		for(uint n = 0; n <= com1.size(); ++n)
+		{
+			double expectedSums[3];
+			expectedKernels[k](&com1[0], &com2[0], &branchWeight[0], &minExtent[0], &maxExtent[0], n, expectedSums);
+
+			double actualSums[3];
+			actualKernels[k](&com1[0], &com2[0], &branchWeight[0], &minExtent[0], &maxExtent[0], n, actualSums);
+
+			// all terms are non-negative so the sums only differ by rounding from the order terms are added
+			for(uint s = 0; s < numSums[k]; ++s)
+			{
+				if(fabs(actualSums[s] - expectedSums[s]) > 2*n*DBL_EPSILON*fabs(expectedSums[s]))
+					return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool UnitTests::ParallelComparison()
+{
+	// 40 samples so rows of each block are compared by several threads
+	std::string seqCountFile = "../unit-tests/temp_parallel.env";
+	std::string treeFile = "../unit-tests/temp_parallel.tre";
+	WriteBalancedTreeData(seqCountFile, treeFile, 32, 40);
+
+	// comparing pairs with a team of threads gives the same dissimilarities as comparing them serially for 
+	// sparse, presence/absence, MRCA weighted, MRCA restricted, leaf distance, and single precision comparisons
+	const char* calculators[] = { "Bray-Curtis", "Soergel", "Gower", "Canberra", "MPD", "Bray-Curtis" };
+	bool bWeighted[] = { true, false, true, true, false, true };
+	bool bMRCA[] = { false, false, true, false, false, false };
+	bool bStrictMRCA[] = { false, false, false, true, false, false };
+	bool bSinglePrecision[] = { false, false, false, false, false, true };
+
+	bool bIdentical = true;
+#ifdef _OPENMP
+	int maxThreads = omp_get_max_threads();
+	for(uint i = 0; i < sizeof(calculators)/sizeof(calculators[0]) && bIdentical; ++i)
+	{
+		std::vector< std::vector<double> > expectedMatrix;
+		omp_set_num_threads(1);
+		DiversityCalculator serial(seqCountFile, treeFile, calculators[i], 8, bWeighted[i], bMRCA[i], bStrictMRCA[i], false, false, false, false, 1024, 4096, bSinglePrecision[i]);
+		serial.Dissimilarity("../unit-tests/temp", "UPGMA");
+		ReadDissMatrix("../unit-tests/temp.diss", expectedMatrix);
+
+		std::vector< std::vector<double> > dissMatrix;
+		omp_set_num_threads(4);
+		DiversityCalculator parallel(seqCountFile, treeFile, calculators[i], 8, bWeighted[i], bMRCA[i], bStrictMRCA[i], false, false, false, false, 1024, 4096, bSinglePrecision[i]);
+		parallel.Dissimilarity("../unit-tests/temp", "UPGMA");
+		ReadDissMatrix("../unit-tests/temp.diss", dissMatrix);
+
+		bIdentical = expectedMatrix.size() == 40 && dissMatrix == expectedMatrix;
+	}
+	omp_set_num_threads(maxThreads);
+#endif
+
+	remove(seqCountFile.c_str());
+	remove(treeFile.c_str());
+
+	return bIdentical;
+}
+
+void UnitTests::WriteBalancedTreeData(const std::string& seqCountFile, const std::string& treeFile, uint numSeqs, uint numSamples)
+{
+	// balanced tree with branches of varying length
+	std::vector<std::string> subtrees;
+	for(uint i = 0; i < numSeqs; ++i)
+		subtrees.push_back("S" + StringTools::ToString(i) + ":" + StringTools::ToString(0.1*(i % 5 + 1)));
+
+	while(subtrees.size() > 1)
+	{
+		std::vector<std::string> parents;
+		for(uint i = 0; i + 1 < subtrees.size(); i += 2)
+			parents.push_back("(" + subtrees[i] + "," + subtrees[i+1] + "):" + StringTools::ToString(0.1*(parents.size() % 3 + 1)));
+
+		if(subtrees.size() % 2 == 1)
+			parents.push_back(subtrees.back());
+		subtrees.swap(parents);
+	}
+
+	std::ofstream treeOut(treeFile.c_str());
+	treeOut << subtrees[0].substr(0, subtrees[0].rfind(':')) << ";" << std::endl;
+	treeOut.close();
+
+	// most counts are zero
+	std::ofstream seqCountOut(seqCountFile.c_str());
+	for(uint j = 0; j < numSeqs; ++j)
+		seqCountOut << "\tS" << j;
+	seqCountOut << std::endl;
+
+	for(uint i = 0; i < numSamples; ++i)
+	{
+		seqCountOut << "sample" << i;
+		for(uint j = 0; j < numSeqs; ++j)
+			seqCountOut << '\t' << (((i*7 + j*13) % 11 > 8) ? (i + j) % 5 + 1 : 0);
+		seqCountOut << std::endl;
+	}
+	seqCountOut.close();
+}
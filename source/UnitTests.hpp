@@ -24,6 +24,9 @@
 
 #include "Precompiled.hpp"
 
+#include "SeqCountIO.hpp"
+#include "VectorKernels.hpp"
+
 /**
  * @brief Execute unit tests.
  */
@@ -51,6 +54,44 @@ private:
 	/** Test tree with shared sequences. Ground truth determined by Chameleon and Fast UniFrac. */
 	bool SharedSeqs();
 
+	/** Test that all methods of reading sequence count files provide identical count data. */
+	bool SeqCountFileFormats();
+
+	/** Test that caching data vectors does not change the dissimilarity between samples. */
+	bool DataVectorCaching();
+
+	/** Test that sequences drawn for jackknife replicates are reproducible and respect the counts of each sample. */
+	bool Subsampling();
+
+	/** Test that sparse data vectors give the same leaf sets, distances, and MRCA subtrees as dense data vectors. */
+	bool SparseDataVectors();
+
+	/** Test that single precision data vectors give dissimilarities within the documented error of double precision. */
+	bool SinglePrecision();
+
+	/** Test that presence/absence data vectors hold the non-zero entries of unweighted data vectors. */
+	bool BitDataVectors();
+
+	/** Test that distances between leaf nodes, their sums over branches within and across communities, nearest neighbours, and MRCA subtrees agree with the length of the path between them in the tree. */
+	bool LeafDistances();
+
+	/** Test that vector kernels for each supported instruction set agree with the scalar kernels to within the documented tolerance. */
+	bool VectorInstructions();
+
+	/** Test that comparing rows of each block with a team of threads gives the same dissimilarities as comparing them serially. */
+	bool ParallelComparison();
+
+	/** Check that kernels for an instruction set agree with the scalar kernels over each prefix of a set of data vectors. */
+	template<class T>
+	bool CompareVectorKernels(const std::vector<T>& com1, const std::vector<T>& com2, const std::vector<T>& branchWeight, 
+															const std::vector<double>& minExtent, const std::vector<double>& maxExtent, VectorKernels::InstructionSet instructionSet);
+
+	/** Write a balanced tree with branches of varying length and a sequence count file of mostly zero counts over its leaves. */
+	void WriteBalancedTreeData(const std::string& seqCountFile, const std::string& treeFile, uint numSeqs, uint numSamples);
+
+	/** Check that two sequence count readers provide identical sample names and count data. */
+	bool CompareSeqCountIO(SeqCountIO& expected, SeqCountIO& actual);
+
 	bool ReadDissMatrix(const std::string& dissMatrixFile, std::vector< std::vector<double> >& dissMatrix);
 	bool Compare(double actual, double expected);
 };
@@ -0,0 +1,166 @@
+//=======================================================================
+// Author: Donovan Parks
+//
+// Copyright 2011 Donovan Parks
+//
+// This file is part of ExpressBetaDiversity.
+//
+// ExpressBetaDiversity is free software: you can redistribute it 
+// and/or modify it under the terms of the GNU General Public License 
+// as published by the Free Software Foundation, either version 3 of 
+// the License, or (at your option) any later version.
+//
+// ExpressBetaDiversity is distributed in the hope that it will be 
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ExpressBetaDiversity. If not, see 
+// <http://www.gnu.org/licenses/>.
+//=======================================================================
+
+
+#include "Precompiled.hpp"
+
+#include "VectorKernels.hpp"
+#include "VectorKernelsImpl.hpp"
+#include "VectorKernelsAvx2.hpp"
+#include "VectorKernelsAvx512.hpp"
+
+#ifdef VECTOR_KERNELS_X86
+	#if defined(_MSC_VER)
+		#include <intrin.h>
+	#else
+		#include <cpuid.h>
+	#endif
+#endif
+
+VectorKernels::InstructionSet VectorKernels::m_instructionSet = VectorKernels::SCALAR;
+VectorKernelTable<double> VectorKernels::m_doubleKernels;
+VectorKernelTable<float> VectorKernels::m_floatKernels;
+
+namespace
+{
+	/** Portable kernels performing the same operations in the same order as a simple loop over the elements. */
+	struct ScalarIsa
+	{
+		typedef double Vec;
+		enum { WIDTH = 1, UNROLL = 1 };
+
+		static Vec Zero() { return 0; }
+		static Vec Load(const double* p) { return *p; }
+		static Vec Load(const float* p) { return *p; }
+		static Vec LoadPartial(const double* p, uint count) { return *p; }
+		static Vec LoadPartial(const float* p, uint count) { return *p; }
+
+		static Vec Add(Vec a, Vec b) { return a + b; }
+		static Vec Sub(Vec a, Vec b) { return a - b; }
+		static Vec Mul(Vec a, Vec b) { return a * b; }
+		static Vec Div(Vec a, Vec b) { return a / b; }
+		static Vec Abs(Vec a) { return fabs(a); }
+		static Vec Min(Vec a, Vec b) { return std::min<double>(a, b); }
+		static Vec Max(Vec a, Vec b) { return std::max<double>(a, b); }
+
+		static Vec SelectNonZero(Vec c, Vec v) { return c != 0 ? v : 0; }
+		static Vec SelectPositive(Vec c, Vec v) { return c > 0 ? v : 0; }
+
+		static double Sum(Vec v) { return v; }
+	};
+
+#ifdef VECTOR_KERNELS_X86
+	void Cpuid(uint leaf, uint regs[4])
+	{
+	#if defined(_MSC_VER)
+		__cpuidex((int*)regs, leaf, 0);
+	#else
+		__cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+	#endif
+	}
+
+	// get register state enabled by the operating system
+	uint64 Xgetbv()
+	{
+	#if defined(_MSC_VER)
+		return _xgetbv(0);
+	#else
+		uint eax, edx;
+		__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		return ((uint64)edx << 32) | eax;
+	#endif
+	}
+#endif
+}
+
+static void GetScalarKernels(VectorKernelTable<double>& doubleKernels, VectorKernelTable<float>& floatKernels)
+{
+	FillKernelTable<ScalarIsa, double>(doubleKernels);
+	FillKernelTable<ScalarIsa, float>(floatKernels);
+}
+
+void VectorKernels::Init()
+{
+	SetInstructionSet(GetSupportedInstructionSet());
+}
+
+bool VectorKernels::SetInstructionSet(InstructionSet instructionSet)
+{
+	if(instructionSet > GetSupportedInstructionSet())
+		return false;
+
+#ifdef VECTOR_KERNELS_X86
+	if(instructionSet == AVX512)
+		GetAvx512Kernels(m_doubleKernels, m_floatKernels);
+	else if(instructionSet == AVX2)
+		GetAvx2Kernels(m_doubleKernels, m_floatKernels);
+	else
+#endif
+		GetScalarKernels(m_doubleKernels, m_floatKernels);
+
+	m_instructionSet = instructionSet;
+
+	return true;
+}
+
+VectorKernels::InstructionSet VectorKernels::GetSupportedInstructionSet()
+{
+#ifdef VECTOR_KERNELS_X86
+	uint regs[4];
+	Cpuid(0, regs);
+	if(regs[0] < 7)
+		return SCALAR;
+
+	// AVX requires the operating system to save YMM registers (XCR0 bits 1-2)
+	Cpuid(1, regs);
+	bool bOsxsave = (regs[2] & (1 << 27)) != 0;
+	bool bAvx = (regs[2] & (1 << 28)) != 0;
+	if(!bOsxsave || !bAvx)
+		return SCALAR;
+
+	uint64 xcr0 = Xgetbv();
+	if((xcr0 & 0x06) != 0x06)
+		return SCALAR;
+
+	// AVX-512 also requires opmask and ZMM registers to be saved (XCR0 bits 5-7)
+	Cpuid(7, regs);
+	bool bAvx2 = (regs[1] & (1 << 5)) != 0;
+	bool bAvx512 = (regs[1] & (1 << 16)) != 0;
+	if(bAvx512 && (xcr0 & 0xe6) == 0xe6)
+		return AVX512;
+
+	if(bAvx2)
+		return AVX2;
+#endif
+
+	return SCALAR;
+}
+
+std::string VectorKernels::GetName(InstructionSet instructionSet)
+{
+	if(instructionSet == AVX512)
+		return "AVX-512";
+	else if(instructionSet == AVX2)
+		return "AVX2";
+
+	return "scalar";
+}
@@ -0,0 +1,92 @@
+//=======================================================================
+// Author: Donovan Parks
+//
+// Copyright 2011 Donovan Parks
+//
+// This file is part of ExpressBetaDiversity.
+//
+// ExpressBetaDiversity is free software: you can redistribute it 
+// and/or modify it under the terms of the GNU General Public License 
+// as published by the Free Software Foundation, either version 3 of 
+// the License, or (at your option) any later version.
+//
+// ExpressBetaDiversity is distributed in the hope that it will be 
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ExpressBetaDiversity. If not, see 
+// <http://www.gnu.org/licenses/>.
+//=======================================================================
+
+
+#ifndef _VECTOR_KERNELS_
+#define _VECTOR_KERNELS_
+
+#include "Precompiled.hpp"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	#define VECTOR_KERNELS_X86
+#endif
+
+/**
+ * @brief Kernels giving the branch weighted sums over data vector elements required by a calculator.
+ *
+ * Each kernel sets sums[] to the sums for elements [0, n). The extents are only read by the Gower kernel.
+ */
+template<class T> struct VectorKernelTable
+{
+	typedef void (*Kernel)(const T* com1, const T* com2, const T* branchWeight, const double* minExtent, const double* maxExtent, uint n, double* sums);
+
+	Kernel brayCurtis;	// sum |a-b|w, sum (a+b)w
+	Kernel canberra;		// sum (|a-b|/(a+b))w over a+b != 0
+	Kernel euclidean;		// sum w(a-b)^2
+	Kernel gower;				// sum (|a-b|/(max-min))w over max-min > 0
+	Kernel kulczynski;	// sum min(a,b)w
+	Kernel lennonCD;		// sum min(a,b)w, sum (max(a,b)-b)w, sum (max(a,b)-a)w
+	Kernel manhattan;		// sum |a-b|w
+	Kernel soergel;			// sum |a-b|w, sum max(a,b)w
+	Kernel yueClayton;	// sum abw, sum ((a-b)^2+ab)w
+};
+
+/**
+ * @brief Select vector instructions used by the element-wise calculators.
+ *
+ * The widest instruction set supported by the processor is selected at startup. Vector kernels 
+ * accumulate each sum in several lanes and so only differ from the scalar kernels in the order 
+ * terms are added. As all terms are non-negative, the relative difference from the scalar result 
+ * is at most about n*DBL_EPSILON for vectors with n elements (~2e-10 for a million nodes). Single
+ * precision data vectors are converted to double precision before any arithmetic is performed.
+ */
+class VectorKernels
+{
+public:
+	enum InstructionSet { SCALAR = 0, AVX2, AVX512 };
+
+	/** Select kernels for the widest instruction set supported by the processor. */
+	static void Init();
+
+	/** Select kernels for an instruction set. Returns false if it is not supported by the processor. */
+	static bool SetInstructionSet(InstructionSet instructionSet);
+
+	/** Get instruction set used by the selected kernels. */
+	static InstructionSet GetInstructionSet() { return m_instructionSet; }
+
+	/** Get widest instruction set supported by the processor. */
+	static InstructionSet GetSupportedInstructionSet();
+
+	/** Get name of instruction set. */
+	static std::string GetName(InstructionSet instructionSet);
+
+	/** Get selected kernels for data vectors of the given type. */
+	static const VectorKernelTable<double>& Get(const std::vector<double>&) { return m_doubleKernels; }
+	static const VectorKernelTable<float>& Get(const std::vector<float>&) { return m_floatKernels; }
+
+private:
+	static InstructionSet m_instructionSet;
+	static VectorKernelTable<double> m_doubleKernels;
+	static VectorKernelTable<float> m_floatKernels;
+};
+
+#endif
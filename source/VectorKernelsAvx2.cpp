@@ -0,0 +1,98 @@
+//=======================================================================
+// Author: Donovan Parks
+//
+// Copyright 2011 Donovan Parks
+//
+// This file is part of ExpressBetaDiversity.
+//
+// ExpressBetaDiversity is free software: you can redistribute it 
+// and/or modify it under the terms of the GNU General Public License 
+// as published by the Free Software Foundation, either version 3 of 
+// the License, or (at your option) any later version.
+//
+// ExpressBetaDiversity is distributed in the hope that it will be 
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ExpressBetaDiversity. If not, see 
+// <http://www.gnu.org/licenses/>.
+//=======================================================================
+
+
+#include "Precompiled.hpp"
+
+#include "VectorKernelsAvx2.hpp"
+
+#ifdef VECTOR_KERNELS_X86
+
+#include <immintrin.h>
+
+// compile the kernels below for AVX2 regardless of the instruction set targeted by the rest of the program
+#if defined(__clang__)
+	#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+	#pragma GCC push_options
+	#pragma GCC target("avx2")
+#endif
+
+#include "VectorKernelsImpl.hpp"
+
+namespace
+{
+	struct Avx2Isa
+	{
+		typedef __m256d Vec;
+		enum { WIDTH = 4, UNROLL = 4 };
+
+		static Vec Zero() { return _mm256_setzero_pd(); }
+		static Vec Load(const double* p) { return _mm256_loadu_pd(p); }
+		static Vec Load(const float* p) { return _mm256_cvtps_pd(_mm_loadu_ps(p)); }
+
+		static Vec LoadPartial(const double* p, uint count)
+		{
+			__m256i mask = _mm256_cmpgt_epi64(_mm256_set1_epi64x(count), _mm256_set_epi64x(3, 2, 1, 0));
+			return _mm256_maskload_pd(p, mask);
+		}
+
+		static Vec LoadPartial(const float* p, uint count)
+		{
+			__m128i mask = _mm_cmpgt_epi32(_mm_set1_epi32(count), _mm_set_epi32(3, 2, 1, 0));
+			return _mm256_cvtps_pd(_mm_maskload_ps(p, mask));
+		}
+
+		static Vec Add(Vec a, Vec b) { return _mm256_add_pd(a, b); }
+		static Vec Sub(Vec a, Vec b) { return _mm256_sub_pd(a, b); }
+		static Vec Mul(Vec a, Vec b) { return _mm256_mul_pd(a, b); }
+		static Vec Div(Vec a, Vec b) { return _mm256_div_pd(a, b); }
+		static Vec Abs(Vec a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+
+		// operands swapped so ties resolve as std::min and std::max do
+		static Vec Min(Vec a, Vec b) { return _mm256_min_pd(b, a); }
+		static Vec Max(Vec a, Vec b) { return _mm256_max_pd(b, a); }
+
+		static Vec SelectNonZero(Vec c, Vec v) { return _mm256_and_pd(_mm256_cmp_pd(c, _mm256_setzero_pd(), _CMP_NEQ_UQ), v); }
+		static Vec SelectPositive(Vec c, Vec v) { return _mm256_and_pd(_mm256_cmp_pd(c, _mm256_setzero_pd(), _CMP_GT_OQ), v); }
+
+		static double Sum(Vec v)
+		{
+			__m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+			return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+		}
+	};
+}
+
+void GetAvx2Kernels(VectorKernelTable<double>& doubleKernels, VectorKernelTable<float>& floatKernels)
+{
+	FillKernelTable<Avx2Isa, double>(doubleKernels);
+	FillKernelTable<Avx2Isa, float>(floatKernels);
+}
+
+#if defined(__clang__)
+	#pragma clang attribute pop
+#elif defined(__GNUC__)
+	#pragma GCC pop_options
+#endif
+
+#endif
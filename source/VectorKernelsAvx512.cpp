@@ -0,0 +1,92 @@
+//=======================================================================
+// Author: Donovan Parks
+//
+// Copyright 2011 Donovan Parks
+//
+// This file is part of ExpressBetaDiversity.
+//
+// ExpressBetaDiversity is free software: you can redistribute it 
+// and/or modify it under the terms of the GNU General Public License 
+// as published by the Free Software Foundation, either version 3 of 
+// the License, or (at your option) any later version.
+//
+// ExpressBetaDiversity is distributed in the hope that it will be 
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ExpressBetaDiversity. If not, see 
+// <http://www.gnu.org/licenses/>.
+//=======================================================================
+
+
+#include "Precompiled.hpp"
+
+#include "VectorKernelsAvx512.hpp"
+
+#ifdef VECTOR_KERNELS_X86
+
+#include <immintrin.h>
+
+// compile the kernels below for AVX-512 regardless of the instruction set targeted by the rest of the program
+#if defined(__clang__)
+	#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+	#pragma GCC push_options
+	#pragma GCC target("avx512f")
+#endif
+
+#include "VectorKernelsImpl.hpp"
+
+namespace
+{
+	struct Avx512Isa
+	{
+		typedef __m512d Vec;
+		enum { WIDTH = 8, UNROLL = 4 };
+
+		static Vec Zero() { return _mm512_setzero_pd(); }
+		static Vec Load(const double* p) { return _mm512_loadu_pd(p); }
+		static Vec Load(const float* p) { return _mm512_cvtps_pd(_mm256_loadu_ps(p)); }
+
+		static Vec LoadPartial(const double* p, uint count)
+		{
+			return _mm512_maskz_loadu_pd((__mmask8)((1u << count) - 1), p);
+		}
+
+		static Vec LoadPartial(const float* p, uint count)
+		{
+			return _mm512_cvtps_pd(_mm512_castps512_ps256(_mm512_maskz_loadu_ps((__mmask16)((1u << count) - 1), p)));
+		}
+
+		static Vec Add(Vec a, Vec b) { return _mm512_add_pd(a, b); }
+		static Vec Sub(Vec a, Vec b) { return _mm512_sub_pd(a, b); }
+		static Vec Mul(Vec a, Vec b) { return _mm512_mul_pd(a, b); }
+		static Vec Div(Vec a, Vec b) { return _mm512_div_pd(a, b); }
+		static Vec Abs(Vec a) { return _mm512_abs_pd(a); }
+
+		// operands swapped so ties resolve as std::min and std::max do
+		static Vec Min(Vec a, Vec b) { return _mm512_min_pd(b, a); }
+		static Vec Max(Vec a, Vec b) { return _mm512_max_pd(b, a); }
+
+		static Vec SelectNonZero(Vec c, Vec v) { return _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(c, _mm512_setzero_pd(), _CMP_NEQ_UQ), v); }
+		static Vec SelectPositive(Vec c, Vec v) { return _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(c, _mm512_setzero_pd(), _CMP_GT_OQ), v); }
+
+		static double Sum(Vec v) { return _mm512_reduce_add_pd(v); }
+	};
+}
+
+void GetAvx512Kernels(VectorKernelTable<double>& doubleKernels, VectorKernelTable<float>& floatKernels)
+{
+	FillKernelTable<Avx512Isa, double>(doubleKernels);
+	FillKernelTable<Avx512Isa, float>(floatKernels);
+}
+
+#if defined(__clang__)
+	#pragma clang attribute pop
+#elif defined(__GNUC__)
+	#pragma GCC pop_options
+#endif
+
+#endif
@@ -0,0 +1,31 @@
+//=======================================================================
+// Author: Donovan Parks
+//
+// Copyright 2011 Donovan Parks
+//
+// This file is part of ExpressBetaDiversity.
+//
+// ExpressBetaDiversity is free software: you can redistribute it 
+// and/or modify it under the terms of the GNU General Public License 
+// as published by the Free Software Foundation, either version 3 of 
+// the License, or (at your option) any later version.
+//
+// ExpressBetaDiversity is distributed in the hope that it will be 
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ExpressBetaDiversity. If not, see 
+// <http://www.gnu.org/licenses/>.
+//=======================================================================
+
+#ifndef _VECTOR_KERNELS_AVX512_
+#define _VECTOR_KERNELS_AVX512_
+
+#include "VectorKernels.hpp"
+
+/** Fill kernel tables with kernels using AVX-512 instructions. Only call if the processor supports AVX-512. */
+void GetAvx512Kernels(VectorKernelTable<double>& doubleKernels, VectorKernelTable<float>& floatKernels);
+
+#endif
@@ -0,0 +1,238 @@
+//=======================================================================
+// Author: Donovan Parks
+//
+// Copyright 2011 Donovan Parks
+//
+// This file is part of ExpressBetaDiversity.
+//
+// ExpressBetaDiversity is free software: you can redistribute it 
+// and/or modify it under the terms of the GNU General Public License 
+// as published by the Free Software Foundation, either version 3 of 
+// the License, or (at your option) any later version.
+//
+// ExpressBetaDiversity is distributed in the hope that it will be 
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ExpressBetaDiversity. If not, see 
+// <http://www.gnu.org/licenses/>.
+//=======================================================================
+
+
+#ifndef _VECTOR_KERNELS_IMPL_
+#define _VECTOR_KERNELS_IMPL_
+
+#include "VectorKernels.hpp"
+
+// Kernels are written once against an instruction set class (Isa) which provides:
+//   Vec                        register holding WIDTH doubles
+//   WIDTH, UNROLL              doubles per register and independent accumulators per sum
+//   Zero, Load, LoadPartial    loads convert float data to double; lanes past count are zero
+//   Add, Sub, Mul, Div, Abs, Min, Max
+//   SelectNonZero(c, v)        v where c != 0, otherwise 0
+//   SelectPositive(c, v)       v where c > 0, otherwise 0
+//   Sum                        horizontal sum of lanes
+//
+// Each instruction set class must have internal linkage and this file must be included after any
+// pragmas enabling the instruction set so the instantiated kernels are compiled for it.
+
+struct BrayCurtisTerms
+{
+	enum { NUM_SUMS = 2, USES_EXTENTS = 0 };
+
+	template<class Isa, class Vec>
+	static void Eval(const Vec& a, const Vec& b, const Vec& w, const Vec& minExtent, const Vec& maxExtent, Vec* terms)
+	{
+		terms[0] = Isa::Mul(Isa::Abs(Isa::Sub(a, b)), w);
+		terms[1] = Isa::Mul(Isa::Add(a, b), w);
+	}
+};
+
+struct CanberraTerms
+{
+	enum { NUM_SUMS = 1, USES_EXTENTS = 0 };
+
+	template<class Isa, class Vec>
+	static void Eval(const Vec& a, const Vec& b, const Vec& w, const Vec& minExtent, const Vec& maxExtent, Vec* terms)
+	{
+		Vec den = Isa::Add(a, b);
+		terms[0] = Isa::Mul(Isa::SelectNonZero(den, Isa::Div(Isa::Abs(Isa::Sub(a, b)), den)), w);
+	}
+};
+
+struct EuclideanTerms
+{
+	enum { NUM_SUMS = 1, USES_EXTENTS = 0 };
+
+	template<class Isa, class Vec>
+	static void Eval(const Vec& a, const Vec& b, const Vec& w, const Vec& minExtent, const Vec& maxExtent, Vec* terms)
+	{
+		Vec d = Isa::Sub(a, b);
+		terms[0] = Isa::Mul(Isa::Mul(w, d), d);
+	}
+};
+
+struct GowerTerms
+{
+	enum { NUM_SUMS = 1, USES_EXTENTS = 1 };
+
+	template<class Isa, class Vec>
+	static void Eval(const Vec& a, const Vec& b, const Vec& w, const Vec& minExtent, const Vec& maxExtent, Vec* terms)
+	{
+		Vec d = Isa::Sub(maxExtent, minExtent);
+		terms[0] = Isa::Mul(Isa::SelectPositive(d, Isa::Div(Isa::Abs(Isa::Sub(a, b)), d)), w);
+	}
+};
+
+struct KulczynskiTerms
+{
+	enum { NUM_SUMS = 1, USES_EXTENTS = 0 };
+
+	template<class Isa, class Vec>
+	static void Eval(const Vec& a, const Vec& b, const Vec& w, const Vec& minExtent, const Vec& maxExtent, Vec* terms)
+	{
+		terms[0] = Isa::Mul(Isa::Min(a, b), w);
+	}
+};
+
+struct LennonCDTerms
+{
+	enum { NUM_SUMS = 3, USES_EXTENTS = 0 };
+
+	template<class Isa, class Vec>
+	static void Eval(const Vec& a, const Vec& b, const Vec& w, const Vec& minExtent, const Vec& maxExtent, Vec* terms)
+	{
+		Vec max = Isa::Max(a, b);
+		terms[0] = Isa::Mul(Isa::Min(a, b), w);
+		terms[1] = Isa::Mul(Isa::Sub(max, b), w);
+		terms[2] = Isa::Mul(Isa::Sub(max, a), w);
+	}
+};
+
+struct ManhattanTerms
+{
+	enum { NUM_SUMS = 1, USES_EXTENTS = 0 };
+
+	template<class Isa, class Vec>
+	static void Eval(const Vec& a, const Vec& b, const Vec& w, const Vec& minExtent, const Vec& maxExtent, Vec* terms)
+	{
+		terms[0] = Isa::Mul(Isa::Abs(Isa::Sub(a, b)), w);
+	}
+};
+
+struct SoergelTerms
+{
+	enum { NUM_SUMS = 2, USES_EXTENTS = 0 };
+
+	template<class Isa, class Vec>
+	static void Eval(const Vec& a, const Vec& b, const Vec& w, const Vec& minExtent, const Vec& maxExtent, Vec* terms)
+	{
+		terms[0] = Isa::Mul(Isa::Abs(Isa::Sub(a, b)), w);
+		terms[1] = Isa::Mul(Isa::Max(a, b), w);
+	}
+};
+
+struct YueClaytonTerms
+{
+	enum { NUM_SUMS = 2, USES_EXTENTS = 0 };
+
+	template<class Isa, class Vec>
+	static void Eval(const Vec& a, const Vec& b, const Vec& w, const Vec& minExtent, const Vec& maxExtent, Vec* terms)
+	{
+		Vec prod = Isa::Mul(a, b);
+		Vec d = Isa::Sub(a, b);
+		terms[0] = Isa::Mul(prod, w);
+		terms[1] = Isa::Mul(Isa::Add(Isa::Mul(d, d), prod), w);
+	}
+};
+
+/** Sum terms over elements [0, n) using UNROLL independent accumulators for each sum. */
+template<class Isa, class Terms, class T>
+void SumTerms(const T* com1, const T* com2, const T* branchWeight, const double* minExtent, const double* maxExtent, uint n, double* sums)
+{
+	typedef typename Isa::Vec Vec;
+
+	Vec acc[Isa::UNROLL][Terms::NUM_SUMS];
+	Vec terms[Terms::NUM_SUMS];
+	Vec minExt = Isa::Zero();
+	Vec maxExt = Isa::Zero();
+
+	for(uint u = 0; u < Isa::UNROLL; ++u)
+	{
+		for(uint s = 0; s < Terms::NUM_SUMS; ++s)
+			acc[u][s] = Isa::Zero();
+	}
+
+	uint i = 0;
+	for(; i + Isa::UNROLL*Isa::WIDTH <= n; i += Isa::UNROLL*Isa::WIDTH)
+	{
+		for(uint u = 0; u < Isa::UNROLL; ++u)
+		{
+			uint e = i + u*Isa::WIDTH;
+			if(Terms::USES_EXTENTS)
+			{
+				minExt = Isa::Load(minExtent + e);
+				maxExt = Isa::Load(maxExtent + e);
+			}
+
+			Terms::template Eval<Isa, Vec>(Isa::Load(com1 + e), Isa::Load(com2 + e), Isa::Load(branchWeight + e), minExt, maxExt, terms);
+			for(uint s = 0; s < Terms::NUM_SUMS; ++s)
+				acc[u][s] = Isa::Add(acc[u][s], terms[s]);
+		}
+	}
+
+	for(; i + Isa::WIDTH <= n; i += Isa::WIDTH)
+	{
+		if(Terms::USES_EXTENTS)
+		{
+			minExt = Isa::Load(minExtent + i);
+			maxExt = Isa::Load(maxExtent + i);
+		}
+
+		Terms::template Eval<Isa, Vec>(Isa::Load(com1 + i), Isa::Load(com2 + i), Isa::Load(branchWeight + i), minExt, maxExt, terms);
+		for(uint s = 0; s < Terms::NUM_SUMS; ++s)
+			acc[0][s] = Isa::Add(acc[0][s], terms[s]);
+	}
+
+	if(i < n)
+	{
+		// zero lanes past the end of the vectors give zero terms
+		uint count = n - i;
+		if(Terms::USES_EXTENTS)
+		{
+			minExt = Isa::LoadPartial(minExtent + i, count);
+			maxExt = Isa::LoadPartial(maxExtent + i, count);
+		}
+
+		Terms::template Eval<Isa, Vec>(Isa::LoadPartial(com1 + i, count), Isa::LoadPartial(com2 + i, count), Isa::LoadPartial(branchWeight + i, count), minExt, maxExt, terms);
+		for(uint s = 0; s < Terms::NUM_SUMS; ++s)
+			acc[0][s] = Isa::Add(acc[0][s], terms[s]);
+	}
+
+	for(uint s = 0; s < Terms::NUM_SUMS; ++s)
+	{
+		for(uint u = 1; u < Isa::UNROLL; ++u)
+			acc[0][s] = Isa::Add(acc[0][s], acc[u][s]);
+
+		sums[s] = Isa::Sum(acc[0][s]);
+	}
+}
+
+/** Fill kernel table with kernels for data vectors of type T. */
+template<class Isa, class T>
+void FillKernelTable(VectorKernelTable<T>& kernels)
+{
+	kernels.brayCurtis = SumTerms<Isa, BrayCurtisTerms, T>;
+	kernels.canberra = SumTerms<Isa, CanberraTerms, T>;
+	kernels.euclidean = SumTerms<Isa, EuclideanTerms, T>;
+	kernels.gower = SumTerms<Isa, GowerTerms, T>;
+	kernels.kulczynski = SumTerms<Isa, KulczynskiTerms, T>;
+	kernels.lennonCD = SumTerms<Isa, LennonCDTerms, T>;
+	kernels.manhattan = SumTerms<Isa, ManhattanTerms, T>;
+	kernels.soergel = SumTerms<Isa, SoergelTerms, T>;
+	kernels.yueClayton = SumTerms<Isa, YueClaytonTerms, T>;
+}
+
+#endif